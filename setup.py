@@ -8,6 +8,18 @@ import sys
 # Set this to false to dynamically link the ILM libraries.
 static_link_ilmbase = True
 
+# Set this to true to record per-function call counts and timings (see pimath.stats()).
+enable_stats = False
+
+# Set this to true to handle arithmetic between vectors, matrices and quats of the same
+# type directly in the number slots, bypassing boost.python's overload resolution.
+enable_number_slots = False
+
+# Set this to true or false to force OpenMP on or off. By default it's used if the
+# compiler can build a test program with it (Apple's clang can't, for example). Without
+# it the bulk kernels run on one thread.
+enable_openmp = None
+
 if sys.platform == "win32" :
     include_dirs = ["C:/Boost/include/boost-1_32","."]
     libraries=["boost_python-mgw"]
@@ -32,7 +44,50 @@ files = ["src/cpp/bindings.cpp","src/cpp/boxAlgo.cpp","src/cpp/box.cpp",
          "src/cpp/matrixAlgo.cpp","src/cpp/plane.cpp","src/cpp/quat.cpp",
          "src/cpp/random.cpp","src/cpp/roots.cpp","src/cpp/shear.cpp",
          "src/cpp/sphere.cpp","src/cpp/vec2.cpp","src/cpp/vec3.cpp",
-         "src/cpp/vec4.cpp","src/cpp/vecAlgo.cpp"]
+         "src/cpp/vec4.cpp","src/cpp/vecAlgo.cpp","src/cpp/colorArray.cpp",
+         "src/cpp/instancePool.cpp","src/cpp/stats.cpp","src/cpp/dispatch.cpp",
+         "src/cpp/sequenceSlots.cpp","src/cpp/fastcall.cpp","src/cpp/family.cpp",
+         "src/cpp/simd.cpp","src/cpp/vecArray.cpp","src/cpp/capi.cpp",
+         "src/cpp/threads.cpp","src/cpp/kdTree.cpp","src/cpp/hashGrid.cpp",
+         "src/cpp/octree.cpp"]
+
+define_macros=[("BOOST_PYTHON_MAX_ARITY","17")]
+if enable_stats == True:
+    define_macros.append(("PIMATH_STATS","1"))
+if enable_number_slots == True:
+    define_macros.append(("PIMATH_NUMBER_SLOTS","1"))
+
+def have_openmp():
+    import shutil, tempfile
+    from distutils.ccompiler import new_compiler
+    from distutils.sysconfig import customize_compiler
+    from distutils.errors import CompileError, LinkError
+    tmp = tempfile.mkdtemp()
+    try:
+        src = os.path.join(tmp, "openmp.c")
+        f = open(src, "w")
+        f.write("#include <omp.h>\nint main() { return omp_get_max_threads() > 0 ? 0 : 1; }\n")
+        f.close()
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        try:
+            objects = compiler.compile([src], output_dir=tmp, extra_postargs=["-fopenmp"])
+            compiler.link_executable(objects, os.path.join(tmp, "openmp"),
+                                     extra_postargs=["-fopenmp"])
+        except (CompileError, LinkError):
+            return False
+        return True
+    finally:
+        shutil.rmtree(tmp)
+
+if enable_openmp == None:
+    enable_openmp = have_openmp()
+
+extra_compile_args=[]
+extra_link_args=[]
+if enable_openmp == True:
+    extra_compile_args.append("-fopenmp")
+    extra_link_args.append("-fopenmp")
 
 extra_objects=[]
 if static_link_ilmbase == True:
@@ -46,9 +101,10 @@ setup(name="pimath",
                     library_dirs=library_dirs,
                     libraries=libraries,
                     include_dirs=include_dirs,
-                    define_macros=[("BOOST_PYTHON_MAX_ARITY","17")],
+                    define_macros=define_macros,
                     depends=[],
                     extra_objects=extra_objects,
-                    extra_link_args=[]),
+                    extra_compile_args=extra_compile_args,
+                    extra_link_args=extra_link_args),
                     ]
      )
\ No newline at end of file
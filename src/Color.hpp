@@ -33,6 +33,9 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <ImathMatrix.h>
 #include <ImathColor.h>
 #include "util.h"
+#include "sequence_slots.hpp"
+#include "components.hpp"
+#include "family.hpp"
 
 
 namespace pimath
@@ -41,7 +44,7 @@ namespace pimath
 
 	// Color3 uses the Vec3 binding as it has an identical interface.
 
-	// templatised bindings
+	// templatised bindings, for the color's own scalar type
 	template<typename Color>
 	struct Color3Bind_T
 	{
@@ -68,6 +71,7 @@ namespace pimath
 		typedef typename color_type::BaseType 	scalar_type;
 		typedef Imath::Vec3<scalar_type>		vec_type;
 		typedef bp::class_<color_type, bp::bases<vec_type> > 	bp_class;
+		typedef SequenceSlots<color_type, 3, &scalarItem<color_type> > 	sequence_slots;
 
 		Color3Bind( const char * name )
 		{
@@ -78,7 +82,17 @@ namespace pimath
 				.def(bp::init<scalar_type, scalar_type, scalar_type>())
 				.def("__init__", bp::make_constructor(sequenceInit));
 
-			boost::mpl::for_each<ScalarTypes>(Color3Bind_T<color_type>(cl));
+			bindSequenceSlots<sequence_slots>(cl, "Vector index out of range.");
+
+			// a Vec3 of any scalar type, then the native overload for the color's own
+			cl.def("__init__", bp::make_constructor(familyInit));
+			Color3Bind_T<color_type> native(cl);
+			native(scalar_type());
+		}
+
+		static color_type* familyInit(const FamilyValue<Imath::V3d>& v)
+		{
+			return new color_type(v.value);
 		}
 
 		static color_type* defaultInit()
@@ -104,7 +118,7 @@ namespace pimath
 	// Color4, however, needs a unique interface:
 
 
-	// templatised bindings
+	// templatised bindings, for the color's own scalar type
 	template<typename Color>
 	struct Color4Bind_T
 	{
@@ -129,6 +143,8 @@ namespace pimath
 		typedef Color							color_type;
 		typedef typename color_type::BaseType 	scalar_type;
 		typedef bp::class_<color_type> 			bp_class;
+		typedef OutArgOps<color_type, scalar_type> 	out_ops;
+		typedef SequenceSlots<color_type, 4, &scalarItem<color_type> > 	sequence_slots;
 
 		ColorBind(const char* name)
 		{
@@ -162,20 +178,37 @@ namespace pimath
 			.def("dimensions", &color_type::dimensions)
 			.staticmethod("dimensions")
 
-			// note: due to def_readwrite() not supporting custom to-python converters
-			.add_property("r", bp::make_getter(&color_type::r, bp_ret_val()),
-				bp::make_setter(&color_type::r))
-			.add_property("g", bp::make_getter(&color_type::g, bp_ret_val()),
-				bp::make_setter(&color_type::g))
-			.add_property("b", bp::make_getter(&color_type::b, bp_ret_val()),
-				bp::make_setter(&color_type::b))
-			.add_property("a", bp::make_getter(&color_type::a, bp_ret_val()),
-				bp::make_setter(&color_type::a))
+			.def("add", &out_ops::add, out_args())
+			.def("subtract", &out_ops::subtract, out_args())
+			.def("multiply", &out_ops::multiply, out_args())
+			.def("multiply", &out_ops::multiplyScalar, out_args())
+			.def("divide", &out_ops::divide, out_args())
+			.def("divide", &out_ops::divideScalar, out_args())
+			.staticmethod("add")
+			.staticmethod("subtract")
+			.staticmethod("multiply")
+			.staticmethod("divide")
 			;
 
+			bindComponent<color_type, scalar_type, &color_type::r>(cl, "r");
+			bindComponent<color_type, scalar_type, &color_type::g>(cl, "g");
+			bindComponent<color_type, scalar_type, &color_type::b>(cl, "b");
+			bindComponent<color_type, scalar_type, &color_type::a>(cl, "a");
+
 			bindBaseType<bp_class, color_type>(cl);
+			bindSequenceSlots<sequence_slots>(cl, "Vector index out of range.");
 
-			boost::mpl::for_each<ScalarTypes>(Color4Bind_T<color_type>(cl));
+
+			// any scalar type, then the native overload for the color's own
+			bindFamilyMember<color_type>(cl);
+			cl.def("__init__", bp::make_constructor(familyInit));
+			Color4Bind_T<color_type> native(cl);
+			native(scalar_type());
+		}
+
+		static color_type* familyInit(const FamilyValue<Imath::Color4<double> >& c)
+		{
+			return new color_type(c.value);
 		}
 
 		static color_type* defaultInit() {
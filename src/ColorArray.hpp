@@ -0,0 +1,614 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_COLORARRAY__H_
+#define _PIMATH_COLORARRAY__H_
+
+/*
+ * C4cArray, C4hArray and C4fArray are not part of Imath. Each holds a width x height
+ * plane of Color4 pixels, stored in one of two layouts:
+ * InterleavedLayout: rgba rgba rgba ...
+ * PlanarLayout:      rrr... ggg... bbb... aaa...
+ * The layout can be changed at any time via the 'layout' property.
+ *
+ * The [] operator takes either an integer (pixels are numbered in scanline order) or
+ * an (x,y) pair, and returns a copy of that pixel.
+ *
+ * premultiply, unpremultiply, swizzle and scaleOffset modify the array in place (in the
+ * same way as Color4::negate), while 'over' returns a new array: fg.over(bg). Both
+ * arrays are assumed to be premultiplied. Alpha is treated as 0-255 for C4cArray, and
+ * 0-1 otherwise.
+ *
+ * Converting between array types takes an optional scale, which is applied during the
+ * conversion - eg C4fArray(c4cArray, 1.0/255). Conversion to C4cArray clamps to 0-255.
+ */
+
+#include <ImathColor.h>
+#include <ImathHalfLimits.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "kernels/simd.hpp"
+#include "util.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	enum ArrayLayout
+	{
+		InterleavedLayout,
+		PlanarLayout
+	};
+
+
+	// per-channel conversion to and from float
+	template<typename T>
+	struct ColorChannelTraits
+	{
+		static float one() 				{ return 1.0f; }
+		static T fromFloat(float f) 	{ return T(f); }
+	};
+
+	template<>
+	struct ColorChannelTraits<unsigned char>
+	{
+		static float one() 				{ return 255.0f; }
+		static unsigned char fromFloat(float f)
+		{
+			if(!(f > 0.0f))
+				return 0;
+			return (f >= 255.0f)? 255 : static_cast<unsigned char>(f + 0.5f);
+		}
+	};
+
+
+	// flat channel conversion, dst[i] = src[i] * scale
+	template<typename S, typename T>
+	inline void convertChannels(const S* src, T* dst, std::size_t n, float scale)
+	{
+		for(std::size_t i=0; i<n; ++i)
+			dst[i] = ColorChannelTraits<T>::fromFloat(static_cast<float>(src[i]) * scale);
+	}
+
+	inline void convertChannels(const unsigned char* src, float* dst, std::size_t n, float scale)
+	{
+		std::size_t i = 0;
+#if defined(__SSE2__)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 s = _mm_set1_ps(scale);
+		for(; i+16<=n; i+=16)
+		{
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			_mm_storeu_ps(dst+i,    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), s));
+			_mm_storeu_ps(dst+i+4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s));
+			_mm_storeu_ps(dst+i+8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s));
+			_mm_storeu_ps(dst+i+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s));
+		}
+#endif
+		for(; i<n; ++i)
+			dst[i] = static_cast<float>(src[i]) * scale;
+	}
+
+	inline void convertChannels(const float* src, unsigned char* dst, std::size_t n, float scale)
+	{
+		std::size_t i = 0;
+#if defined(__SSE2__)
+		const __m128 s = _mm_set1_ps(scale);
+		const __m128 lo = _mm_setzero_ps();
+		const __m128 hi = _mm_set1_ps(255.0f);
+		const __m128 bias = _mm_set1_ps(0.5f);
+		for(; i+16<=n; i+=16)
+		{
+			// max() first, so that NaNs become zero as in the scalar path, then round half up
+			// by adding 0.5 and truncating, as fromFloat does (cvtps would round half to even)
+			__m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i),    s), lo), hi), bias));
+			__m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4),  s), lo), hi), bias));
+			__m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+8),  s), lo), hi), bias));
+			__m128i d = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+12), s), lo), hi), bias));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),
+				_mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+		}
+#endif
+		for(; i<n; ++i)
+			dst[i] = ColorChannelTraits<unsigned char>::fromFloat(src[i] * scale);
+	}
+
+	// half conversions use F16C where available (see kernels/simd.hpp)
+	inline void convertChannels(const half* src, float* dst, std::size_t n, float scale) {
+		kernels::halfToFloat(src, dst, n, scale);
+	}
+
+	inline void convertChannels(const float* src, half* dst, std::size_t n, float scale) {
+		kernels::floatToHalf(src, dst, n, scale);
+	}
+
+	inline void convertChannels(const float* src, float* dst, std::size_t n, float scale)
+	{
+		for(std::size_t i=0; i<n; ++i)
+			dst[i] = src[i] * scale;
+	}
+
+
+	// A width x height plane of Color4 pixels
+	template<typename T>
+	class Color4Array
+	{
+	public:
+
+		typedef T 						scalar_type;
+		typedef Imath::Color4<T> 		color_type;
+
+		Color4Array(unsigned int width, unsigned int height, ArrayLayout layout = InterleavedLayout)
+		:	m_width(width),
+			m_height(height),
+			m_layout(layout),
+			m_data(std::size_t(width)*height*4, T(0))
+		{}
+
+		template<typename S>
+		Color4Array(const Color4Array<S>& src, float scale)
+		:	m_width(src.width()),
+			m_height(src.height()),
+			m_layout(src.layout()),
+			m_data(src.data().size())
+		{
+			// both arrays share a layout, so this is a flat conversion
+			if(!m_data.empty())
+				convertChannels(&src.data()[0], &m_data[0], m_data.size(), scale);
+		}
+
+		unsigned int width() const 					{ return m_width; }
+		unsigned int height() const 				{ return m_height; }
+		std::size_t size() const 					{ return std::size_t(m_width)*m_height; }
+		ArrayLayout layout() const 					{ return m_layout; }
+		const std::vector<T>& data() const 			{ return m_data; }
+
+		// distance between consecutive pixels within one channel
+		std::size_t stride() const 					{ return (m_layout == PlanarLayout)? 1 : 4; }
+
+		T* channel(int c)
+		{
+			return m_data.empty()? 0 :
+				&m_data[(m_layout == PlanarLayout)? c*size() : c];
+		}
+
+		const T* channel(int c) const {
+			return const_cast<Color4Array*>(this)->channel(c);
+		}
+
+		color_type get(std::size_t i) const
+		{
+			const std::size_t j = i*stride();
+			return color_type(channel(0)[j], channel(1)[j], channel(2)[j], channel(3)[j]);
+		}
+
+		void set(std::size_t i, const color_type& c)
+		{
+			const std::size_t j = i*stride();
+			channel(0)[j] = c.r;
+			channel(1)[j] = c.g;
+			channel(2)[j] = c.b;
+			channel(3)[j] = c.a;
+		}
+
+		void setLayout(ArrayLayout layout)
+		{
+			if(layout == m_layout)
+				return;
+
+			const std::size_t n = size();
+			std::vector<T> data(m_data.size());
+			for(std::size_t i=0; i<n; ++i)
+			{
+				for(int c=0; c<4; ++c)
+				{
+					if(layout == PlanarLayout)
+						data[c*n+i] = m_data[i*4+c];
+					else
+						data[i*4+c] = m_data[c*n+i];
+				}
+			}
+
+			m_data.swap(data);
+			m_layout = layout;
+		}
+
+	protected:
+
+		unsigned int m_width;
+		unsigned int m_height;
+		ArrayLayout m_layout;
+		std::vector<T> m_data;
+	};
+
+
+	// Compositing kernels. These work on any layout; the float specialisations below
+	// add SSE paths for the common cases.
+	template<typename T>
+	struct Color4ArrayKernels
+	{
+		typedef Color4Array<T> 				array_type;
+		typedef ColorChannelTraits<T> 		channel_traits;
+
+		static void premultiply(array_type& img)
+		{
+			const std::size_t n = img.size(), s = img.stride();
+			const float inv = 1.0f / channel_traits::one();
+			T *r = img.channel(0), *g = img.channel(1), *b = img.channel(2), *a = img.channel(3);
+
+			for(std::size_t i=0, j=0; i<n; ++i, j+=s)
+			{
+				float k = static_cast<float>(a[j]) * inv;
+				r[j] = channel_traits::fromFloat(static_cast<float>(r[j]) * k);
+				g[j] = channel_traits::fromFloat(static_cast<float>(g[j]) * k);
+				b[j] = channel_traits::fromFloat(static_cast<float>(b[j]) * k);
+			}
+		}
+
+		static void unpremultiply(array_type& img)
+		{
+			const std::size_t n = img.size(), s = img.stride();
+			T *r = img.channel(0), *g = img.channel(1), *b = img.channel(2), *a = img.channel(3);
+
+			for(std::size_t i=0, j=0; i<n; ++i, j+=s)
+			{
+				float alpha = static_cast<float>(a[j]);
+				if(alpha == 0.0f)
+					continue;
+
+				float k = channel_traits::one() / alpha;
+				r[j] = channel_traits::fromFloat(static_cast<float>(r[j]) * k);
+				g[j] = channel_traits::fromFloat(static_cast<float>(g[j]) * k);
+				b[j] = channel_traits::fromFloat(static_cast<float>(b[j]) * k);
+			}
+		}
+
+		// result = fg + bg * (1 - fg.a), written into 'fg'
+		static void over(array_type& fg, const array_type& bg)
+		{
+			const std::size_t n = fg.size(), sf = fg.stride(), sb = bg.stride();
+			const float inv = 1.0f / channel_traits::one();
+			T* f[4] = { fg.channel(0), fg.channel(1), fg.channel(2), fg.channel(3) };
+			const T* b[4] = { bg.channel(0), bg.channel(1), bg.channel(2), bg.channel(3) };
+
+			for(std::size_t i=0, jf=0, jb=0; i<n; ++i, jf+=sf, jb+=sb)
+			{
+				float k = 1.0f - static_cast<float>(f[3][jf]) * inv;
+				for(int c=0; c<4; ++c)
+					f[c][jf] = channel_traits::fromFloat(static_cast<float>(f[c][jf]) +
+						static_cast<float>(b[c][jb]) * k);
+			}
+		}
+
+		static void scaleOffset(array_type& img, const float* scale, const float* offset)
+		{
+			const std::size_t n = img.size(), s = img.stride();
+			for(int c=0; c<4; ++c)
+			{
+				T* p = img.channel(c);
+				for(std::size_t i=0, j=0; i<n; ++i, j+=s)
+					p[j] = channel_traits::fromFloat(static_cast<float>(p[j]) * scale[c] + offset[c]);
+			}
+		}
+
+		// 'order' holds 4 source channel indices; 4 means zero, 5 means one.
+		static void swizzle(array_type& img, const int* order)
+		{
+			const std::size_t n = img.size(), s = img.stride();
+			T* p[4] = { img.channel(0), img.channel(1), img.channel(2), img.channel(3) };
+			T v[6];
+			v[4] = T(0);
+			v[5] = channel_traits::fromFloat(channel_traits::one());
+
+			for(std::size_t i=0, j=0; i<n; ++i, j+=s)
+			{
+				for(int c=0; c<4; ++c)
+					v[c] = p[c][j];
+				for(int c=0; c<4; ++c)
+					p[c][j] = v[order[c]];
+			}
+		}
+	};
+
+
+#if defined(__SSE2__)
+	template<>
+	inline void Color4ArrayKernels<float>::premultiply(array_type& img)
+	{
+		const std::size_t n = img.size();
+		std::size_t i = 0;
+
+		if(img.layout() == PlanarLayout)
+		{
+			float *r = img.channel(0), *g = img.channel(1), *b = img.channel(2), *a = img.channel(3);
+			for(; i+4<=n; i+=4)
+			{
+				__m128 k = _mm_loadu_ps(a+i);
+				_mm_storeu_ps(r+i, _mm_mul_ps(_mm_loadu_ps(r+i), k));
+				_mm_storeu_ps(g+i, _mm_mul_ps(_mm_loadu_ps(g+i), k));
+				_mm_storeu_ps(b+i, _mm_mul_ps(_mm_loadu_ps(b+i), k));
+			}
+			for(; i<n; ++i)
+			{
+				r[i] *= a[i];
+				g[i] *= a[i];
+				b[i] *= a[i];
+			}
+		}
+		else
+		{
+			// one pixel per register; the alpha lane is multiplied by 1
+			float* p = img.channel(0);
+			const __m128 one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+			const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+			for(; i<n; ++i)
+			{
+				__m128 v = _mm_loadu_ps(p+i*4);
+				__m128 k = _mm_or_ps(_mm_and_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)), rgbMask), one);
+				_mm_storeu_ps(p+i*4, _mm_mul_ps(v, k));
+			}
+		}
+	}
+
+	template<>
+	inline void Color4ArrayKernels<float>::unpremultiply(array_type& img)
+	{
+		const std::size_t n = img.size();
+		const __m128 zero = _mm_setzero_ps();
+		std::size_t i = 0;
+
+		if(img.layout() == PlanarLayout)
+		{
+			float *r = img.channel(0), *g = img.channel(1), *b = img.channel(2), *a = img.channel(3);
+			for(; i+4<=n; i+=4)
+			{
+				__m128 alpha = _mm_loadu_ps(a+i);
+				__m128 mask = _mm_cmpneq_ps(alpha, zero);
+				__m128 k = _mm_div_ps(_mm_set1_ps(1.0f), alpha);
+				float* ch[3] = { r+i, g+i, b+i };
+				for(int c=0; c<3; ++c)
+				{
+					__m128 v = _mm_loadu_ps(ch[c]);
+					_mm_storeu_ps(ch[c], _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(v, k)),
+						_mm_andnot_ps(mask, v)));
+				}
+			}
+			for(; i<n; ++i)
+			{
+				if(a[i] == 0.0f)
+					continue;
+				float k = 1.0f / a[i];
+				r[i] *= k;
+				g[i] *= k;
+				b[i] *= k;
+			}
+		}
+		else
+		{
+			float* p = img.channel(0);
+			const __m128 one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+			const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+			for(; i<n; ++i)
+			{
+				if(p[i*4+3] == 0.0f)
+					continue;
+				__m128 v = _mm_loadu_ps(p+i*4);
+				__m128 k = _mm_div_ps(_mm_set1_ps(1.0f), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)));
+				k = _mm_or_ps(_mm_and_ps(k, rgbMask), one);
+				_mm_storeu_ps(p+i*4, _mm_mul_ps(v, k));
+			}
+		}
+	}
+
+	template<>
+	inline void Color4ArrayKernels<float>::over(array_type& fg, const array_type& bg)
+	{
+		const std::size_t n = fg.size();
+		const __m128 one = _mm_set1_ps(1.0f);
+		std::size_t i = 0;
+
+		if(fg.layout() != bg.layout())
+		{
+			for(std::size_t jf=0, jb=0; i<n; ++i, jf+=fg.stride(), jb+=bg.stride())
+			{
+				float k = 1.0f - fg.channel(3)[jf];
+				for(int c=0; c<4; ++c)
+					fg.channel(c)[jf] += bg.channel(c)[jb] * k;
+			}
+		}
+		else if(fg.layout() == PlanarLayout)
+		{
+			float* f[4] = { fg.channel(0), fg.channel(1), fg.channel(2), fg.channel(3) };
+			const float* b[4] = { bg.channel(0), bg.channel(1), bg.channel(2), bg.channel(3) };
+			for(; i+4<=n; i+=4)
+			{
+				__m128 k = _mm_sub_ps(one, _mm_loadu_ps(f[3]+i));
+				for(int c=0; c<4; ++c)
+					_mm_storeu_ps(f[c]+i, _mm_add_ps(_mm_loadu_ps(f[c]+i),
+						_mm_mul_ps(_mm_loadu_ps(b[c]+i), k)));
+			}
+			for(; i<n; ++i)
+			{
+				float k = 1.0f - f[3][i];
+				for(int c=0; c<4; ++c)
+					f[c][i] += b[c][i] * k;
+			}
+		}
+		else
+		{
+			float* f = fg.channel(0);
+			const float* b = bg.channel(0);
+			for(; i<n; ++i)
+			{
+				__m128 v = _mm_loadu_ps(f+i*4);
+				__m128 k = _mm_sub_ps(one, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)));
+				_mm_storeu_ps(f+i*4, _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(b+i*4), k)));
+			}
+		}
+	}
+#endif
+
+
+	// templatised bindings
+	template<typename Array>
+	struct Color4ArrayBind_T
+	{
+		typedef Array 						array_type;
+		typedef bp::class_<array_type> 		bp_class;
+
+		template<typename S>
+		void operator()(S)
+		{
+			m_cl
+			.def("__init__", bp::make_constructor(convertInit<S>))
+			.def("__init__", bp::make_constructor(convertInit_<S>))
+			;
+		}
+
+		template<typename S>
+		static array_type* convertInit(const Color4Array<S>& src, float scale) {
+			return new array_type(src, scale);
+		}
+
+		template<typename S>
+		static array_type* convertInit_(const Color4Array<S>& src) {
+			return new array_type(src, 1.0f);
+		}
+
+		Color4ArrayBind_T(bp_class& cl):m_cl(cl){}
+		bp_class m_cl;
+	};
+
+
+	// common bindings
+	template<typename T, typename ScalarTypes>
+	struct Color4ArrayBind
+	{
+		typedef T 								scalar_type;
+		typedef Color4Array<T> 					array_type;
+		typedef Imath::Color4<T> 				color_type;
+		typedef Color4ArrayKernels<T> 			kernels;
+		typedef bp::class_<array_type> 			bp_class;
+
+		Color4ArrayBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<unsigned int, unsigned int, bp::optional<ArrayLayout> >())
+			.def("__len__", &array_type::size)
+			.def("__getitem__", getItem)
+			.def("__setitem__", setItem)
+			.add_property("width", &array_type::width)
+			.add_property("height", &array_type::height)
+			.add_property("layout", &array_type::layout, &array_type::setLayout)
+			.def("premultiply", &kernels::premultiply)
+			.def("unpremultiply", &kernels::unpremultiply)
+			.def("over", over)
+			.def("swizzle", swizzle)
+			.def("scaleOffset", scaleOffset)
+			;
+
+			boost::mpl::for_each<ScalarTypes>(Color4ArrayBind_T<array_type>(cl));
+		}
+
+		static std::size_t index(const array_type& self, const bp::object& index)
+		{
+			bp::extract<int> getint(index);
+			if(getint.check())
+			{
+				int i = getint();
+				if((i<0) || (i>=(int)self.size()))
+					PIMATH_THROW(PyExc_IndexError, "Color4 array index out of range.");
+				return i;
+			}
+			else if(bp::len(index) == 2)
+			{
+				int x = bp::extract<int>(index[0]);
+				int y = bp::extract<int>(index[1]);
+				if(	(x<0) || (x>=(int)self.width()) ||
+					(y<0) || (y>=(int)self.height()))
+					PIMATH_THROW(PyExc_IndexError, "Color4 array index out of range.");
+				return std::size_t(y)*self.width() + x;
+			}
+
+			PIMATH_THROW(PyExc_KeyError, "Only integer and 2-tuple indexing supported on Color4 arrays");
+			return 0;
+		}
+
+		static color_type getItem(const array_type& self, const bp::object& i) {
+			return self.get(index(self, i));
+		}
+
+		static void setItem(array_type& self, const bp::object& i, const color_type& c) {
+			self.set(index(self, i), c);
+		}
+
+		static array_type over(const array_type& self, const array_type& bg)
+		{
+			if((self.width() != bg.width()) || (self.height() != bg.height()))
+				PIMATH_THROW(PyExc_ValueError, "Color4 arrays must be the same size.");
+
+			array_type result(self);
+			kernels::over(result, bg);
+			return result;
+		}
+
+		static void swizzle(array_type& self, const std::string& order)
+		{
+			static const std::string channels("rgba01");
+
+			if(order.size() != 4)
+				PIMATH_THROW(PyExc_ValueError, "Swizzle order must be 4 characters from 'rgba01'.");
+
+			int o[4];
+			for(int c=0; c<4; ++c)
+			{
+				std::size_t pos = channels.find(order[c]);
+				if(pos == std::string::npos)
+					PIMATH_THROW(PyExc_ValueError, "Swizzle order must be 4 characters from 'rgba01'.");
+				o[c] = static_cast<int>(pos);
+			}
+
+			kernels::swizzle(self, o);
+		}
+
+		static void scaleOffset(array_type& self, const Imath::C4f& scale, const Imath::C4f& offset) {
+			kernels::scaleOffset(self, &scale.r, &offset.r);
+		}
+	};
+}
+
+#endif
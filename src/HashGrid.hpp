@@ -0,0 +1,165 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_HASHGRID__H_
+#define _PIMATH_HASHGRID__H_
+
+/*
+ * HashGrid3f is not part of Imath. It indexes a V3fArray in a uniform grid, for radius
+ * queries over points which move every frame, and wraps kernels::HashGrid. Cells are
+ * bounds.size() / resolution in size, starting at bounds.min; points outside the bounds
+ * are indexed too. Indices are into the array the grid was last built from:
+ * HashGrid3f(bounds, resolution[, points]) 	a grid with Box3f bounds and V3i resolution
+ * build(points) 		re-indexes a V3fArray, in parallel and without the GIL, reusing
+ * 						the grid's storage
+ * cellSize() 			returns the V3f size of a cell
+ * cellOf(p) 			returns the V3i cell containing p
+ * cell(c) 				returns an IntArray of the points in cell c
+ * radius(p, r) 		returns an IntArray of the points within r of p
+ * pairs(r) 			returns two IntArrays (i, j), holding each pair of points no more
+ * 						than r apart, i < j
+ *
+ * Using a grid from another python thread while it is being built raises RuntimeError.
+ */
+
+#include <vector>
+#include "kernels/hashgrid.hpp"
+#include "VecArray.hpp"
+
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	// the bound grid, with a BusyGuard counter for its GIL-free build
+	template<typename T>
+	struct GuardedHashGrid : public kernels::HashGrid<T>
+	{
+		typedef kernels::HashGrid<T> grid_type;
+
+		GuardedHashGrid(const typename grid_type::box_type& bounds,
+			const typename grid_type::cell_type& resolution)
+		:	grid_type(bounds, resolution), busy(0) {}
+
+		int busy;
+	};
+
+
+	template<typename T>
+	struct HashGridBind
+	{
+		typedef GuardedHashGrid<T> 						grid_type;
+		typedef typename grid_type::box_type 			box_type;
+		typedef typename grid_type::cell_type 			cell_type;
+		typedef typename grid_type::pair_type 			pair_type;
+		typedef Imath::Vec3<T> 							vec_type;
+		typedef Vec3Array<T> 							array_type;
+		typedef ValueArray<int> 						index_array_type;
+		typedef bp::class_<grid_type, boost::noncopyable> 	bp_class;
+
+		HashGridBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<box_type, cell_type>())
+			.def("__init__", bp::make_constructor(pointsInit))
+			.def("__len__", size)
+			.def("build", build)
+			.def("cellSize", &grid_type::cellSize, bp::return_value_policy<bp::copy_const_reference>())
+			.def("cellOf", &grid_type::cellOf)
+			.def("cell", cell)
+			.def("radius", radius)
+			.def("pairs", pairs)
+			;
+		}
+
+		static grid_type* pointsInit(const box_type& bounds, const cell_type& resolution,
+			const array_type& points)
+		{
+			grid_type* grid = new grid_type(bounds, resolution);
+			build(*grid, points);
+			return grid;
+		}
+
+		static void build(grid_type& self, const array_type& points)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Write);
+			ReleaseGIL nogil;
+			self.build(points.data(), points.size());
+		}
+
+		static std::size_t size(grid_type& self)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Read);
+			return self.size();
+		}
+
+		static index_array_type toArray(std::vector<int>& v)
+		{
+			index_array_type result;
+			result.swap(v);
+			return result;
+		}
+
+		static index_array_type cell(grid_type& self, const cell_type& c)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Read);
+			std::vector<int> found;
+			self.cell(c, found);
+			return toArray(found);
+		}
+
+		static index_array_type radius(grid_type& self, const vec_type& p, T r)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Read);
+			std::vector<int> found;
+			self.radius(p, r, found);
+			return toArray(found);
+		}
+
+		static bp::tuple pairs(grid_type& self, T r)
+		{
+			std::vector<pair_type> found;
+			{
+				BusyGuard guard(self.busy, BusyGuard::Read);
+				ReleaseGIL nogil;
+				self.pairs(r, found);
+			}
+
+			index_array_type first(found.size()), second(found.size());
+			for(std::size_t i=0; i<found.size(); ++i)
+			{
+				first.set(i, found[i].first);
+				second.set(i, found[i].second);
+			}
+			return bp::make_tuple(first, second);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KDTREE__H_
+#define _PIMATH_KDTREE__H_
+
+/*
+ * KdTree3f and KdTree3d are not part of Imath. They index a V3fArray (V3dArray) for
+ * nearest-neighbour queries, and are wrappers over kernels::KdTree. The tree holds its
+ * own copy of the points, so later changes to the array don't affect it. Indices are
+ * into the array the tree was built from, and distances are not squared:
+ * KdTree3f(points[, leafSize]) 	builds the tree, in parallel
+ * nearest(p) 						returns (index, distance) of the closest point, or None
+ * nearest(queries, indices, distances)
+ * 									the same for each point in a V3fArray, writing into an
+ * 									IntArray and a FloatArray of the same length
+ * knn(p, k) 						returns a list of up to k (index, distance), nearest first
+ * knn(queries, k, indices, distances)
+ * 									the same for each query, into arrays of len(queries)*k
+ * 									(unused entries have index -1)
+ * radius(p, r) 					returns an IntArray of the points within r of p
+ * nearestToRay(line) 				returns (index, distance) of the point closest to the
+ * 									ray line.pos + line.dir*t, t >= 0, or None
+ * The build and the batched queries run without the GIL.
+ */
+
+#include <vector>
+#include <cmath>
+#include "kernels/kdtree.hpp"
+#include "VecArray.hpp"
+
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	template<typename T>
+	struct KdTreeBind
+	{
+		typedef kernels::KdTree<T> 						tree_type;
+		typedef Imath::Vec3<T> 							vec_type;
+		typedef Imath::Line3<T> 						line_type;
+		typedef Vec3Array<T> 							array_type;
+		typedef ValueArray<int> 						index_array_type;
+		typedef ValueArray<T> 							dist_array_type;
+		typedef bp::class_<tree_type, boost::noncopyable> 	bp_class;
+
+		KdTreeBind(const char* name)
+		{
+			bp::object (*nearest1)(const tree_type&, const vec_type&) = nearest;
+			void (*nearestN)(const tree_type&, const array_type&,
+				index_array_type&, dist_array_type&) = nearest;
+			bp::list (*knn1)(const tree_type&, const vec_type&, int) = knn;
+			void (*knnN)(const tree_type&, const array_type&, int,
+				index_array_type&, dist_array_type&) = knn;
+
+			bp_class cl(name, bp::no_init);
+			cl
+			.def("__init__", bp::make_constructor(treeInit, bp::default_call_policies(),
+				(bp::arg("points"), bp::arg("leafSize")=16)))
+			.def("__len__", &tree_type::size)
+			.def("nearest", nearest1)
+			.def("nearest", nearestN)
+			.def("knn", knn1)
+			.def("knn", knnN)
+			.def("radius", radius)
+			.def("nearestToRay", nearestToRay)
+			;
+		}
+
+		static tree_type* treeInit(const array_type& points, int leafSize)
+		{
+			ReleaseGIL nogil;
+			return new tree_type(points.data(), points.size(), leafSize);
+		}
+
+		static bp::object result(int index, T dist2)
+		{
+			if(index < 0)
+				return bp::object();
+			return bp::make_tuple(index, std::sqrt(dist2));
+		}
+
+		static bp::object nearest(const tree_type& self, const vec_type& p)
+		{
+			T dist2;
+			int index = self.nearest(p, &dist2);
+			return result(index, dist2);
+		}
+
+		static void nearest(const tree_type& self, const array_type& queries,
+			index_array_type& indices, dist_array_type& distances)
+		{
+			if((indices.size() != queries.size()) || (distances.size() != queries.size()))
+				PIMATH_THROW(PyExc_ValueError, "Result arrays must be the same size as the queries.");
+
+			ReleaseGIL nogil;
+			self.nearest(queries.data(), queries.size(), indices.data(), distances.data());
+		}
+
+		static bp::list knn(const tree_type& self, const vec_type& p, int k)
+		{
+			bp::list l;
+			if(k <= 0)
+				return l;
+
+			std::vector<int> index(k);
+			std::vector<T> dist2(k);
+			int found = self.knn(p, k, &index[0], &dist2[0]);
+			for(int i=0; i<found; ++i)
+				l.append(bp::make_tuple(index[i], std::sqrt(dist2[i])));
+			return l;
+		}
+
+		static void knn(const tree_type& self, const array_type& queries, int k,
+			index_array_type& indices, dist_array_type& distances)
+		{
+			if(k <= 0)
+				PIMATH_THROW(PyExc_ValueError, "k must be positive.");
+
+			const std::size_t n = queries.size() * std::size_t(k);
+			if((indices.size() != n) || (distances.size() != n))
+				PIMATH_THROW(PyExc_ValueError, "Result arrays must hold k entries per query.");
+
+			ReleaseGIL nogil;
+			self.knn(queries.data(), queries.size(), k, indices.data(), distances.data());
+		}
+
+		static index_array_type radius(const tree_type& self, const vec_type& p, T r)
+		{
+			std::vector<int> found;
+			self.radius(p, r, found);
+
+			index_array_type result;
+			result.swap(found);
+			return result;
+		}
+
+		static bp::object nearestToRay(const tree_type& self, const line_type& line)
+		{
+			T dist2;
+			int index = self.nearestToRay(line, &dist2);
+			return result(index, dist2);
+		}
+	};
+}
+
+#endif
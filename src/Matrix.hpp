@@ -40,12 +40,19 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
  * misleading - it sets the whole matrix to a scale matrix, but one might expect it to
  * just set the scale component of that matrix.
  *
- * The free function 'multiply' is not bound, as the * operator will suffice.
+ * The static method 'multiply' writes into its optional 'out' argument rather than a
+ * required third argument: M44f.multiply(a, b, out=c). 'add', 'subtract', 'inverse',
+ * 'gjInverse' and 'transposed' accept 'out' in the same way.
  */
 
 #include <ImathMatrix.h>
 #include <ImathShear.h>
 #include "util.h"
+#include "instance_pool.hpp"
+#include "sequence_slots.hpp"
+#include "number_slots.hpp"
+#include "fastcall.hpp"
+#include "family.hpp"
 
 
 namespace pimath
@@ -131,9 +138,31 @@ namespace pimath
 				scalar_type, scalar_type, scalar_type, scalar_type,
 				scalar_type, scalar_type, scalar_type, scalar_type,
 				scalar_type, scalar_type, scalar_type, scalar_type>())
+			.def("setEulerAngles", setEulerAngles, bp_ret_none())
+			.def("setAxisAngle", setAxisAngle, bp_ret_none())
+			.def("setShear", setShear, bp_ret_none())
+			.def("shear", shear, bp_ret_none())
 			;
 
-			boost::mpl::for_each<ScalarTypes>(Bind_T(cl));
+			Bind_T native(cl);
+			native(scalar_type());
+		}
+
+		// cross-type versions of the above, in double precision
+		static void setEulerAngles(mat_type& self, const FamilyValue<Imath::V3d>& r) {
+			self.setEulerAngles(r.value);
+		}
+
+		static void setAxisAngle(mat_type& self, const FamilyValue<Imath::V3d>& axis, double angle) {
+			self.setAxisAngle(axis.value, angle);
+		}
+
+		static void setShear(mat_type& self, const FamilyValue<Imath::Shear6<double> >& h) {
+			self.setShear(h.value);
+		}
+
+		static void shear(mat_type& self, const FamilyValue<Imath::Shear6<double> >& h) {
+			self.shear(h.value);
 		}
 
 		static bp::tuple getValue(const mat_type &self)
@@ -148,7 +177,8 @@ namespace pimath
 	};
 
 
-	// Matrix-common templatised bindings
+	// Matrix-common templatised bindings, for the matrix's own scalar type. Other scalar
+	// types are handled by the family overloads in MatrixBind.
 	template<typename Matrix>
 	struct MatrixBind_T
 	{
@@ -217,11 +247,16 @@ namespace pimath
 		typedef imath_traits<mat_type> 										mat_traits;
 		typedef typename mat_traits::scalar_type 							scalar_type;
 		typedef typename make_vec<mat_traits::_columns, scalar_type>::type 	vec_type;
+		typedef typename make_vec<mat_traits::_columns-1, scalar_type>::type vec_less1_type;
 		typedef bp::class_<mat_type> 										bp_class;
+		typedef OutArgOps<mat_type, scalar_type> 							out_ops;
+		typedef FamilyValue<typename family_of<mat_type>::type> 			mat_family;
+		typedef FamilyValue<typename family_of<vec_type>::type> 			vec_family;
+		typedef FamilyValue<typename family_of<vec_less1_type>::type> 		vec_less1_family;
+		typedef NumberSlots<mat_type, scalar_type,
+			AddOp|SubtractOp|MultiplyOp|ScaleOp|NegateOp> 					number_slots;
 
-		BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ol_inverse, 		inverse, 	0, 1);
 		BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ol_invert, 		invert, 	0, 1);
-		BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ol_gjInverse, 	gjInverse, 	0, 1);
 		BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ol_gjInvert, 	gjInvert, 	0, 1);
 
 		MatrixBind(const char* name)
@@ -231,7 +266,7 @@ namespace pimath
 			bp_class cl(name);
 			cl
 			.def(bp::init<scalar_type>())
-			.def("__init__", bp::make_constructor(sequenceInit))
+			.def("__init__", sequenceInit)
 			.def("__getitem__", getItem)
 			.def("__setitem__", setItem)
 			.add_property("value", MatrixNNBind<mat_type,ScalarTypes>::getValue, setValue)
@@ -252,14 +287,14 @@ namespace pimath
 			.def(- bp::self)
 			.def("negate", &mat_type::negate, bp_ret_none())
 
-			.def("inverse", &mat_type::inverse, ol_inverse())
+			.def("inverse", inverse, (bp::arg("self"), bp::arg("singExc")=false, bp::arg("out")=bp::object()))
 			.def("invert", &mat_type::invert, bp_ret_none(), ol_invert())
-			.def("gjInverse", &mat_type::gjInverse, ol_gjInverse())
+			.def("gjInverse", gjInverse, (bp::arg("self"), bp::arg("singExc")=false, bp::arg("out")=bp::object()))
 			.def("gjInvert", &mat_type::gjInvert, bp_ret_none(), ol_gjInvert())
 
 			.def("makeIdentity", &mat_type::makeIdentity)
 			.def("transpose", &mat_type::transpose, bp_ret_none())
-			.def("transposed", &mat_type::transposed)
+			.def("transposed", transposed, (bp::arg("self"), bp::arg("out")=bp::object()))
 			.def("equalWithAbsError", &mat_type::equalWithAbsError)
 			.def("equalWithRelError", &mat_type::equalWithRelError)
 			.def("setToScale", fn_setScale, bp_ret_none())
@@ -268,11 +303,89 @@ namespace pimath
 
 			.def("dimensions", _dimensions)
 			.staticmethod("dimensions")
+
+			.def("add", &out_ops::add, out_args())
+			.def("subtract", &out_ops::subtract, out_args())
+			.def("multiply", &out_ops::multiply, out_args())
+			.def("multiply", &out_ops::multiplyScalar, out_args())
+			.staticmethod("add")
+			.staticmethod("subtract")
+			.staticmethod("multiply")
 			;
 
 			bindBaseType<bp_class, mat_type>(cl);
+			bindInstancePool<bp_class, mat_type>(cl);
+			bindSequenceSlots<sequence_slots>(cl, "Matrix index out of range.");
+			bindFastCall<fastMultVecMatrix>(cl, "multVecMatrix");
+			bindFastCall<fastMultDirMatrix>(cl, "multDirMatrix");
 			MatrixNNBind<mat_type, ScalarTypes>::bind(cl);
-			boost::mpl::for_each<ScalarTypes>(MatrixBind_T<mat_type>(cl));
+
+			// any scalar type, then the native overloads for the matrix's own
+			bindFamilyMember<mat_type>(cl);
+			cl
+			.def("__init__", familyInit)
+			.def("multVecMatrix", familyMultVecMatrix)
+			.def("multDirMatrix", familyMultDirMatrix)
+			.def("setToScale", familySetScale)
+			.def("scale", familyScale)
+			.def("setToTranslation", familySetTranslation)
+			.def("translate", familyTranslate)
+			.def("setToShear", familySetShear)
+			.def("shear", familyShear)
+			.def("__rmul__", familyMultVecLess1)
+			.def("__rmul__", familyMultVec)
+			;
+
+			MatrixBind_T<mat_type> native(cl);
+			native(scalar_type());
+			bindNumberSlots<number_slots>(cl);
+		}
+
+		// Cross-type bindings, for vectors and matrices of any scalar type. Arithmetic is
+		// carried out in double precision, and vectors are returned as the argument's type.
+		static void familyInit(PyObject* self, const mat_family& m) {
+			holdValue(self, mat_type(m.value));
+		}
+
+		static bp::object familyMultVecMatrix(const mat_type& self, const vec_less1_family& v)
+		{
+			typename vec_less1_family::value_type vdest;
+			self.multVecMatrix(v.value, vdest);
+			return v.make(vdest);
+		}
+
+		static bp::object familyMultDirMatrix(const mat_type& self, const vec_less1_family& v)
+		{
+			typename vec_less1_family::value_type vdest;
+			self.multDirMatrix(v.value, vdest);
+			return v.make(vdest);
+		}
+
+		static void familySetScale(mat_type& self, const vec_less1_family& v) 		{ self.setScale(v.value); }
+		static void familyScale(mat_type& self, const vec_less1_family& v) 		{ self.scale(v.value); }
+		static void familySetTranslation(mat_type& self, const vec_less1_family& v) { self.setTranslation(v.value); }
+		static void familyTranslate(mat_type& self, const vec_less1_family& v) 	{ self.translate(v.value); }
+		static void familySetShear(mat_type& self, const vec_less1_family& v) 		{ self.setShear(v.value); }
+		static void familyShear(mat_type& self, const vec_less1_family& v) 		{ self.shear(v.value); }
+
+		static bp::object familyMultVecLess1(const mat_type& self, const vec_less1_family& v) {
+			return v.make(v.value * self);
+		}
+
+		static bp::object familyMultVec(const mat_type& self, const vec_family& v) {
+			return v.make(v.value * self);
+		}
+
+		static bp::object inverse(const mat_type& self, bool singExc, const bp::object& out) {
+			return assignOut(self.inverse(singExc), out);
+		}
+
+		static bp::object gjInverse(const mat_type& self, bool singExc, const bp::object& out) {
+			return assignOut(self.gjInverse(singExc), out);
+		}
+
+		static bp::object transposed(const mat_type& self, const bp::object& out) {
+			return assignOut(self.transposed(), out);
 		}
 
 		static std::string toString(const mat_type& self)
@@ -305,13 +418,46 @@ namespace pimath
 				imath_traits<mat_type>::_columns);
 		}
 
-		static mat_type* sequenceInit(const bp::object& x)
+		static void sequenceInit(PyObject* self, const bp::object& x)
 		{
-			mat_type* m = new mat_type();
-			setValue(*m, x);
-			return m;
+			mat_type m;
+			setValue(m, x);
+			holdValue(self, m);
 		}
 
+		static PyObject* fastMultVecMatrix(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const mat_type* m = heldValue<mat_type>(self);
+			const vec_less1_type* v = (nargs == 1)? heldValue<vec_less1_type>(args[0]) : 0;
+			if(!m || !v)
+				return 0;
+
+			vec_less1_type vdest;
+			m->multVecMatrix(*v, vdest);
+			return toPython(vdest);
+		}
+
+		static PyObject* fastMultDirMatrix(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const mat_type* m = heldValue<mat_type>(self);
+			const vec_less1_type* v = (nargs == 1)? heldValue<vec_less1_type>(args[0]) : 0;
+			if(!m || !v)
+				return 0;
+
+			vec_less1_type vdest;
+			m->multDirMatrix(*v, vdest);
+			return toPython(vdest);
+		}
+
+		static PyObject* rowItem(const mat_type& self, int r)
+		{
+			vec_type v;
+			std::copy(self[r], self[r]+mat_traits::_columns, &v.x);
+			return bp::incref(bp::object(v).ptr());
+		}
+
+		typedef SequenceSlots<mat_type, mat_traits::_rows, &rowItem> sequence_slots;
+
 		static bp::object getItem(const mat_type& self, const bp::object& index)
 		{
 			bp::extract<int> getint(index);
@@ -32,6 +32,8 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/python.hpp>
 #include <ImathMatrixAlgo.h>
 #include "util.h"
+#include "dispatch.hpp"
+#include "kernels/pca.hpp"
 
 /*
  * extractSHRT,
@@ -52,9 +54,17 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
  * extractAndRemoveScalingAndShear:
  * Not implemented, use a combination of extractScalingAndShear and withoutScalingAndShear instead.
  *
+ * All of the above are overloaded per scalar type and dimension, and are resolved through
+ * a dispatch cache (see dispatch.hpp).
+ *
  * extractSHRT:
  * The form of this function which takes args (M44, Vec3, Vec3, Euler, Vec3) is available
  * as the function 'extractEulerSHRT'.
+ *
+ * jacobiEigenSolve:
+ * Takes a symmetric M33 and returns (eigenvalues, eigenvectors), as a Vec3 and an M33
+ * whose columns are the eigenvectors, sorted by decreasing eigenvalue. Older versions of
+ * Imath don't have it; it's computed in double by kernels::jacobiEigenSolve.
  */
 
 namespace pimath
@@ -73,44 +83,55 @@ namespace pimath
 
 		MatrixAlgoBind()
 		{
-			bp::def("extractQuat", &Imath::extractQuat<T>);
-			bp::def("rotationMatrix", &Imath::rotationMatrix<T>);
-			bp::def("rotationMatrixWithUpDir", &Imath::rotationMatrixWithUpDir<T>);
-			bp::def("alignZAxisWithTargetDir", &Imath::alignZAxisWithTargetDir<T>);
-
-			bp::def("extractScaling", extractScaling<mat33_type>);
-			bp::def("extractScaling", extractScaling_<mat33_type>);
-			bp::def("extractScaling", extractScaling<mat44_type>);
-			bp::def("extractScaling", extractScaling_<mat44_type>);
-
-			bp::def("withoutScaling", removeScaling<mat33_type>);
-			bp::def("withoutScaling", removeScaling_<mat33_type>);
-			bp::def("withoutScaling", removeScaling<mat44_type>);
-			bp::def("withoutScaling", removeScaling_<mat44_type>);
-
-			bp::def("withoutScalingAndShear", removeScalingAndShear<mat33_type>);
-			bp::def("withoutScalingAndShear", removeScalingAndShear_<mat33_type>);
-			bp::def("withoutScalingAndShear", removeScalingAndShear<mat44_type>);
-			bp::def("withoutScalingAndShear", removeScalingAndShear_<mat44_type>);
-
-			bp::def("extractScalingAndShear", extractScalingAndShear33);
-			bp::def("extractScalingAndShear", extractScalingAndShear33_);
-			bp::def("extractScalingAndShear", extractScalingAndShear44);
-			bp::def("extractScalingAndShear", extractScalingAndShear44_);
-
-			bp::def("extractSHRT", extractSHRT33);
-			bp::def("extractSHRT", extractSHRT33_);
-
-			bp::def("extractSHRT", extractSHRT44);
-			bp::def("extractSHRT", extractSHRT44_);
-			bp::def("extractSHRT", extractSHRT44__);
-
-			bp::def("extractEulerSHRT", extractEulerSHRT);
-			bp::def("extractEulerSHRT", extractEulerSHRT_);
-
-			bp::def("extractEuler", extractEuler);
-			bp::def("extractEulerXYZ", extractEulerXYZ);
-			bp::def("extractEulerZYX", extractEulerZYX);
+			defDispatch("extractQuat", &Imath::extractQuat<T>);
+			defDispatch("rotationMatrix", &Imath::rotationMatrix<T>);
+			defDispatch("rotationMatrixWithUpDir", &Imath::rotationMatrixWithUpDir<T>);
+			defDispatch("alignZAxisWithTargetDir", &Imath::alignZAxisWithTargetDir<T>);
+
+			defDispatch("extractScaling", extractScaling<mat33_type>);
+			defDispatch("extractScaling", extractScaling_<mat33_type>);
+			defDispatch("extractScaling", extractScaling<mat44_type>);
+			defDispatch("extractScaling", extractScaling_<mat44_type>);
+
+			defDispatch("withoutScaling", removeScaling<mat33_type>);
+			defDispatch("withoutScaling", removeScaling_<mat33_type>);
+			defDispatch("withoutScaling", removeScaling<mat44_type>);
+			defDispatch("withoutScaling", removeScaling_<mat44_type>);
+
+			defDispatch("withoutScalingAndShear", removeScalingAndShear<mat33_type>);
+			defDispatch("withoutScalingAndShear", removeScalingAndShear_<mat33_type>);
+			defDispatch("withoutScalingAndShear", removeScalingAndShear<mat44_type>);
+			defDispatch("withoutScalingAndShear", removeScalingAndShear_<mat44_type>);
+
+			defDispatch("extractScalingAndShear", extractScalingAndShear33);
+			defDispatch("extractScalingAndShear", extractScalingAndShear33_);
+			defDispatch("extractScalingAndShear", extractScalingAndShear44);
+			defDispatch("extractScalingAndShear", extractScalingAndShear44_);
+
+			defDispatch("extractSHRT", extractSHRT33);
+			defDispatch("extractSHRT", extractSHRT33_);
+
+			defDispatch("extractSHRT", extractSHRT44);
+			defDispatch("extractSHRT", extractSHRT44_);
+			defDispatch("extractSHRT", extractSHRT44__);
+
+			defDispatch("extractEulerSHRT", extractEulerSHRT);
+			defDispatch("extractEulerSHRT", extractEulerSHRT_);
+
+			defDispatch("jacobiEigenSolve", jacobiEigenSolve);
+
+			defDispatch("extractEuler", extractEuler);
+			defDispatch("extractEulerXYZ", extractEulerXYZ);
+			defDispatch("extractEulerZYX", extractEulerZYX);
+		}
+
+		static bp::tuple jacobiEigenSolve(const mat33_type& mat)
+		{
+			Imath::M33d a(mat), v;
+			Imath::V3d s;
+			kernels::jacobiEigenSolve(a, s, v);
+			kernels::sortEigen(s, v);
+			return bp::make_tuple(vec3_type(s), mat33_type(v));
 		}
 
 		static bp::object extractEulerSHRT(const mat44_type& mat, bool exc)
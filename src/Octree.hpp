@@ -0,0 +1,221 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_OCTREE__H_
+#define _PIMATH_OCTREE__H_
+
+/*
+ * PointOctreeWriter and PointOctree are not part of Imath. They store a point cloud too
+ * large for memory as a level-of-detail octree in a file, and wrap kernels::OctreeWriter
+ * and kernels::PointOctree (see kernels/octree.hpp):
+ * PointOctreeWriter(path, bounds[, gridSize, maxDepth, memoryBudget])
+ * 					starts a file for the points inside Box3d bounds, buffering up to
+ * 					memoryBudget points (by default 1 << 22) before writing them out
+ * add(points) 		adds a V3dArray of points, without the GIL
+ * close() 			writes the index; nothing can be read until it's called
+ * pointCount(), outsideCount()
+ * 					the points added, and those skipped for being outside the bounds
+ *
+ * Using a writer from another python thread during add() raises RuntimeError.
+ *
+ * PointOctree(path) 	reads the file's index
+ * select(frustum, worldToCamera, screenSize, maxPoints)
+ * 					returns an IntArray of the nodes to draw for a Frustumd view, coarsest
+ * 					first: those in view, refined until their point spacing is no larger
+ * 					than screenSize on screen, up to maxPoints points in total
+ * load(node) 		reads a node's points into a new V3dArray
+ * nodeBox(node), nodeDepth(node), nodeParent(node), nodeChildren(node), nodePointCount(node),
+ * nodeSpacing(node)
+ * 					describe a node; the root is node 0
+ */
+
+#include <string>
+#include <vector>
+#include "kernels/octree.hpp"
+#include "VecArray.hpp"
+
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	// the bound writer, with a BusyGuard counter for its GIL-free add
+	struct GuardedOctreeWriter : public kernels::OctreeWriter
+	{
+		GuardedOctreeWriter(const std::string& path, const box_type& bounds, int gridSize = 32,
+			int maxDepth = 16, std::size_t memoryBudget = 1 << 22)
+		:	kernels::OctreeWriter(path, bounds, gridSize, maxDepth, memoryBudget), busy(0) {}
+
+		int busy;
+	};
+
+
+	struct OctreeWriterBind
+	{
+		typedef GuardedOctreeWriter 					writer_type;
+		typedef writer_type::box_type 					box_type;
+		typedef Vec3Array<double> 						array_type;
+		typedef bp::class_<writer_type, boost::noncopyable> 	bp_class;
+
+		OctreeWriterBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<std::string, box_type, bp::optional<int, int, std::size_t> >())
+			.def("add", add)
+			.def("close", close)
+			.def("pointCount", pointCount)
+			.def("outsideCount", outsideCount)
+			;
+		}
+
+		static void add(writer_type& self, const array_type& points)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Write);
+			ReleaseGIL nogil;
+			self.add(points.data(), points.size());
+		}
+
+		static void close(writer_type& self)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Write);
+			self.close();
+		}
+
+		static unsigned long long pointCount(writer_type& self)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Read);
+			return self.pointCount();
+		}
+
+		static unsigned long long outsideCount(writer_type& self)
+		{
+			BusyGuard guard(self.busy, BusyGuard::Read);
+			return self.outsideCount();
+		}
+	};
+
+
+	struct PointOctreeBind
+	{
+		typedef kernels::PointOctree 					octree_type;
+		typedef octree_type::box_type 					box_type;
+		typedef octree_type::frustum_type 				frustum_type;
+		typedef octree_type::matrix_type 				matrix_type;
+		typedef octree_type::vec_type 					vec_type;
+		typedef Vec3Array<double> 						array_type;
+		typedef ValueArray<int> 						index_array_type;
+		typedef bp::class_<octree_type, boost::noncopyable> 	bp_class;
+
+		PointOctreeBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<std::string>())
+			.def("__len__", &octree_type::size)
+			.def("pointCount", &octree_type::pointCount)
+			.def("bounds", &octree_type::bounds, bp::return_value_policy<bp::copy_const_reference>())
+			.def("gridSize", &octree_type::gridSize)
+			.def("select", select)
+			.def("load", load)
+			.def("nodeBox", nodeBox)
+			.def("nodeDepth", nodeDepth)
+			.def("nodeParent", nodeParent)
+			.def("nodeChildren", nodeChildren)
+			.def("nodePointCount", nodePointCount)
+			.def("nodeSpacing", nodeSpacing)
+			;
+		}
+
+		static std::size_t node(const octree_type& self, int i)
+		{
+			if((i<0) || (i>=(int)self.size()))
+				PIMATH_THROW(PyExc_IndexError, "Octree node index out of range.");
+			return i;
+		}
+
+		static index_array_type select(const octree_type& self, const frustum_type& frustum,
+			const matrix_type& worldToCamera, double screenSize, unsigned long long maxPoints)
+		{
+			std::vector<int> nodes;
+			self.select(frustum, worldToCamera, screenSize, maxPoints, nodes);
+
+			index_array_type result;
+			result.swap(nodes);
+			return result;
+		}
+
+		static array_type load(const octree_type& self, int i)
+		{
+			const std::size_t n = node(self, i);
+			std::vector<vec_type> points;
+			{
+				ReleaseGIL nogil;
+				self.load(n, points);
+			}
+
+			array_type result;
+			result.swap(points);
+			return result;
+		}
+
+		static box_type nodeBox(const octree_type& self, int i) {
+			return self.nodeBox(node(self, i));
+		}
+
+		static int nodeDepth(const octree_type& self, int i) {
+			return self.nodeDepth(node(self, i));
+		}
+
+		static int nodeParent(const octree_type& self, int i) {
+			return self.nodeParent(node(self, i));
+		}
+
+		static bp::list nodeChildren(const octree_type& self, int i)
+		{
+			const std::size_t n = node(self, i);
+			bp::list l;
+			for(int c=0; c<8; ++c)
+			{
+				if(self.nodeChild(n, c) >= 0)
+					l.append(self.nodeChild(n, c));
+			}
+			return l;
+		}
+
+		static unsigned long long nodePointCount(const octree_type& self, int i) {
+			return self.nodePointCount(node(self, i));
+		}
+
+		static double nodeSpacing(const octree_type& self, int i) {
+			return self.nodeSpacing(node(self, i));
+		}
+	};
+}
+
+#endif
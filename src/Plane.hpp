@@ -31,16 +31,124 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <ImathPlane.h>
 #include "util.h"
+#include "VecArray.hpp"
+#include "kernels/planes.hpp"
 
 /**
  * intersect and intersectT now return the point of intersection rather than
  * whether the intersection occurred (they return None if no intersection)
+ *
+ * Plane3f and Plane3d also work on arrays, in parallel. distances(points) returns the
+ * signed distance of each point of a V3fArray (V3dArray) as a FloatArray (DoubleArray).
+ * classifyPoints(points[, tolerance]), classifyBoxes(mins, maxs) and
+ * classifySpheres(centers, radii) return an IntArray of PlaneSide values: PlaneFront (1)
+ * on the normal's side, PlaneBack (-1), or PlaneStraddle (0) for points within tolerance and
+ * boxes and spheres which cross or touch the plane. Boxes are given by arrays of their min
+ * and max corners. intersectLines(origins, dirs) intersects lines with the plane and returns
+ * an IntArray hit mask (0 for lines parallel to the plane), t and points, as
+ * Sphere3f.intersectRays.
  */
 
 namespace pimath
 {
 	namespace bp = boost::python;
 
+	// distances, classification and line intersection over V3 arrays
+	template<typename T>
+	struct PlaneArrays
+	{
+		typedef Imath::Plane3<T> 			plane_type;
+		typedef Vec3Array<T> 				array_type;
+		typedef ValueArray<T> 				value_array_type;
+
+		template<typename BpClass>
+		static void def(BpClass& cl)
+		{
+			cl
+			.def("distances", distances, (bp::arg("points")))
+			.def("classifyPoints", classifyPoints, (bp::arg("points"), bp::arg("tolerance")=T(0)))
+			.def("classifyBoxes", classifyBoxes, (bp::arg("mins"), bp::arg("maxs")))
+			.def("classifySpheres", classifySpheres, (bp::arg("centers"), bp::arg("radii")))
+			.def("intersectLines", intersectLines, (bp::arg("origins"), bp::arg("dirs")))
+			;
+		}
+
+		static value_array_type distances(const plane_type& self, const array_type& points)
+		{
+			value_array_type result(points.size());
+			{
+				ReleaseGIL nogil;
+				kernels::planeDistances(self, points.data(), points.size(), result.data());
+			}
+			return result;
+		}
+
+		static ValueArray<int> classifyPoints(const plane_type& self, const array_type& points, T tolerance)
+		{
+			ValueArray<int> sides(points.size());
+			{
+				ReleaseGIL nogil;
+				kernels::classifyPoints(self, points.data(), points.size(), tolerance, sides.data());
+			}
+			return sides;
+		}
+
+		static ValueArray<int> classifyBoxes(const plane_type& self, const array_type& mins,
+			const array_type& maxs)
+		{
+			if(mins.size() != maxs.size())
+				PIMATH_THROW(PyExc_ValueError, "Box mins and maxs must be the same size.");
+
+			ValueArray<int> sides(mins.size());
+			{
+				ReleaseGIL nogil;
+				kernels::classifyBoxes(self, mins.data(), maxs.data(), mins.size(), sides.data());
+			}
+			return sides;
+		}
+
+		static ValueArray<int> classifySpheres(const plane_type& self, const array_type& centers,
+			const value_array_type& radii)
+		{
+			if(centers.size() != radii.size())
+				PIMATH_THROW(PyExc_ValueError, "Sphere centers and radii must be the same size.");
+
+			ValueArray<int> sides(centers.size());
+			{
+				ReleaseGIL nogil;
+				kernels::classifySpheres(self, centers.data(), radii.data(), centers.size(), sides.data());
+			}
+			return sides;
+		}
+
+		static bp::tuple intersectLines(const plane_type& self, const array_type& origins,
+			const array_type& dirs)
+		{
+			if(origins.size() != dirs.size())
+				PIMATH_THROW(PyExc_ValueError, "Line origins and directions must be the same size.");
+
+			const std::size_t n = origins.size();
+			ValueArray<int> hit(n);
+			value_array_type t(n);
+			array_type points(n);
+			if(n)
+			{
+				ReleaseGIL nogil;
+				kernels::intersectLines(self, origins.data(), dirs.data(), n, t.data(), points.data(),
+					hit.data());
+			}
+			return bp::make_tuple(hit, t, points);
+		}
+	};
+
+	template<>
+	struct PlaneArrays<half>
+	{
+		template<typename BpClass>
+		static void def(BpClass&) {}
+	};
+
+
 	template<typename T>
 	struct PlaneBind
 	{
@@ -75,6 +183,8 @@ namespace pimath
 			.def("reflectVector", &plane_type::reflectVector )
 			.add_property("value", getValue, setValue)
 			.def("__str__", toString);
+
+			PlaneArrays<T>::def(cl);
 		}
 
 		static plane_type*
@@ -33,13 +33,19 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <sstream>
 #include "util.h"
+#include "instance_pool.hpp"
+#include "sequence_slots.hpp"
+#include "number_slots.hpp"
+#include "fastcall.hpp"
+#include "components.hpp"
+#include "family.hpp"
 
 namespace pimath
 {
 	namespace bp = boost::python;
 
 
-	// templatised bindings
+	// templatised bindings, for the quat's own scalar type
 	template<typename Quat>
 	struct QuatBind_T
 	{
@@ -71,6 +77,11 @@ namespace pimath
 		typedef Imath::Vec3<T> 			vec_type;
 		typedef Imath::Matrix33<T> 		mat_type;
 		typedef bp::class_<quat_type> 	bp_class;
+		typedef OutArgOps<quat_type, scalar_type> 	out_ops;
+		typedef FamilyValue<Imath::Quatd> 			quat_family;
+		typedef SequenceSlots<quat_type, 4, &scalarItem<quat_type> > 	sequence_slots;
+		typedef NumberSlots<quat_type, scalar_type,
+			AddOp|SubtractOp|MultiplyOp|DivideOp|ScaleOp|NegateOp> 		number_slots;
 
 		QuatBind(const char* name)
 		{
@@ -79,7 +90,7 @@ namespace pimath
 			.def(bp::init<>())
 			.def(bp::init<scalar_type, scalar_type, scalar_type, scalar_type>())
 			.def(bp::init<scalar_type, vec_type>())
-			.def("__init__",bp::make_constructor(sequenceInit))
+			.def("__init__", sequenceInit)
 			.def_readwrite("v", &quat_type::v)
 			.def("__getitem__", getItem)
 			.def("__setitem__", setItem)
@@ -102,9 +113,9 @@ namespace pimath
 			.def(bp::self += bp::self)
 			.def(bp::self -= bp::self)
 			.def("invert", &quat_type::invert, bp_ret_none())
-			.def("inverse", &quat_type::inverse)
+			.def("inverse", inverse, (bp::arg("self"), bp::arg("out")=bp::object()))
 			.def("normalize", &quat_type::normalize, bp_ret_none())
-			.def("normalized", &quat_type::normalized)
+			.def("normalized", normalized, (bp::arg("self"), bp::arg("out")=bp::object()))
 			.def("length", &quat_type::length)
 			.def("rotateVector", &quat_type::rotateVector)
 			.def("euclideanInnerProduct", &quat_type::euclideanInnerProduct)
@@ -122,11 +133,20 @@ namespace pimath
 			.def("identity", &quat_type::identity)
 			.staticmethod("identity")
 
-			// note: due to def_readwrite() not supporting custom to-python converters
-			.add_property("r", bp::make_getter(&quat_type::r, bp_ret_val()),
-				bp::make_setter(&quat_type::r))
+			.def("add", &out_ops::add, out_args())
+			.def("subtract", &out_ops::subtract, out_args())
+			.def("multiply", &out_ops::multiply, out_args())
+			.def("multiply", &out_ops::multiplyScalar, out_args())
+			.def("divide", &out_ops::divide, out_args())
+			.def("divide", &out_ops::divideScalar, out_args())
+			.staticmethod("add")
+			.staticmethod("subtract")
+			.staticmethod("multiply")
+			.staticmethod("divide")
 			;
 
+			bindComponent<quat_type, scalar_type, &quat_type::r>(cl, "r");
+
 			quat_type (*fn_intermediate)(
 				const quat_type&,const quat_type&,const quat_type&) = &Imath::intermediate;
 
@@ -137,16 +157,84 @@ namespace pimath
 			bp::def("slerpShortestArc", &Imath::slerpShortestArc<T>);
 			bp::def("intermediate", fn_intermediate);
 
-			boost::mpl::for_each<ScalarTypes>(QuatBind_T<quat_type>(cl));
+			bindInstancePool<bp_class, quat_type>(cl);
+			bindSequenceSlots<sequence_slots>(cl, "Quat index out of range.");
+			bindFastCall<fastLength>(cl, "length");
+			bindFastCall<fastNormalized>(cl, "normalized");
+			bindFastCall<fastRotateVector>(cl, "rotateVector");
+			defFastCall<fastSlerp>("slerp");
+			// any scalar type, then the native overloads for the quat's own
+			bindFamilyMember<quat_type>(cl);
+			cl
+			.def("__init__", familyInit)
+			.def("__eq__", familyEqual)
+			.def("__ne__", familyNotEqual)
+			;
+
+			QuatBind_T<quat_type> native(cl);
+			native(scalar_type());
+			bindNumberSlots<number_slots>(cl);
+		}
+
+
+		// cross-type bindings, for a quat of any scalar type
+		static void familyInit(PyObject* self, const quat_family& q) {
+			holdValue(self, quat_type(q.value));
+		}
+
+		static bool familyEqual(const quat_type& self, const quat_family& q) {
+			return Imath::Quatd(self) == q.value;
+		}
+
+		static bool familyNotEqual(const quat_type& self, const quat_family& q) {
+			return Imath::Quatd(self) != q.value;
+		}
+
+		static void
+		sequenceInit( PyObject* self, const bp::object & x )
+		{
+			quat_type f;
+			setValue( f, x );
+			holdValue( self, f );
+		}
+
+		static bp::object inverse(const quat_type& self, const bp::object& out) {
+			return assignOut(self.inverse(), out);
 		}
 
+		static bp::object normalized(const quat_type& self, const bp::object& out) {
+			return assignOut(self.normalized(), out);
+		}
+
+		static PyObject* fastLength(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const quat_type* q = heldValue<quat_type>(self);
+			return (q && (nargs == 0))? toPython(q->length()) : 0;
+		}
+
+		static PyObject* fastNormalized(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const quat_type* q = heldValue<quat_type>(self);
+			return (q && (nargs == 0))? toPython(q->normalized()) : 0;
+		}
+
+		static PyObject* fastRotateVector(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const quat_type* q = heldValue<quat_type>(self);
+			const vec_type* v = (nargs == 1)? heldValue<vec_type>(args[0]) : 0;
+			return (q && v)? toPython(q->rotateVector(*v)) : 0;
+		}
 
-		static quat_type*
-		sequenceInit( const bp::object & x )
+		static PyObject* fastSlerp(PyObject*, PyObject* const* args, Py_ssize_t nargs)
 		{
-			quat_type * f = new quat_type();
-			setValue( *f, x );
-			return f;
+			if(nargs != 3)
+				return 0;
+
+			const quat_type* q1 = heldValue<quat_type>(args[0]);
+			const quat_type* q2 = heldValue<quat_type>(args[1]);
+			scalar_type t;
+			return (q1 && q2 && fromPython(args[2], t))?
+				toPython(Imath::slerp(*q1, *q2, t)) : 0;
 		}
 
 		static bp::object getValue(const quat_type &self)
@@ -36,6 +36,9 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
  * There are variants of solidSphereRand and hollowSphereRand and gaussSphererand
  * that vary only by return type. These have been given unique names.
  *
+ * Rand32 and Rand48 are not thread safe. The bulk samplers (eg V3fArray.solidSphereRand)
+ * don't use them, but seed generators of their own per thread (see kernels/random.hpp).
+ *
  * TODO: Direct fn poniter for constructor, nextf
  * TODO: Separate type list for sphere algo
  */
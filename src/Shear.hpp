@@ -31,6 +31,7 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <ImathShear.h>
 #include "util.h"
+#include "family.hpp"
 
 
 namespace pimath
@@ -87,6 +88,8 @@ namespace pimath
 			.def(bp::self /= bp::other<scalar_type>())
 			.def(bp::other<scalar_type>() * bp::self)
 			.def("__str__", toString );
+
+			bindFamilyMember<shear_type>(cl);
 		}
 
 		static shear_type*
@@ -30,16 +30,174 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _PIMATH_SPHERE__H_
 
 #include <ImathSphere.h>
+#include <half.h>
 #include "util.h"
+#include "VecArray.hpp"
+#include "kernels/spheres.hpp"
 
 /**
  * Intersect/IntersectT now return the result (or None if no intersection)
+ *
+ * fromPoints(points[, fit]) and fromPointSegments(points, offsets[, fit]) are static
+ * methods of Sphere3f and Sphere3d, not part of Imath. They return the sphere bounding a
+ * V3fArray (V3dArray), or a list of spheres bounding consecutive runs of it - run i is
+ * points[offsets[i]:offsets[i+1]] of an IntArray of offsets. fit is SphereFit.ExactFit
+ * (the default, the smallest sphere) or SphereFit.RitterFit (faster but looser).
+ *
+ * Rays and spheres are also intersected in bulk, as intersect and intersectT, over arrays:
+ * sphere.intersectRays(origins, dirs) tests many rays against one sphere, the static
+ * intersectSpheres(centers, radii, ray) one ray against many spheres, and
+ * intersectPairs(centers, radii, origins, dirs) ray i against sphere i. Rays are V3fArrays of
+ * origins and unit directions (as Line3.dir), and spheres a V3fArray of centers and a
+ * FloatArray of radii (V3dArray and DoubleArray for Sphere3d). Each returns a tuple of an
+ * IntArray hit mask, an array of hit t and a V3fArray of hit points; t and points are 0
+ * where a ray misses. pickSpheres(centers, radii, ray) returns (index, t, point) of the
+ * nearest sphere the ray hits, or None.
  */
 
 namespace pimath
 {
 	namespace bp = boost::python;
 
+	// bounding spheres and ray intersection over V3 arrays (there's no half point array)
+	template<typename T>
+	struct SphereArrays
+	{
+		typedef Imath::Sphere3<T> 			sphere_type;
+		typedef Imath::Line3<T> 			line_type;
+		typedef Vec3Array<T> 				array_type;
+		typedef ValueArray<T> 				radius_array_type;
+
+		template<typename BpClass>
+		static void def(BpClass& cl)
+		{
+			cl
+			.def("fromPoints", fromPoints,
+				(bp::arg("points"), bp::arg("fit")=kernels::ExactFit))
+			.staticmethod("fromPoints")
+			.def("fromPointSegments", fromPointSegments,
+				(bp::arg("points"), bp::arg("offsets"), bp::arg("fit")=kernels::ExactFit))
+			.staticmethod("fromPointSegments")
+			.def("intersectRays", intersectRays, (bp::arg("origins"), bp::arg("dirs")))
+			.def("intersectSpheres", intersectSpheres,
+				(bp::arg("centers"), bp::arg("radii"), bp::arg("ray")))
+			.staticmethod("intersectSpheres")
+			.def("intersectPairs", intersectPairs,
+				(bp::arg("centers"), bp::arg("radii"), bp::arg("origins"), bp::arg("dirs")))
+			.staticmethod("intersectPairs")
+			.def("pickSpheres", pickSpheres, (bp::arg("centers"), bp::arg("radii"), bp::arg("ray")))
+			.staticmethod("pickSpheres")
+			;
+		}
+
+		static sphere_type fromPoints(const array_type& points, kernels::SphereFit fit)
+		{
+			ReleaseGIL nogil;
+			return kernels::boundingSphere(points.data(), points.size(), fit);
+		}
+
+		static bp::list fromPointSegments(const array_type& points, const ValueArray<int>& offsets,
+			kernels::SphereFit fit)
+		{
+			const int* o = offsets.data();
+			const std::size_t count = offsets.size()? offsets.size() - 1 : 0;
+			for(std::size_t i=0; i<offsets.size(); ++i)
+			{
+				if((o[i] < 0) || (std::size_t(o[i]) > points.size()) || (i && (o[i] < o[i-1])))
+					PIMATH_THROW(PyExc_ValueError, "Segment offsets must ascend within the points.");
+			}
+
+			std::vector<sphere_type> spheres(count);
+			if(count)
+			{
+				ReleaseGIL nogil;
+				kernels::boundingSpheres(points.data(), o, count, fit, &spheres[0]);
+			}
+
+			bp::list l;
+			for(std::size_t i=0; i<count; ++i)
+				l.append(spheres[i]);
+			return l;
+		}
+
+		static bp::tuple intersectRays(const sphere_type& self, const array_type& origins,
+			const array_type& dirs)
+		{
+			if(origins.size() != dirs.size())
+				PIMATH_THROW(PyExc_ValueError, "Ray origins and directions must be the same size.");
+			return intersect(origins.data(), dirs.data(), 1, &self.center, &self.radius, 0, origins.size());
+		}
+
+		static bp::tuple intersectSpheres(const array_type& centers, const radius_array_type& radii,
+			const line_type& ray)
+		{
+			checkSpheres(centers, radii);
+			return intersect(&ray.pos, &ray.dir, 0, centers.data(), radii.data(), 1, centers.size());
+		}
+
+		static bp::tuple intersectPairs(const array_type& centers, const radius_array_type& radii,
+			const array_type& origins, const array_type& dirs)
+		{
+			checkSpheres(centers, radii);
+			if((origins.size() != centers.size()) || (dirs.size() != centers.size()))
+				PIMATH_THROW(PyExc_ValueError, "There must be one ray for each sphere.");
+			return intersect(origins.data(), dirs.data(), 1, centers.data(), radii.data(), 1,
+				centers.size());
+		}
+
+		static bp::object pickSpheres(const array_type& centers, const radius_array_type& radii,
+			const line_type& ray)
+		{
+			checkSpheres(centers, radii);
+
+			const std::size_t n = centers.size();
+			std::vector<T> t(n);
+			std::vector<int> hit(n);
+			long nearest;
+			{
+				ReleaseGIL nogil;
+				kernels::intersectSpheresParallel(&ray.pos, &ray.dir, 0, centers.data(), radii.data(), 1,
+					n, n? &t[0] : 0, static_cast<Imath::Vec3<T>*>(0), n? &hit[0] : 0);
+				nearest = kernels::nearestHit(n? &t[0] : 0, n? &hit[0] : 0, n);
+			}
+
+			if(nearest < 0)
+				return bp::object();
+			return bp::make_tuple(nearest, t[nearest], ray(t[nearest]));
+		}
+
+		static void checkSpheres(const array_type& centers, const radius_array_type& radii)
+		{
+			if(centers.size() != radii.size())
+				PIMATH_THROW(PyExc_ValueError, "Sphere centers and radii must be the same size.");
+		}
+
+		// the hit mask, t and points of n rays and spheres, with steps as kernels::intersectSpheres
+		static bp::tuple intersect(const Imath::Vec3<T>* origins, const Imath::Vec3<T>* dirs,
+			std::size_t rayStep, const Imath::Vec3<T>* centers, const T* radii, std::size_t sphereStep,
+			std::size_t n)
+		{
+			ValueArray<int> hit(n);
+			radius_array_type t(n);
+			array_type points(n);
+			if(n)
+			{
+				ReleaseGIL nogil;
+				kernels::intersectSpheresParallel(origins, dirs, rayStep, centers, radii, sphereStep,
+					n, t.data(), points.data(), hit.data());
+			}
+			return bp::make_tuple(hit, t, points);
+		}
+	};
+
+	template<>
+	struct SphereArrays<half>
+	{
+		template<typename BpClass>
+		static void def(BpClass&) {}
+	};
+
+
 	template<typename T>
 	struct SphereBind
 	{
@@ -65,6 +223,8 @@ namespace pimath
 			.def("intersect",intersect)
 			.def("intersectT",intersectT)
 			.def("__str__", toString);
+
+			SphereArrays<T>::def(cl);
 		}
 
 		static sphere_type*
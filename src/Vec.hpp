@@ -33,6 +33,13 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <ImathColor.h>
 #include <ImathMatrix.h>
 #include "util.h"
+#include "instance_pool.hpp"
+#include "dispatch.hpp"
+#include "sequence_slots.hpp"
+#include "number_slots.hpp"
+#include "fastcall.hpp"
+#include "components.hpp"
+#include "family.hpp"
 
 
 namespace pimath
@@ -40,6 +47,22 @@ namespace pimath
 	namespace bp = boost::python;
 
 
+	// Vec(v), for a v of any scalar type, or of another dimension (eg V3f(V4d))
+	template<typename Vec, typename D>
+	void convertInit(PyObject* self, const FamilyValue<D>& v) {
+		holdValue(self, Vec(v.value));
+	}
+
+	// v *= m, for a matrix of any scalar type. This is carried out in double precision;
+	// the native overload for the vector's own scalar type is tried first.
+	template<typename Vec, typename Matrix>
+	bp::object multMatrix(bp::back_reference<Vec&> self, const FamilyValue<Matrix>& m)
+	{
+		self.get() *= m.value;
+		return self.source();
+	}
+
+
 	template<typename Vec, typename ScalarTypes>
 	struct VecNBind{};
 
@@ -82,9 +105,19 @@ namespace pimath
 			.def(bp::init<scalar_type, scalar_type>())
 			.def("cross", &vec_type::cross)
 			.def(bp::self % bp::self)
+			.def("__imul__", multMatrix<vec_type, Imath::M33d>)
 			;
 
-			boost::mpl::for_each<ScalarTypes>(Bind_T(cl));
+			Bind_T native(cl);
+			native(scalar_type());
+			bindFastCall<fastCross>(cl, "cross");
+		}
+
+		static PyObject* fastCross(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const vec_type* v = heldValue<vec_type>(self);
+			const vec_type* w = (nargs == 1)? heldValue<vec_type>(args[0]) : 0;
+			return (v && w)? toPython(v->cross(*w)) : 0;
 		}
 
 		static bp::tuple getValue(const vec_type &self) {
@@ -128,11 +161,23 @@ namespace pimath
 			.def(bp::init<scalar_type, scalar_type, scalar_type>())
 			.def("cross", &vec_type::cross)
 			.def(bp::self % bp::self)
-			.add_property("z", bp::make_getter(&vec_type::z, bp_ret_val()),
-				bp::make_setter(&vec_type::z))
+			.def("__init__", convertInit<vec_type, Imath::V4d>)
+			.def("__imul__", multMatrix<vec_type, Imath::M33d>)
+			.def("__imul__", multMatrix<vec_type, Imath::M44d>)
 			;
 
-			boost::mpl::for_each<ScalarTypes>(Bind_T(cl));
+			bindComponent<vec_type, scalar_type, &vec_type::z>(cl, "z");
+
+			Bind_T native(cl);
+			native(scalar_type());
+			bindFastCall<fastCross>(cl, "cross");
+		}
+
+		static PyObject* fastCross(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const vec_type* v = heldValue<vec_type>(self);
+			const vec_type* w = (nargs == 1)? heldValue<vec_type>(args[0]) : 0;
+			return (v && w)? toPython(v->cross(*w)) : 0;
 		}
 
 		static bp::tuple getValue(const vec_type &self) {
@@ -173,13 +218,15 @@ namespace pimath
 		{
 			cl
 			.def(bp::init<scalar_type, scalar_type, scalar_type, scalar_type>())
-			.add_property("z", bp::make_getter(&vec_type::z, bp_ret_val()),
-				bp::make_setter(&vec_type::z))
-			.add_property("w", bp::make_getter(&vec_type::w, bp_ret_val()),
-				bp::make_setter(&vec_type::w))
+			.def("__init__", convertInit<vec_type, Imath::V3d>)
+			.def("__imul__", multMatrix<vec_type, Imath::M44d>)
 			;
 
-			boost::mpl::for_each<ScalarTypes>(Bind_T(cl));
+			bindComponent<vec_type, scalar_type, &vec_type::z>(cl, "z");
+			bindComponent<vec_type, scalar_type, &vec_type::w>(cl, "w");
+
+			Bind_T native(cl);
+			native(scalar_type());
 		}
 
 		static bp::tuple getValue(const vec_type &self) {
@@ -188,7 +235,8 @@ namespace pimath
 	};
 
 
-	// Vec-common templatised bindings
+	// Vec-common templatised bindings, for the vector's own scalar type. Other scalar
+	// types are handled by the family overloads in VecBind.
 	template<typename Vec>
 	struct VecBind_T
 	{
@@ -200,11 +248,24 @@ namespace pimath
 		{
 			typedef typename imath_traits<vec_type>::template rebind<S>::type s_vec_type;
 
-			m_cl
-			.def(bp::init<s_vec_type>())
-			.def(bp::self == bp::other<s_vec_type>())
-			.def(bp::self != bp::other<s_vec_type>())
-			;
+			defDispatch(m_cl, "__init__", convertInit<s_vec_type>);
+			defDispatch(m_cl, "__eq__", equal<s_vec_type>);
+			defDispatch(m_cl, "__ne__", notEqual<s_vec_type>);
+		}
+
+		template<typename S>
+		static void convertInit(PyObject* self, const S& v) {
+			holdValue(self, vec_type(v));
+		}
+
+		template<typename S>
+		static bool equal(const vec_type& self, const S& v) {
+			return self == v;
+		}
+
+		template<typename S>
+		static bool notEqual(const vec_type& self, const S& v) {
+			return self != v;
 		}
 
 		VecBind_T(bp_class& cl):m_cl(cl){}
@@ -218,15 +279,21 @@ namespace pimath
 	{
 		typedef Vec 							vec_type;
 		typedef typename vec_type::BaseType 	scalar_type;
+		typedef typename family_of<vec_type>::type 	family_type;
 		typedef bp::class_<vec_type> 			bp_class;
+		typedef OutArgOps<vec_type, scalar_type> 	out_ops;
+		typedef SequenceSlots<vec_type, imath_traits<vec_type>::_dimensions,
+			&scalarItem<vec_type> > 					sequence_slots;
+		typedef NumberSlots<vec_type, scalar_type,
+			AddOp|SubtractOp|MultiplyOp|DivideOp|ScaleOp|NegateOp> 	number_slots;
 
 		VecBind(const char* name)
 		{
 			bp_class cl(name);
 			cl
 			.def(bp::init<scalar_type>())
-			.def("__init__", bp::make_constructor(defaultInit))
-			.def("__init__", bp::make_constructor(sequenceInit))
+			.def("__init__", defaultInit)
+			.def("__init__", sequenceInit)
 			.def("__getitem__", getItem)
 			.def("__setitem__", setItem)
 			.add_property("value", VecNBind<vec_type,ScalarTypes>::getValue, setValue)
@@ -248,7 +315,7 @@ namespace pimath
 			.def("negate", &vec_type::negate, bp_ret_none())
 			.def("normalize", &vec_type::normalize, bp_ret_none())
 			.def("normalizeExc", &vec_type::normalizeExc, bp_ret_none())
-			.def("normalized", &vec_type::normalized)
+			.def("normalized", normalized, (bp::arg("self"), bp::arg("out")=bp::object()))
 			.def("equalWithAbsError", &vec_type::equalWithAbsError)
 			.def("equalWithRelError", &vec_type::equalWithRelError)
 			.def("length", &vec_type::length)
@@ -258,27 +325,76 @@ namespace pimath
 			.def("dimensions", &vec_type::dimensions)
 			.staticmethod("dimensions")
 
-			// note: due to def_readwrite() not supporting custom to-python converters
-			.add_property("x", bp::make_getter(&vec_type::x, bp_ret_val()),
-				bp::make_setter(&vec_type::x))
-			.add_property("y", bp::make_getter(&vec_type::y, bp_ret_val()),
-				bp::make_setter(&vec_type::y))
+			.def("add", &out_ops::add, out_args())
+			.def("subtract", &out_ops::subtract, out_args())
+			.def("multiply", &out_ops::multiply, out_args())
+			.def("multiply", &out_ops::multiplyScalar, out_args())
+			.def("divide", &out_ops::divide, out_args())
+			.def("divide", &out_ops::divideScalar, out_args())
+			.staticmethod("add")
+			.staticmethod("subtract")
+			.staticmethod("multiply")
+			.staticmethod("divide")
 			;
 
+			bindComponent<vec_type, scalar_type, &vec_type::x>(cl, "x");
+			bindComponent<vec_type, scalar_type, &vec_type::y>(cl, "y");
 			bindBaseType<bp_class, vec_type>(cl);
+			bindInstancePool<bp_class, vec_type>(cl);
+			bindSequenceSlots<sequence_slots>(cl, "Vector index out of range.");
+			bindFastCall<fastDot>(cl, "dot");
+			bindFastCall<fastLength>(cl, "length");
+			bindFastCall<fastNormalized>(cl, "normalized");
 			VecNBind<vec_type, ScalarTypes>::bind(cl);
-			boost::mpl::for_each<ScalarTypes>(VecBind_T<vec_type>(cl));
+			bindFamilyMember<vec_type>(cl);
+			defDispatch(cl, "__init__", convertInit<vec_type, family_type>);
+			defDispatch(cl, "__eq__", familyEqual);
+			defDispatch(cl, "__ne__", familyNotEqual);
+			VecBind_T<vec_type> native(cl);
+			native(scalar_type());
+			bindNumberSlots<number_slots>(cl);
+		}
+
+		static bool familyEqual(const vec_type& self, const FamilyValue<family_type>& v) {
+			return family_type(self) == v.value;
+		}
+
+		static bool familyNotEqual(const vec_type& self, const FamilyValue<family_type>& v) {
+			return family_type(self) != v.value;
+		}
+
+		static void defaultInit(PyObject* self) {
+			holdValue(self, vec_type(scalar_type(0)));
 		}
 
-		static vec_type* defaultInit() {
-			return new vec_type(scalar_type(0));
+		static bp::object normalized(const vec_type& self, const bp::object& out) {
+			return assignOut(self.normalized(), out);
+		}
+
+		static PyObject* fastDot(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const vec_type* v = heldValue<vec_type>(self);
+			const vec_type* w = (nargs == 1)? heldValue<vec_type>(args[0]) : 0;
+			return (v && w)? toPython(v->dot(*w)) : 0;
+		}
+
+		static PyObject* fastLength(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const vec_type* v = heldValue<vec_type>(self);
+			return (v && (nargs == 0))? toPython(v->length()) : 0;
+		}
+
+		static PyObject* fastNormalized(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+		{
+			const vec_type* v = heldValue<vec_type>(self);
+			return (v && (nargs == 0))? toPython(v->normalized()) : 0;
 		}
 
-		static vec_type* sequenceInit(const bp::object &o)
+		static void sequenceInit(PyObject* self, const bp::object &o)
 		{
-			vec_type* v = new vec_type();
-			setValue(*v, o);
-			return v;
+			vec_type v;
+			setValue(v, o);
+			holdValue(self, v);
 		}
 
 		static scalar_type getItem(const vec_type& self, int i)
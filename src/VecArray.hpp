@@ -0,0 +1,502 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_VECARRAY__H_
+#define _PIMATH_VECARRAY__H_
+
+/*
+ * V3fArray and V3dArray are not part of Imath. They hold a contiguous array of V3f (V3d)
+ * points, for bulk operations which would otherwise cost a python call per point:
+ * transform(m) 		multiplies each point by M44f m in place (as M44f.multVecMatrix)
+ * transformDirs(m) 	as transform, but as M44f.multDirMatrix
+ * normalize() 			normalizes each point in place (as V3f.normalize)
+ * bounds() 			returns the Box3f enclosing all points
+ * mean(), covariance() return the V3d mean and M33d covariance of the points, summed in
+ * 						double with compensation, and in parallel
+ * fitObb() 			returns (frame, halfExtents), an oriented box around the points along
+ * 						their principal axes: frame is an M44f whose rows are the box's axes
+ * 						and whose translation is its center
+ * lerp(a, b, t) 		returns a new array, a[i]*(1-t) + b[i]*t; t is a number, or a
+ * 						FloatArray (DoubleArray) of a weight per point
+ * faceNormals(triangles) 	returns the unit normal of each triangle of a mesh, whose
+ * 						vertices these are and whose IntArray 'triangles' holds three
+ * 						vertex indices per face
+ * vertexNormals(triangles[, weighting])
+ * 						returns the unit normal of each vertex, summing its faces' normals
+ * 						weighted by NormalWeighting.AreaWeighted (the default) or
+ * 						AngleWeighted
+ * weld(tolerance[, normals, normalTolerance, uvs, uvTolerance])
+ * 						merges points within tolerance of each other (as equalWithAbsError),
+ * 						and optionally with matching normals (a V3fArray) and uvs (a
+ * 						V2fArray). Returns (remap, points, normals, uvs): remap is an
+ * 						IntArray giving each point's index in the new, unique arrays, and
+ * 						normals and uvs are None if they weren't given.
+ * clipTriangles(planes), clipTriangles(box)
+ * 						clip a triangle soup (three points per triangle) to a Box3f, or to
+ * 						the region behind a sequence of Plane3f (where distanceTo <= 0), eg
+ * 						the outward facing Frustumf.planes(), in parallel. Returns
+ * 						(points, sources, barycentrics): the clipped triangles as a soup, an
+ * 						IntArray of the triangle each came from, and each new point's weights
+ * 						in its source triangle, for interpolating other attributes. Triangles
+ * 						of zero area are left out.
+ * solidSphereRand(n, seed), hollowSphereRand(n, seed), gaussSphereRand(n, seed)
+ * 						return a new array of n samples, as the Imath functions. They run
+ * 						in parallel without the GIL, and depend only on n and seed.
+ * These are wrappers over the C++ kernel library in kernels/, whose float kernels use
+ * the SIMD level selected at import, and give the same results as their per-point
+ * equivalents.
+ *
+ * IntArray, FloatArray and DoubleArray are the matching arrays of scalars, which bulk
+ * queries (eg KdTree3f.nearest) write their results into, and V2fArray holds V2f values
+ * such as texture coordinates. They only support len() and indexing.
+ */
+
+#include <vector>
+#include "kernels/kernels.hpp"
+#include "util.h"
+
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	template<typename T>
+	class Vec3Array
+	{
+	public:
+
+		typedef T 						scalar_type;
+		typedef Imath::Vec3<T> 			vec_type;
+
+		Vec3Array(std::size_t n = 0)
+		:	m_data(n, vec_type(T(0)))
+		{}
+
+		std::size_t size() const 					{ return m_data.size(); }
+		vec_type* data() 							{ return m_data.empty()? 0 : &m_data[0]; }
+		const vec_type* data() const 				{ return m_data.empty()? 0 : &m_data[0]; }
+
+		const vec_type& get(std::size_t i) const 	{ return m_data[i]; }
+		void set(std::size_t i, const vec_type& v) 	{ m_data[i] = v; }
+		void append(const vec_type& v) 				{ m_data.push_back(v); }
+		void swap(Vec3Array& a) 					{ m_data.swap(a.m_data); }
+		void swap(std::vector<vec_type>& v) 		{ m_data.swap(v); }
+
+	protected:
+
+		std::vector<vec_type> m_data;
+	};
+
+
+	template<typename T>
+	class ValueArray
+	{
+	public:
+
+		typedef T 						value_type;
+
+		ValueArray(std::size_t n = 0)
+		:	m_data(n, T(0))
+		{}
+
+		std::size_t size() const 					{ return m_data.size(); }
+		T* data() 									{ return m_data.empty()? 0 : &m_data[0]; }
+		const T* data() const 						{ return m_data.empty()? 0 : &m_data[0]; }
+
+		T get(std::size_t i) const 					{ return m_data[i]; }
+		void set(std::size_t i, T v) 				{ m_data[i] = v; }
+		void append(T v) 							{ m_data.push_back(v); }
+		void swap(ValueArray& a) 					{ m_data.swap(a.m_data); }
+		void swap(std::vector<T>& v) 				{ m_data.swap(v); }
+
+	protected:
+
+		std::vector<T> m_data;
+	};
+
+
+	// thin wrappers over the kernel library (see kernels/kernels.hpp)
+	template<typename T>
+	struct Vec3ArrayKernels
+	{
+		typedef Vec3Array<T> 					array_type;
+		typedef Imath::Matrix44<T> 				matrix_type;
+		typedef Imath::Box<Imath::Vec3<T> > 	box_type;
+
+		static void transform(array_type& a, const matrix_type& m) {
+			kernels::transformPoints(m, a.data(), a.data(), a.size());
+		}
+
+		static void transformDirs(array_type& a, const matrix_type& m) {
+			kernels::transformDirs(m, a.data(), a.data(), a.size());
+		}
+
+		static void normalize(array_type& a) {
+			kernels::normalize(a.data(), a.size());
+		}
+
+		static box_type bounds(const array_type& a) {
+			return kernels::bounds(a.data(), a.size());
+		}
+
+		static void lerp(const array_type& a, const array_type& b, T t, array_type& result) {
+			kernels::lerp(a.data(), b.data(), t, result.data(), result.size());
+		}
+
+		static void lerp(const array_type& a, const array_type& b, const ValueArray<T>& t,
+			array_type& result)
+		{
+			kernels::lerp(a.data(), b.data(), t.data(), result.data(), result.size());
+		}
+
+		// a fixed number of generators, so results don't vary with the thread count
+		enum { RandStreams = 64 };
+
+		typedef void (*sample_fn)(Imath::Vec3<T>*, std::size_t, kernels::ThreadRand<Imath::Rand48>&);
+
+		template<sample_fn Fn>
+		static void sample(array_type& a, unsigned long seed)
+		{
+			kernels::ThreadRand<Imath::Rand48> rands(seed, RandStreams);
+			Fn(a.data(), a.size(), rands);
+		}
+	};
+
+
+	template<typename T>
+	struct Vec3ArrayBind
+	{
+		typedef Vec3Array<T> 					array_type;
+		typedef Imath::Vec3<T> 					vec_type;
+		typedef Vec3ArrayKernels<T> 			array_kernels;
+		typedef bp::class_<array_type> 			bp_class;
+
+		Vec3ArrayBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<std::size_t>())
+			.def("__init__", bp::make_constructor(sequenceInit))
+			.def("__len__", &array_type::size)
+			.def("__getitem__", getItem)
+			.def("__setitem__", setItem)
+			.def("transform", &array_kernels::transform)
+			.def("transformDirs", &array_kernels::transformDirs)
+			.def("normalize", &array_kernels::normalize)
+			.def("bounds", &array_kernels::bounds)
+			.def("mean", mean)
+			.def("covariance", covariance)
+			.def("fitObb", fitObb)
+			.def("lerp", lerp)
+			.def("lerp", lerpWeighted)
+			.staticmethod("lerp")
+			.def("faceNormals", faceNormals)
+			.def("vertexNormals", vertexNormals,
+				(bp::arg("triangles"), bp::arg("weighting")=kernels::AreaWeighted))
+			.def("weld", weld, (bp::arg("tolerance"), bp::arg("normals")=bp::object(),
+				bp::arg("normalTolerance")=T(0), bp::arg("uvs")=bp::object(),
+				bp::arg("uvTolerance")=T(0)))
+			.def("clipTriangles", clipToPlanes, (bp::arg("planes")))
+			.def("clipTriangles", clipToBox, (bp::arg("box")))
+			.def("solidSphereRand", sample<&kernels::solidSphereRand<vec_type, Imath::Rand48> >)
+			.staticmethod("solidSphereRand")
+			.def("hollowSphereRand", sample<&kernels::hollowSphereRand<vec_type, Imath::Rand48> >)
+			.staticmethod("hollowSphereRand")
+			.def("gaussSphereRand", sample<&kernels::gaussSphereRand<vec_type, Imath::Rand48> >)
+			.staticmethod("gaussSphereRand")
+			;
+		}
+
+		static array_type* sequenceInit(const bp::object& seq)
+		{
+			array_type a;
+			const std::size_t n = bp::len(seq);
+			for(std::size_t i=0; i<n; ++i)
+				a.append(bp::extract<vec_type>(seq[i]));
+
+			array_type* result = new array_type();
+			result->swap(a);
+			return result;
+		}
+
+		static std::size_t index(const array_type& self, int i)
+		{
+			if(i < 0)
+				i += static_cast<int>(self.size());
+			if((i<0) || (i>=(int)self.size()))
+				PIMATH_THROW(PyExc_IndexError, "Vec3 array index out of range.");
+			return i;
+		}
+
+		static array_type lerp(const array_type& a, const array_type& b, T t)
+		{
+			if(a.size() != b.size())
+				PIMATH_THROW(PyExc_ValueError, "Vec3 arrays must be the same size.");
+
+			array_type result(a.size());
+			array_kernels::lerp(a, b, t, result);
+			return result;
+		}
+
+		static array_type lerpWeighted(const array_type& a, const array_type& b,
+			const ValueArray<T>& t)
+		{
+			if((a.size() != b.size()) || (a.size() != t.size()))
+				PIMATH_THROW(PyExc_ValueError, "Vec3 arrays and weights must be the same size.");
+
+			array_type result(a.size());
+			array_kernels::lerp(a, b, t, result);
+			return result;
+		}
+
+		static Imath::V3d mean(const array_type& self)
+		{
+			ReleaseGIL nogil;
+			return kernels::mean(self.data(), self.size());
+		}
+
+		static Imath::M33d covariance(const array_type& self)
+		{
+			ReleaseGIL nogil;
+			return kernels::covariance(self.data(), self.size(),
+				kernels::mean(self.data(), self.size()));
+		}
+
+		static bp::tuple fitObb(const array_type& self)
+		{
+			Imath::Matrix44<T> frame;
+			vec_type halfExtents;
+			{
+				ReleaseGIL nogil;
+				kernels::fitObb(self.data(), self.size(), frame, halfExtents);
+			}
+			return bp::make_tuple(frame, halfExtents);
+		}
+
+		static void checkTriangles(const array_type& self, const ValueArray<int>& triangles)
+		{
+			if(triangles.size() % 3)
+				PIMATH_THROW(PyExc_ValueError, "Triangle arrays must hold three indices per face.");
+
+			const int* t = triangles.data();
+			for(std::size_t i=0; i<triangles.size(); ++i)
+			{
+				if((t[i] < 0) || (std::size_t(t[i]) >= self.size()))
+					PIMATH_THROW(PyExc_IndexError, "Triangle vertex index out of range.");
+			}
+		}
+
+		static array_type faceNormals(const array_type& self, const ValueArray<int>& triangles)
+		{
+			checkTriangles(self, triangles);
+
+			array_type result(triangles.size() / 3);
+			{
+				ReleaseGIL nogil;
+				kernels::faceNormals(self.data(), triangles.data(), result.size(), result.data());
+			}
+			return result;
+		}
+
+		static array_type vertexNormals(const array_type& self, const ValueArray<int>& triangles,
+			kernels::NormalWeighting weighting)
+		{
+			checkTriangles(self, triangles);
+
+			array_type result(self.size());
+			{
+				ReleaseGIL nogil;
+				kernels::vertexNormals(self.data(), self.size(), triangles.data(),
+					triangles.size() / 3, weighting, result.data());
+			}
+			return result;
+		}
+
+		static bp::tuple clipToPlanes(const array_type& self, const bp::object& planesObj)
+		{
+			const std::size_t nPlanes = bp::len(planesObj);
+			std::vector<Imath::Plane3<T> > planes(nPlanes);
+			for(std::size_t i=0; i<nPlanes; ++i)
+				planes[i] = bp::extract<Imath::Plane3<T> >(planesObj[i]);
+
+			checkSoup(self);
+			kernels::ClippedTriangles<T> clipped;
+			{
+				ReleaseGIL nogil;
+				kernels::clipTriangles(self.data(), self.size() / 3, nPlanes? &planes[0] : 0, nPlanes,
+					clipped);
+			}
+			return clippedTuple(clipped);
+		}
+
+		static bp::tuple clipToBox(const array_type& self, const Imath::Box<vec_type>& box)
+		{
+			checkSoup(self);
+			kernels::ClippedTriangles<T> clipped;
+			{
+				ReleaseGIL nogil;
+				kernels::clipTriangles(self.data(), self.size() / 3, box, clipped);
+			}
+			return clippedTuple(clipped);
+		}
+
+		static void checkSoup(const array_type& self)
+		{
+			if(self.size() % 3)
+				PIMATH_THROW(PyExc_ValueError, "Triangle soups must hold three points per triangle.");
+		}
+
+		static bp::tuple clippedTuple(kernels::ClippedTriangles<T>& clipped)
+		{
+			array_type points, barycentrics;
+			ValueArray<int> sources;
+			points.swap(clipped.points);
+			sources.swap(clipped.sources);
+			barycentrics.swap(clipped.barycentrics);
+			return bp::make_tuple(points, sources, barycentrics);
+		}
+
+		static bp::tuple weld(const array_type& self, T tolerance, const bp::object& normalsObj,
+			T normalTolerance, const bp::object& uvsObj, T uvTolerance)
+		{
+			typedef ValueArray<Imath::Vec2<T> > 	uv_array_type;
+
+			const array_type* normals = 0;
+			const uv_array_type* uvs = 0;
+			if(!normalsObj.is_none())
+				normals = &bp::extract<const array_type&>(normalsObj)();
+			if(!uvsObj.is_none())
+				uvs = &bp::extract<const uv_array_type&>(uvsObj)();
+			if((normals && (normals->size() != self.size())) || (uvs && (uvs->size() != self.size())))
+				PIMATH_THROW(PyExc_ValueError, "Vertex attributes must be the same size as the points.");
+
+			const std::size_t n = self.size();
+			ValueArray<int> remap(n);
+			std::vector<int> first(n);
+			std::size_t unique;
+			{
+				ReleaseGIL nogil;
+				unique = kernels::weld(self.data(), n, tolerance, remap.data(),
+					first.empty()? 0 : &first[0], normals? normals->data() : 0, normalTolerance,
+					uvs? uvs->data() : 0, uvTolerance);
+			}
+
+			array_type points(unique);
+			for(std::size_t k=0; k<unique; ++k)
+				points.set(k, self.get(first[k]));
+
+			bp::object uniqueNormals, uniqueUvs;
+			if(normals)
+			{
+				array_type a(unique);
+				for(std::size_t k=0; k<unique; ++k)
+					a.set(k, normals->get(first[k]));
+				uniqueNormals = bp::object(a);
+			}
+			if(uvs)
+			{
+				uv_array_type a(unique);
+				for(std::size_t k=0; k<unique; ++k)
+					a.set(k, uvs->get(first[k]));
+				uniqueUvs = bp::object(a);
+			}
+
+			return bp::make_tuple(remap, points, uniqueNormals, uniqueUvs);
+		}
+
+		template<typename array_kernels::sample_fn Fn>
+		static array_type sample(std::size_t n, unsigned long seed)
+		{
+			array_type result(n);
+			{
+				ReleaseGIL nogil;
+				array_kernels::template sample<Fn>(result, seed);
+			}
+			return result;
+		}
+
+		static vec_type getItem(const array_type& self, int i) {
+			return self.get(index(self, i));
+		}
+
+		static void setItem(array_type& self, int i, const vec_type& v) {
+			self.set(index(self, i), v);
+		}
+	};
+
+
+	template<typename T>
+	struct ValueArrayBind
+	{
+		typedef ValueArray<T> 					array_type;
+		typedef bp::class_<array_type> 			bp_class;
+
+		ValueArrayBind(const char* name)
+		{
+			bp_class cl(name, bp::no_init);
+			cl
+			.def(bp::init<std::size_t>())
+			.def("__init__", bp::make_constructor(sequenceInit))
+			.def("__len__", &array_type::size)
+			.def("__getitem__", getItem)
+			.def("__setitem__", setItem)
+			;
+		}
+
+		static array_type* sequenceInit(const bp::object& seq)
+		{
+			array_type a;
+			const std::size_t n = bp::len(seq);
+			for(std::size_t i=0; i<n; ++i)
+				a.append(bp::extract<T>(seq[i]));
+
+			array_type* result = new array_type();
+			result->swap(a);
+			return result;
+		}
+
+		static std::size_t index(const array_type& self, int i)
+		{
+			if(i < 0)
+				i += static_cast<int>(self.size());
+			if((i<0) || (i>=(int)self.size()))
+				PIMATH_THROW(PyExc_IndexError, "Array index out of range.");
+			return i;
+		}
+
+		static T getItem(const array_type& self, int i) {
+			return self.get(index(self, i));
+		}
+
+		static void setItem(array_type& self, int i, T v) {
+			self.set(index(self, i), v);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_COMPONENTS__H_
+#define _PIMATH_COMPONENTS__H_
+
+#include <boost/python.hpp>
+#include "util.h"
+
+
+/*
+ * Component attributes (v.x, c.r, q.r etc) are the most frequently accessed attributes of
+ * all. A property built with bp::make_getter/make_setter goes through a boost.python
+ * function call and the converter registry on every access. bindComponent instead adds
+ * a native getset descriptor, which reads and writes the member directly and converts
+ * float and int values inline. Other values (eg numpy scalars) are converted through the
+ * registry as before.
+ */
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	template<typename T, typename S, S T::*Member>
+	struct Component
+	{
+		static PyGetSetDef s_def;
+
+		static PyObject* get(PyObject* self, void*)
+		{
+			const T* p = heldValue<T>(self);
+			if(!p)
+			{
+				PyErr_SetString(PyExc_TypeError, "Component of an uninitialised object.");
+				return NULL;
+			}
+
+			try {
+				return toPython(p->*Member);
+			}
+			catch(const bp::error_already_set&) {
+				return NULL;
+			}
+		}
+
+		static int set(PyObject* self, PyObject* value, void*)
+		{
+			T* p = heldValue<T>(self);
+			if(!p || !value)
+			{
+				PyErr_SetString(PyExc_TypeError, (value)?
+					"Component of an uninitialised object." : "Components cannot be deleted.");
+				return -1;
+			}
+
+			S s;
+			if(!fromPython(value, s))
+			{
+				try
+				{
+					bp::extract<S> e(value);
+					if(!e.check())
+					{
+						PyErr_SetString(PyExc_TypeError, "Component value must be a number.");
+						return -1;
+					}
+					s = e();
+				}
+				catch(const bp::error_already_set&) {
+					return -1;
+				}
+			}
+
+			p->*Member = s;
+			return 0;
+		}
+	};
+
+	template<typename T, typename S, S T::*Member>
+	PyGetSetDef Component<T,S,Member>::s_def = {
+		0, Component<T,S,Member>::get, Component<T,S,Member>::set, 0, 0
+	};
+
+
+	// adds the read/write attribute 'name' for the member of T
+	template<typename T, typename S, S T::*Member, typename BpClass>
+	void bindComponent(BpClass& cl, const char* name)
+	{
+		typedef Component<T,S,Member> component_type;
+		component_type::s_def.name = const_cast<char*>(name);
+
+		bp::handle<> descr(PyDescr_NewGetSet(reinterpret_cast<PyTypeObject*>(cl.ptr()),
+			&component_type::s_def));
+		if(PyObject_SetAttrString(cl.ptr(), name, descr.get()) < 0)
+			bp::throw_error_already_set();
+	}
+
+}
+
+#endif
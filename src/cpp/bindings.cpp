@@ -28,15 +28,23 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/python.hpp>
 #include <ImathPlatform.h>
+#include <map>
+#include <string>
+#include <sstream>
 
 
 extern void _pimath_export_half();
 extern void _pimath_export_box();
+extern void _pimath_export_capi();
 extern void _pimath_export_boxAlgo();
 extern void _pimath_export_color();
 extern void _pimath_export_colorAlgo();
+extern void _pimath_export_colorArray();
+extern void _pimath_export_dispatch();
+extern void _pimath_export_fastcall();
 extern void _pimath_export_frame();
 extern void _pimath_export_frustum();
+extern void _pimath_export_instancePool();
 extern void _pimath_export_interval();
 extern void _pimath_export_line();
 extern void _pimath_export_lineAlgo();
@@ -45,11 +53,19 @@ extern void _pimath_export_quat();
 extern void _pimath_export_random();
 extern void _pimath_export_roots();
 extern void _pimath_export_shear();
+extern void _pimath_export_simd();
 extern void _pimath_export_sphere();
+extern void _pimath_export_stats();
+extern void _pimath_instrument_stats();
+extern void _pimath_export_threads();
 extern void _pimath_export_vec2();
 extern void _pimath_export_vec3();
 extern void _pimath_export_vec4();
 extern void _pimath_export_vecAlgo();
+extern void _pimath_export_vecArray();
+extern void _pimath_export_kdTree();
+extern void _pimath_export_hashGrid();
+extern void _pimath_export_octree();
 extern void _pimath_export_matrix33();
 extern void _pimath_export_matrix44();
 extern void _pimath_export_euler();
@@ -58,34 +74,307 @@ extern void _pimath_export_exc();
 
 namespace bp = boost::python;
 
+
+namespace {
+
+	typedef void (*export_fn)();
+
+	// A group of bindings which is registered on first use, rather than at import. Each
+	// group is also exposed as a submodule (pimath.vec etc), although its contents are
+	// always bound into the pimath namespace itself, so that overloads of the same name
+	// chain together and __module__ stays 'pimath' (which pickling relies on). 'deps' are
+	// groups whose classes must be registered first, eg as bases or in converters.
+	struct LazyGroup
+	{
+		const char* 	name;
+		export_fn 		exports[20];	// NULL-terminated
+		int 			deps[3];		// -1-terminated
+		const char* 	names;			// public names this group provides
+		bool 			loaded;
+	};
+
+	enum { VecGroup, MatrixGroup, ColorGroup, GeomGroup, RandomGroup, NumGroups };
+
+	LazyGroup g_groups[NumGroups] =
+	{
+		{ "vec",
+			{ _pimath_export_vec3, _pimath_export_vec2, _pimath_export_vec4, NULL },
+			{ -1 },
+			"V2i V2f V2d V2h V3i V3f V3d V3h V4i V4f V4d V4h",
+			false
+		},
+		{ "matrix",
+			{ _pimath_export_quat, _pimath_export_shear, _pimath_export_matrix33,
+				_pimath_export_matrix44, _pimath_export_euler, _pimath_export_matrixAlgo, NULL },
+			{ VecGroup, -1 },
+			"M33f M33d M33h M44f M44d M44h Shear6f Shear6d Quatf Quatd Eulerf Eulerd "
+			"angle4D intermediate slerp slerpShortestArc spline squad "
+			"alignZAxisWithTargetDir extractEuler extractEulerSHRT extractEulerXYZ "
+			"extractEulerZYX extractQuat extractSHRT extractScaling extractScalingAndShear "
+			"rotationMatrix rotationMatrixWithUpDir withoutScaling withoutScalingAndShear "
+			"jacobiEigenSolve",
+			false
+		},
+		{ "color",
+			{ _pimath_export_color, _pimath_export_colorAlgo, _pimath_export_colorArray, NULL },
+			{ VecGroup, -1 },
+			"C3f C3h C4c C4f C4h ArrayLayout C4cArray C4hArray C4fArray "
+			"hsv2rgb hsv2rgb_d packed2rgb packed2rgba rgb2hsv rgb2hsv_d rgb2packed",
+			false
+		},
+		{ "geom",
+			{ _pimath_export_box, _pimath_export_boxAlgo, _pimath_export_frame,
+				_pimath_export_frustum, _pimath_export_interval, _pimath_export_line,
+				_pimath_export_lineAlgo, _pimath_export_plane, _pimath_export_sphere,
+				_pimath_export_vecAlgo, _pimath_export_vecArray, _pimath_export_kdTree,
+				_pimath_export_hashGrid, _pimath_export_octree, NULL },
+			{ VecGroup, MatrixGroup, -1 },
+			"Box2i Box2f Box2d Box2h Box3i Box3f Box3d Box3h "
+			"Intervalf Intervald Intervals Intervali Intervalh Line3f Line3d Line3h "
+			"Plane3f Plane3d Plane3h PlaneSide Sphere3f Sphere3d Sphere3h SphereFit Frustumf Frustumd "
+			"V3fArray V3dArray V2fArray IntArray FloatArray DoubleArray NormalWeighting "
+			"KdTree3f KdTree3d HashGrid3f PointOctree PointOctreeWriter "
+			"affineTransform clip closestPointInBox closestPointOnBox entryAndExitPoints "
+			"intersection transform closestPoints closestVertex intersect rotatePoint "
+			"orthogonal project reflect firstFrame lastFrame nextFrame",
+			false
+		},
+		{ "random",
+			{ _pimath_export_random, _pimath_export_roots, NULL },
+			{ VecGroup, -1 },
+			"Rand32 Rand48 gaussRand "
+			"solidSphereRand2f solidSphereRand2d solidSphereRand2h "
+			"solidSphereRand3f solidSphereRand3d solidSphereRand3h "
+			"solidSphereRand4f solidSphereRand4d solidSphereRand4h "
+			"hollowSphereRand2f hollowSphereRand2d hollowSphereRand2h "
+			"hollowSphereRand3f hollowSphereRand3d hollowSphereRand3h "
+			"hollowSphereRand4f hollowSphereRand4d hollowSphereRand4h "
+			"gaussSphereRand2f gaussSphereRand2d gaussSphereRand2h "
+			"gaussSphereRand3f gaussSphereRand3d gaussSphereRand3h "
+			"gaussSphereRand4f gaussSphereRand4d gaussSphereRand4h "
+			"solveCubic solveLinear solveNormalizedCubic solveQuadratic",
+			false
+		}
+	};
+
+	// these live as long as the interpreter, so are deliberately never released
+	PyObject* g_module = NULL;
+	PyObject* g_submodules[NumGroups];
+	std::map<std::string, int> g_nameGroups;
+
+	// the exception a group failed to load with, raised again on every later use of it
+	struct GroupFailure
+	{
+		PyObject* 	type;
+		PyObject* 	value;
+		PyObject* 	traceback;
+	};
+
+	GroupFailure g_failures[NumGroups];
+
+
+	// the passes which finalise newly bound functions and classes
+	void postPass()
+	{
+		_pimath_export_dispatch();
+		_pimath_export_fastcall();
+		_pimath_instrument_stats();
+	}
+
+
+	void loadGroup(int group)
+	{
+		LazyGroup& g = g_groups[group];
+		GroupFailure& failure = g_failures[group];
+		if(failure.type)
+		{
+			// Exports aren't idempotent - running them again would register classes and
+			// converters twice - so a group which failed is never retried.
+			Py_INCREF(failure.type);
+			Py_XINCREF(failure.value);
+			Py_XINCREF(failure.traceback);
+			PyErr_Restore(failure.type, failure.value, failure.traceback);
+			bp::throw_error_already_set();
+		}
+		if(g.loaded)
+			return;
+		// marked up front, so that a cycle through the deps ends here
+		g.loaded = true;
+
+		try
+		{
+			for(int i=0; g.deps[i] >= 0; ++i)
+				loadGroup(g.deps[i]);
+
+			bp::scope within(bp::object(bp::handle<>(bp::borrowed(g_module))));
+			bp::dict dict(bp::handle<>(bp::borrowed(PyModule_GetDict(g_module))));
+			bp::dict before = dict.copy();
+
+			for(int i=0; g.exports[i]; ++i)
+				g.exports[i]();
+			postPass();
+
+			// populate the submodule with everything the group added
+			bp::list keys = dict.keys();
+			for(bp::ssize_t i=0; i<bp::len(keys); ++i)
+			{
+				bp::object key = keys[i];
+				if(!before.has_key(key) && PyObject_SetAttr(g_submodules[group], key.ptr(),
+					bp::object(dict[key]).ptr()) < 0)
+				{
+					bp::throw_error_already_set();
+				}
+			}
+		}
+		catch(...)
+		{
+			// keep the error, including those from c++, to raise again
+			bp::handle_exception();
+			PyErr_Fetch(&failure.type, &failure.value, &failure.traceback);
+			PyErr_NormalizeException(&failure.type, &failure.value, &failure.traceback);
+			Py_INCREF(failure.type);
+			Py_XINCREF(failure.value);
+			Py_XINCREF(failure.traceback);
+			PyErr_Restore(failure.type, failure.value, failure.traceback);
+			bp::throw_error_already_set();
+		}
+	}
+
+
+	void loadAllGroups()
+	{
+		for(int i=0; i<NumGroups; ++i)
+			loadGroup(i);
+	}
+
+
+#if PY_VERSION_HEX >= 0x03070000
+
+	bp::object lookup(PyObject* module, const std::string& name)
+	{
+		PyObject* value = PyDict_GetItemString(PyModule_GetDict(module), name.c_str());
+		if(!value)
+		{
+			PyErr_Format(PyExc_AttributeError, "module '%s' has no attribute '%s'",
+				PyModule_GetName(module), name.c_str());
+			bp::throw_error_already_set();
+		}
+		return bp::object(bp::handle<>(bp::borrowed(value)));
+	}
+
+
+	// pimath.__getattr__, called for names not yet bound. A name no group provides raises
+	// AttributeError without loading anything, so hasattr probes keep groups unloaded.
+	bp::object moduleGetattr(const std::string& name)
+	{
+		std::map<std::string, int>::const_iterator it = g_nameGroups.find(name);
+		if(it != g_nameGroups.end())
+			loadGroup(it->second);
+
+		return lookup(g_module, name);
+	}
+
+
+	bp::list moduleDir()
+	{
+		bp::list result(bp::handle<>(PyDict_Keys(PyModule_GetDict(g_module))));
+		for(std::map<std::string, int>::const_iterator it=g_nameGroups.begin();
+			it!=g_nameGroups.end(); ++it)
+		{
+			if(!g_groups[it->second].loaded)
+				result.append(it->first);
+		}
+		result.sort();
+		return result;
+	}
+
+
+	// pimath.<group>.__getattr__
+	struct GroupGetattr
+	{
+		GroupGetattr(int group):m_group(group){}
+
+		bp::object operator()(const std::string& name) const
+		{
+			if(name.compare(0, 2, "__") != 0)
+				loadGroup(m_group);
+			return lookup(g_submodules[m_group], name);
+		}
+
+		int m_group;
+	};
+
+#endif
+}
+
+
+// registers every group, for the native api (see capi.cpp)
+void _pimath_load_groups() {
+	loadAllGroups();
+}
+
+
 BOOST_PYTHON_MODULE(pimath)
 {
 	bp::scope().attr("M_PI") = M_PI;
 	bp::scope().attr("M_PI_2") = M_PI_2;
 
 	_pimath_export_half();
-	_pimath_export_box();
-	_pimath_export_boxAlgo();
-	_pimath_export_vec3();
-	_pimath_export_color();
-	_pimath_export_colorAlgo();
-	_pimath_export_frame();
-	_pimath_export_frustum();
-	_pimath_export_interval();
-	_pimath_export_line();
-	_pimath_export_lineAlgo();
-	_pimath_export_plane();
-	_pimath_export_quat();
-	_pimath_export_random();
-	_pimath_export_roots();
-	_pimath_export_shear();
-	_pimath_export_sphere();
-	_pimath_export_vec2();
-	_pimath_export_vec4();
-	_pimath_export_vecAlgo();
-	_pimath_export_matrix33();
-	_pimath_export_matrix44();
-	_pimath_export_euler();
-	_pimath_export_matrixAlgo();
 	_pimath_export_exc();
+	_pimath_export_instancePool();
+	_pimath_export_stats();
+	_pimath_export_simd();
+	_pimath_export_capi();
+	_pimath_export_threads();
+	postPass();
+
+	bp::object module = bp::scope();
+	bp::object sysModules = bp::import("sys").attr("modules");
+	g_module = bp::incref(module.ptr());
+
+	for(int i=0; i<NumGroups; ++i)
+	{
+		std::string name = std::string("pimath.") + g_groups[i].name;
+		bp::object submodule(bp::handle<>(PyModule_New(const_cast<char*>(name.c_str()))));
+		module.attr(g_groups[i].name) = submodule;
+		sysModules[name] = submodule;
+		g_submodules[i] = bp::incref(submodule.ptr());
+
+		std::istringstream strm(g_groups[i].names);
+		std::string s;
+		while(strm >> s)
+			g_nameGroups[s] = i;
+	}
+
+#if PY_VERSION_HEX >= 0x03070000
+	// groups are registered on first access (PEP 562)
+	bp::list all;
+	bp::list keys(bp::handle<>(PyDict_Keys(PyModule_GetDict(g_module))));
+	for(bp::ssize_t i=0; i<bp::len(keys); ++i)
+	{
+		std::string key = bp::extract<std::string>(keys[i]);
+		if(key[0] != '_')
+			all.append(key);
+	}
+	for(std::map<std::string, int>::const_iterator it=g_nameGroups.begin();
+		it!=g_nameGroups.end(); ++it)
+	{
+		all.append(it->first);
+	}
+	all.sort();
+	module.attr("__all__") = all;
+
+	bp::def("__getattr__", moduleGetattr);
+	bp::def("__dir__", moduleDir);
+
+	for(int i=0; i<NumGroups; ++i)
+	{
+		bp::object getattr = bp::make_function(GroupGetattr(i),
+			bp::default_call_policies(), boost::mpl::vector2<bp::object, std::string>());
+		if(PyObject_SetAttrString(g_submodules[i], "__getattr__", getattr.ptr()) < 0)
+			bp::throw_error_already_set();
+	}
+#else
+	loadAllGroups();
+#endif
 }
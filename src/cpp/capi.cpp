@@ -0,0 +1,189 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../pimath_api.h"
+#include "../VecArray.hpp"
+#include "../kernels/simd.hpp"
+#include <boost/python.hpp>
+#include <ImathVec.h>
+#include <ImathMatrix.h>
+#include <ImathQuat.h>
+#include <ImathBox.h>
+#include <ImathColor.h>
+
+using namespace pimath;
+namespace bp = boost::python;
+
+extern void _pimath_load_groups();
+
+
+namespace {
+
+	struct ApiType
+	{
+		const char* 							name;
+		const bp::converter::registration* 		reg;
+	};
+
+	ApiType g_types[PIMATH_NUM_TYPES];
+
+
+	template<typename T>
+	void addType(int type, const char* name)
+	{
+		g_types[type].name = name;
+		g_types[type].reg = &bp::converter::registered<T>::converters;
+	}
+
+
+	// the registrations exist before their classes are bound, but an object of the type
+	// can only exist once its group has loaded
+	void* lvalue(PyObject* obj, int type)
+	{
+		if((type < 0) || (type >= PIMATH_NUM_TYPES) || !obj)
+			return NULL;
+		return bp::converter::get_lvalue_from_python(obj, *g_types[type].reg);
+	}
+
+	int check(PyObject* obj, int type) {
+		return lvalue(obj, type)? 1 : 0;
+	}
+
+	void* data(PyObject* obj, int type)
+	{
+		void* p = lvalue(obj, type);
+		if(!p)
+		{
+			if((type < 0) || (type >= PIMATH_NUM_TYPES))
+				PyErr_Format(PyExc_TypeError, "Invalid pimath type %d.", type);
+			else
+				PyErr_Format(PyExc_TypeError, "Expected a pimath.%s.", g_types[type].name);
+		}
+		return p;
+	}
+
+	PyObject* fromValue(int type, const void* value)
+	{
+		if((type < 0) || (type >= PIMATH_NUM_TYPES))
+		{
+			PyErr_Format(PyExc_TypeError, "Invalid pimath type %d.", type);
+			return NULL;
+		}
+
+		// c++ exceptions must not cross the api
+		try
+		{
+			_pimath_load_groups();
+			return g_types[type].reg->to_python(value);
+		}
+		catch(...)
+		{
+			bp::handle_exception();
+			return NULL;
+		}
+	}
+
+	float* v3fArrayData(PyObject* obj, size_t* n)
+	{
+		void* p = obj? bp::converter::get_lvalue_from_python(obj,
+			bp::converter::registered<Vec3Array<float> >::converters) : NULL;
+		if(!p)
+		{
+			if(n)
+				*n = 0;
+			PyErr_SetString(PyExc_TypeError, "Expected a pimath.V3fArray.");
+			return NULL;
+		}
+
+		Vec3Array<float>* a = static_cast<Vec3Array<float>*>(p);
+		if(n)
+			*n = a->size();
+		return a->size()? &a->data()->x : NULL;
+	}
+
+
+	void transformPoints(const float* m, const float* src, float* dst, size_t n) {
+		kernels::simdKernels().transformPoints(m, src, dst, n);
+	}
+
+	void bounds(const float* p, size_t n, float* min, float* max) {
+		kernels::simdKernels().bounds(p, n, min, max);
+	}
+
+	void normalize(float* p, size_t n) {
+		kernels::simdKernels().normalize(p, n);
+	}
+
+	void halfToFloat(const unsigned short* src, float* dst, size_t n, float scale) {
+		kernels::halfToFloat(reinterpret_cast<const half*>(src), dst, n, scale);
+	}
+
+	void floatToHalf(const float* src, unsigned short* dst, size_t n, float scale) {
+		kernels::floatToHalf(src, reinterpret_cast<half*>(dst), n, scale);
+	}
+
+	const char* simdLevel() {
+		return kernels::simdLevelName(kernels::simdLevel());
+	}
+
+
+	const PimathCAPI g_api = {
+		PIMATH_API_VERSION,
+		check, data, fromValue, v3fArrayData,
+		transformPoints, bounds, normalize, halfToFloat, floatToHalf, simdLevel
+	};
+}
+
+
+void _pimath_export_capi()
+{
+	addType<Imath::V2i>(PIMATH_V2i, "V2i");
+	addType<Imath::V2f>(PIMATH_V2f, "V2f");
+	addType<Imath::V2d>(PIMATH_V2d, "V2d");
+	addType<Imath::V3i>(PIMATH_V3i, "V3i");
+	addType<Imath::V3f>(PIMATH_V3f, "V3f");
+	addType<Imath::V3d>(PIMATH_V3d, "V3d");
+	addType<Imath::V4i>(PIMATH_V4i, "V4i");
+	addType<Imath::V4f>(PIMATH_V4f, "V4f");
+	addType<Imath::V4d>(PIMATH_V4d, "V4d");
+	addType<Imath::M33f>(PIMATH_M33f, "M33f");
+	addType<Imath::M33d>(PIMATH_M33d, "M33d");
+	addType<Imath::M44f>(PIMATH_M44f, "M44f");
+	addType<Imath::M44d>(PIMATH_M44d, "M44d");
+	addType<Imath::Quatf>(PIMATH_Quatf, "Quatf");
+	addType<Imath::Quatd>(PIMATH_Quatd, "Quatd");
+	addType<Imath::Box3f>(PIMATH_Box3f, "Box3f");
+	addType<Imath::Box3d>(PIMATH_Box3d, "Box3d");
+	addType<Imath::C3f>(PIMATH_C3f, "C3f");
+	addType<Imath::C4f>(PIMATH_C4f, "C4f");
+
+	PyObject* capsule = PyCapsule_New(const_cast<PimathCAPI*>(&g_api), PIMATH_API_CAPSULE, NULL);
+	if(!capsule)
+		bp::throw_error_already_set();
+	bp::scope().attr("_C_API") = bp::object(bp::handle<>(capsule));
+}
@@ -0,0 +1,282 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../dispatch.hpp"
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+#include <vector>
+#include <map>
+#include <string>
+#include <cstring>
+
+using namespace pimath;
+namespace bp = boost::python;
+
+
+namespace {
+
+	// calls with more args than this are not cached
+	const int MAX_DISPATCH_ARGS = 4;
+
+	struct DispatchKey
+	{
+		int 			nargs;
+		PyTypeObject* 	types[MAX_DISPATCH_ARGS];
+
+		bool operator==(const DispatchKey& rhs) const
+		{
+			if(nargs != rhs.nargs)
+				return false;
+			for(int i=0; i<nargs; ++i)
+				if(types[i] != rhs.types[i])
+					return false;
+			return true;
+		}
+	};
+
+	std::size_t hash_value(const DispatchKey& key)
+	{
+		std::size_t seed = key.nargs;
+		for(int i=0; i<key.nargs; ++i)
+			boost::hash_combine(seed, key.types[i]);
+		return seed;
+	}
+
+	struct DispatchOverload
+	{
+		bp::object 			fn;
+		int 				arity;
+		dispatch_check_fn 	check;
+	};
+
+	// index into the overloads, or FALLBACK
+	typedef boost::unordered_map<DispatchKey, int, boost::hash<DispatchKey> > dispatch_cache;
+	const int FALLBACK = -1;
+
+	struct Dispatcher
+	{
+		PyObject_HEAD
+		PyObject* 						fallback;	// the generic boost.python function
+		std::vector<DispatchOverload>* 	overloads;	// in order of priority
+		dispatch_cache* 				cache;
+	};
+
+	// static, so the head holds the reference which keeps it from ever being deallocated;
+	// the slots are filled in before PyType_Ready
+	PyTypeObject DispatcherType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+
+	// the converters for instances of bound classes, and for the builtin scalar types,
+	// depend only on the type of the object and not its value
+	bool isCacheableType(PyTypeObject* type)
+	{
+		static PyTypeObject* classMetatype = bp::objects::class_metatype().get();
+
+		return (Py_TYPE(type) == classMetatype)
+			|| (type == &PyFloat_Type)
+			|| (type == &PyLong_Type)
+#if PY_MAJOR_VERSION < 3
+			|| (type == &PyInt_Type)
+#endif
+			|| (type == &PyBool_Type);
+	}
+
+	int resolve(const Dispatcher* self, PyObject* args)
+	{
+		int nargs = static_cast<int>(PyTuple_GET_SIZE(args));
+		const std::vector<DispatchOverload>& overloads = *self->overloads;
+		for(std::size_t i=0; i<overloads.size(); ++i)
+		{
+			if((overloads[i].arity == nargs) && overloads[i].check(args))
+				return static_cast<int>(i);
+		}
+		return FALLBACK;
+	}
+
+	PyObject* dispatcher_call(PyObject* self_, PyObject* args, PyObject* kw)
+	{
+		Dispatcher* self = reinterpret_cast<Dispatcher*>(self_);
+
+		Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+		if((kw && PyDict_Size(kw)) || (nargs > MAX_DISPATCH_ARGS))
+			return PyObject_Call(self->fallback, args, kw);
+
+		DispatchKey key;
+		key.nargs = static_cast<int>(nargs);
+		for(int i=0; i<key.nargs; ++i)
+		{
+			key.types[i] = Py_TYPE(PyTuple_GET_ITEM(args, i));
+			if(!isCacheableType(key.types[i]))
+				return PyObject_Call(self->fallback, args, kw);
+		}
+
+		int index;
+		dispatch_cache::const_iterator it = self->cache->find(key);
+		if(it != self->cache->end())
+			index = it->second;
+		else
+		{
+			index = resolve(self, args);
+
+			// hold the types, so that their addresses can't be reused while cached
+			for(int i=0; i<key.nargs; ++i)
+				Py_INCREF(key.types[i]);
+			(*self->cache)[key] = index;
+		}
+
+		PyObject* fn = (index == FALLBACK)? self->fallback : (*self->overloads)[index].fn.ptr();
+		return PyObject_Call(fn, args, kw);
+	}
+
+	// binds as a method, in the same way as Boost.Python.function
+	PyObject* dispatcher_descr_get(PyObject* self, PyObject* obj, PyObject* type)
+	{
+#if PY_MAJOR_VERSION >= 3
+		if((obj == Py_None) || (obj == NULL))
+		{
+			Py_INCREF(self);
+			return self;
+		}
+		return PyMethod_New(self, obj);
+#else
+		if(obj == Py_None)
+			obj = NULL;
+		return PyMethod_New(self, obj, type);
+#endif
+	}
+
+	// forward __doc__, __name__ etc to the generic function
+	PyObject* dispatcher_getattro(PyObject* self, PyObject* name)
+	{
+		PyObject* result = PyObject_GenericGetAttr(self, name);
+		if(!result && PyErr_ExceptionMatches(PyExc_AttributeError))
+		{
+			PyErr_Clear();
+			result = PyObject_GetAttr(reinterpret_cast<Dispatcher*>(self)->fallback, name);
+		}
+		return result;
+	}
+
+	void dispatcher_dealloc(PyObject* self_)
+	{
+		Dispatcher* self = reinterpret_cast<Dispatcher*>(self_);
+		for(dispatch_cache::const_iterator it=self->cache->begin(); it!=self->cache->end(); ++it)
+			for(int i=0; i<it->first.nargs; ++i)
+				Py_DECREF(it->first.types[i]);
+
+		delete self->cache;
+		delete self->overloads;
+		Py_XDECREF(self->fallback);
+		PyObject_Del(self_);
+	}
+
+
+	// overloads waiting for installDispatchers(), by namespace and name
+	typedef std::pair<bp::object, std::string> 						dispatch_name;
+	typedef std::vector<std::pair<dispatch_name, DispatchOverload> > 	pending_vector;
+
+	pending_vector g_pending;
+
+
+	void install(const bp::object& ns, const std::string& name,
+		const std::vector<DispatchOverload>& overloads)
+	{
+		// the class/module dict holds the function itself rather than a bound method
+		PyObject* dict = PyType_Check(ns.ptr())?
+			reinterpret_cast<PyTypeObject*>(ns.ptr())->tp_dict : PyModule_GetDict(ns.ptr());
+		PyObject* fallback = PyDict_GetItemString(dict, name.c_str());
+		if(!fallback)
+			return;
+
+		Dispatcher* d = PyObject_New(Dispatcher, &DispatcherType);
+		if(!d)
+			bp::throw_error_already_set();
+
+		Py_INCREF(fallback);
+		d->fallback = fallback;
+		d->cache = new dispatch_cache();
+
+		// boost.python tries the most recently added overload first
+		d->overloads = new std::vector<DispatchOverload>(overloads.rbegin(), overloads.rend());
+
+		bp::object dispatcher(bp::handle<>(reinterpret_cast<PyObject*>(d)));
+		if(PyObject_SetAttrString(ns.ptr(), name.c_str(), dispatcher.ptr()) < 0)
+			bp::throw_error_already_set();
+	}
+}
+
+
+void pimath::addDispatchOverload(const bp::object& ns, const char* name, const bp::object& fn,
+	int arity, dispatch_check_fn check)
+{
+	DispatchOverload overload;
+	overload.fn = fn;
+	overload.arity = arity;
+	overload.check = check;
+	g_pending.push_back(std::make_pair(dispatch_name(ns, name), overload));
+}
+
+
+void pimath::installDispatchers()
+{
+	if(!DispatcherType.tp_name)
+	{
+		DispatcherType.tp_name = "pimath.Dispatcher";
+		DispatcherType.tp_basicsize = sizeof(Dispatcher);
+		DispatcherType.tp_flags = Py_TPFLAGS_DEFAULT;
+		DispatcherType.tp_call = dispatcher_call;
+		DispatcherType.tp_descr_get = dispatcher_descr_get;
+		DispatcherType.tp_getattro = dispatcher_getattro;
+		DispatcherType.tp_dealloc = dispatcher_dealloc;
+		if(PyType_Ready(&DispatcherType) < 0)
+			bp::throw_error_already_set();
+	}
+
+	// group the pending overloads by name, keeping their order
+	std::vector<dispatch_name> names;
+	std::map<PyObject*, std::map<std::string, std::vector<DispatchOverload> > > groups;
+
+	for(pending_vector::const_iterator it=g_pending.begin(); it!=g_pending.end(); ++it)
+	{
+		std::vector<DispatchOverload>& group = groups[it->first.first.ptr()][it->first.second];
+		if(group.empty())
+			names.push_back(it->first);
+		group.push_back(it->second);
+	}
+
+	for(std::size_t i=0; i<names.size(); ++i)
+		install(names[i].first, names[i].second, groups[names[i].first.ptr()][names[i].second]);
+
+	g_pending.clear();
+}
+
+
+void _pimath_export_dispatch()
+{
+	installDispatchers();
+}
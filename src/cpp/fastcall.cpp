@@ -0,0 +1,176 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../fastcall.hpp"
+#include <vector>
+#include <list>
+#include <string>
+
+using namespace pimath;
+namespace bp = boost::python;
+
+
+#ifdef PIMATH_FASTCALL
+
+namespace {
+
+	struct PendingFastCall
+	{
+		bp::object 		ns;
+		std::string 	name;
+		PyMethodDef* 	def;
+		PyObject** 		fallback;
+	};
+
+	std::vector<PendingFastCall> g_pending;
+
+	// names and docstrings of the installed entry points, which PyMethodDef points into
+	std::list<std::string> g_strings;
+
+	const char* keepString(const std::string& s)
+	{
+		g_strings.push_back(s);
+		return g_strings.back().c_str();
+	}
+
+
+	void install(const PendingFastCall& p)
+	{
+		bool isClass = PyType_Check(p.ns.ptr());
+		PyObject* dict = isClass?
+			reinterpret_cast<PyTypeObject*>(p.ns.ptr())->tp_dict : PyModule_GetDict(p.ns.ptr());
+
+		PyObject* fallback = PyDict_GetItemString(dict, p.name.c_str());
+		if(!fallback)
+			return;
+
+		Py_INCREF(fallback);
+		*p.fallback = fallback;
+
+		p.def->ml_name = keepString(p.name);
+		bp::handle<> doc(bp::allow_null(PyObject_GetAttrString(fallback, "__doc__")));
+		PyErr_Clear();
+		if(doc && PyUnicode_Check(doc.get()))
+			p.def->ml_doc = keepString(PyUnicode_AsUTF8(doc.get()));
+
+		PyObject* fn;
+		if(isClass)
+			fn = PyDescr_NewMethod(reinterpret_cast<PyTypeObject*>(p.ns.ptr()), p.def);
+		else
+		{
+			bp::object modname = p.ns.attr("__name__");
+			fn = PyCFunction_NewEx(p.def, NULL, modname.ptr());
+		}
+
+		bp::handle<> f(bp::allow_null(fn));
+		if(!f || (PyObject_SetAttrString(p.ns.ptr(), p.name.c_str(), f.get()) < 0))
+			bp::throw_error_already_set();
+	}
+}
+
+
+PyObject* pimath::callFastCallFallback(PyObject* fallback, PyObject* self,
+	PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames)
+{
+	// this runs inside a METH_FASTCALL entry point, so reports errors as NULL rather than
+	// with c++ exceptions
+	Py_ssize_t nkw = (kwnames)? PyTuple_GET_SIZE(kwnames) : 0;
+	Py_ssize_t offset = (self)? 1 : 0;
+
+	PyObject* posargs = PyTuple_New(nargs + offset);
+	if(!posargs)
+		return NULL;
+	if(self)
+	{
+		Py_INCREF(self);
+		PyTuple_SET_ITEM(posargs, 0, self);
+	}
+	for(Py_ssize_t i=0; i<nargs; ++i)
+	{
+		Py_INCREF(args[i]);
+		PyTuple_SET_ITEM(posargs, i + offset, args[i]);
+	}
+
+	PyObject* kwargs = NULL;
+	if(nkw)
+	{
+		kwargs = PyDict_New();
+		if(!kwargs)
+		{
+			Py_DECREF(posargs);
+			return NULL;
+		}
+		for(Py_ssize_t i=0; i<nkw; ++i)
+		{
+			if(PyDict_SetItem(kwargs, PyTuple_GET_ITEM(kwnames, i), args[nargs + i]) < 0)
+			{
+				Py_DECREF(kwargs);
+				Py_DECREF(posargs);
+				return NULL;
+			}
+		}
+	}
+
+	PyObject* result = PyObject_Call(fallback, posargs, kwargs);
+	Py_XDECREF(kwargs);
+	Py_DECREF(posargs);
+	return result;
+}
+
+
+void pimath::addFastCall(const bp::object& ns, const char* name, PyMethodDef* def,
+	PyObject** fallback)
+{
+	PendingFastCall p;
+	p.ns = ns;
+	p.name = name;
+	p.def = def;
+	p.fallback = fallback;
+	g_pending.push_back(p);
+}
+
+
+void pimath::installFastCalls()
+{
+	for(std::size_t i=0; i<g_pending.size(); ++i)
+		install(g_pending[i]);
+	g_pending.clear();
+}
+
+#else
+
+void pimath::installFastCalls()
+{}
+
+#endif
+
+
+void _pimath_export_fastcall()
+{
+	installFastCalls();
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../instance_pool.hpp"
+
+using namespace pimath;
+namespace bp = boost::python;
+
+
+namespace {
+
+	std::vector<InstancePoolData*>& pools()
+	{
+		static std::vector<InstancePoolData*> p;
+		return p;
+	}
+}
+
+
+std::size_t InstancePools::s_capacity(1024);
+
+
+void InstancePools::add(InstancePoolData* pool)
+{
+	pools().push_back(pool);
+}
+
+
+bp::dict InstancePools::stats()
+{
+	bp::dict d;
+	for(std::size_t i=0; i<pools().size(); ++i)
+	{
+		const InstancePoolData& p = *pools()[i];
+		unsigned long total = p.hits + p.misses;
+
+		bp::dict entry;
+		entry["hits"] = p.hits;
+		entry["misses"] = p.misses;
+		entry["recycled"] = p.recycled;
+		entry["pooled"] = p.freeList.size();
+		entry["hitRate"] = (total)? double(p.hits)/total : 0.0;
+		entry["enabled"] = p.enabled;
+		d[p.type->tp_name] = entry;
+	}
+	return d;
+}
+
+
+void InstancePools::clear()
+{
+	for(std::size_t i=0; i<pools().size(); ++i)
+	{
+		InstancePoolData& p = *pools()[i];
+		p.clear();
+		p.hits = p.misses = p.recycled = 0;
+	}
+}
+
+
+void InstancePools::setCapacity(std::size_t capacity)
+{
+	s_capacity = capacity;
+	for(std::size_t i=0; i<pools().size(); ++i)
+	{
+		InstancePoolData& p = *pools()[i];
+		while(p.freeList.size() > capacity)
+		{
+			p.free(p.freeList.back());
+			p.freeList.pop_back();
+		}
+	}
+}
+
+
+void _pimath_export_instancePool()
+{
+	bp::def("instancePoolStats", &InstancePools::stats);
+	bp::def("clearInstancePools", &InstancePools::clear);
+	bp::def("setInstancePoolCapacity", &InstancePools::setCapacity);
+}
@@ -34,6 +34,12 @@ namespace bp = boost::python;
 
 void _pimath_export_plane()
 {
+	bp::enum_<kernels::PlaneSide>("PlaneSide")
+		.value("PlaneBack", kernels::PlaneBack)
+		.value("PlaneStraddle", kernels::PlaneStraddle)
+		.value("PlaneFront", kernels::PlaneFront)
+		;
+
 	PlaneBind<float>("Plane3f");
 	PlaneBind<double>("Plane3d");
 	PlaneBind<half>("Plane3h");
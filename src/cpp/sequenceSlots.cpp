@@ -0,0 +1,91 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../sequence_slots.hpp"
+
+using namespace pimath;
+namespace bp = boost::python;
+
+
+namespace {
+
+	struct SequenceIterator
+	{
+		PyObject_HEAD
+		PyObject* 		seq;
+		Py_ssize_t 		index;
+		Py_ssize_t 		len;
+		ssizeargfunc 	item;
+	};
+
+	// static, so the head holds the reference which keeps it from ever being deallocated;
+	// the slots are filled in before PyType_Ready
+	PyTypeObject SequenceIteratorType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+
+	PyObject* sequenceIterator_next(PyObject* self_)
+	{
+		SequenceIterator* self = reinterpret_cast<SequenceIterator*>(self_);
+		if(self->index >= self->len)
+			return NULL;	// stops iteration, without an exception
+		return self->item(self->seq, self->index++);
+	}
+
+	void sequenceIterator_dealloc(PyObject* self)
+	{
+		Py_XDECREF(reinterpret_cast<SequenceIterator*>(self)->seq);
+		PyObject_Del(self);
+	}
+}
+
+
+PyObject* pimath::newSequenceIterator(PyObject* seq, Py_ssize_t len, ssizeargfunc item)
+{
+	if(!SequenceIteratorType.tp_name)
+	{
+		SequenceIteratorType.tp_name = "pimath.SequenceIterator";
+		SequenceIteratorType.tp_basicsize = sizeof(SequenceIterator);
+		SequenceIteratorType.tp_flags = Py_TPFLAGS_DEFAULT;
+		SequenceIteratorType.tp_iter = PyObject_SelfIter;
+		SequenceIteratorType.tp_iternext = sequenceIterator_next;
+		SequenceIteratorType.tp_dealloc = sequenceIterator_dealloc;
+		if(PyType_Ready(&SequenceIteratorType) < 0)
+			return NULL;
+	}
+
+	SequenceIterator* it = PyObject_New(SequenceIterator, &SequenceIteratorType);
+	if(!it)
+		return NULL;
+
+	Py_INCREF(seq);
+	it->seq = seq;
+	it->index = 0;
+	it->len = len;
+	it->item = item;
+	return reinterpret_cast<PyObject*>(it);
+}
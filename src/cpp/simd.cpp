@@ -0,0 +1,71 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "../kernels/simd.hpp"
+#include <boost/python.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace pimath;
+namespace bp = boost::python;
+
+
+namespace {
+
+	std::string simdLevelString() {
+		return kernels::simdLevelName(kernels::simdLevel());
+	}
+}
+
+
+void _pimath_export_simd()
+{
+	using namespace pimath::kernels;
+
+	// PIMATH_SIMD can lower the level, eg to test the other kernels
+	const char* env = std::getenv("PIMATH_SIMD");
+	if(env && *env)
+	{
+		bool known = false;
+		for(int i=SimdScalar; i<=SimdAVX512; ++i)
+			known |= !std::strcmp(env, simdLevelName(SimdLevel(i)));
+
+		if(!known)
+		{
+			std::string msg = std::string("Unknown PIMATH_SIMD level '") + env + "', ignored.";
+			if(PyErr_WarnEx(PyExc_RuntimeWarning, msg.c_str(), 1) < 0)
+				bp::throw_error_already_set();
+		}
+	}
+
+	// select the kernels now, rather than on first use
+	simdKernels();
+
+	bp::def("simdLevel", simdLevelString);
+}
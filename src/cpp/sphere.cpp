@@ -34,6 +34,11 @@ namespace bp = boost::python;
 
 void _pimath_export_sphere()
 {
+	bp::enum_<kernels::SphereFit>("SphereFit")
+		.value("ExactFit", kernels::ExactFit)
+		.value("RitterFit", kernels::RitterFit)
+		;
+
 	SphereBind<float>	("Sphere3f");
 	SphereBind<double>	("Sphere3d");
 	SphereBind<half>	("Sphere3h");
@@ -0,0 +1,378 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/*
+ * Per-function call counts, cumulative time and instance allocation counts, available
+ * from python via pimath.stats(). This is compiled in only if PIMATH_STATS is defined
+ * (see setup.py), which pimath.statsEnabled() reports; otherwise stats() returns an empty
+ * dict and bound functions are not touched at all.
+ *
+ * When enabled, every boost.python function in the module and its classes (including
+ * static methods and property accessors) is replaced by a thin wrapper which records
+ * the call. Allocations are counted by hooking tp_alloc on each pimath class.
+ *
+ * The wrapping is done once the classes are bound, rather than inside bindBaseType and
+ * each *Bind struct, so that the binding code is the same in both builds and a normal
+ * build has nothing to compile out. The wrappers are visible from python: in a stats
+ * build type(pimath.V3f.dot) is pimath.StatsFunction rather than Boost.Python.function
+ * (or pimath.Dispatcher). Calls and method binding behave as before, and attributes the
+ * wrapper lacks (eg __name__) are looked up on the wrapped function.
+ */
+
+#include <boost/python.hpp>
+#include <string>
+
+#ifdef PIMATH_STATS
+#include <map>
+#include <set>
+#include <vector>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+namespace bp = boost::python;
+
+
+#ifdef PIMATH_STATS
+
+namespace {
+
+	struct FunctionStats
+	{
+		FunctionStats():calls(0), time(0.0), allocs(0){}
+
+		unsigned long 	calls;
+		double 			time;
+		unsigned long 	allocs;
+	};
+
+	typedef std::map<std::string, FunctionStats> stats_map;
+
+	stats_map g_stats;
+	unsigned long g_allocs = 0;
+	std::map<PyTypeObject*, allocfunc> g_allocFuncs;
+
+
+	double now()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER t, f;
+		QueryPerformanceCounter(&t);
+		QueryPerformanceFrequency(&f);
+		return double(t.QuadPart) / double(f.QuadPart);
+#else
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return double(t.tv_sec) + double(t.tv_nsec) * 1e-9;
+#endif
+	}
+
+
+	PyObject* countingAlloc(PyTypeObject* type, Py_ssize_t nitems)
+	{
+		++g_allocs;
+		std::map<PyTypeObject*, allocfunc>::const_iterator it = g_allocFuncs.find(type);
+		return (it == g_allocFuncs.end())?
+			PyType_GenericAlloc(type, nitems) : it->second(type, nitems);
+	}
+
+
+	// callable wrapper around a bound function
+	struct StatsFunction
+	{
+		PyObject_HEAD
+		PyObject* 		func;
+		FunctionStats* 	stats;
+	};
+
+	// static, so the head holds the reference which keeps it from ever being deallocated;
+	// the slots are filled in before PyType_Ready
+	PyTypeObject StatsFunctionType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+
+	PyObject* statsFunction_call(PyObject* self_, PyObject* args, PyObject* kw)
+	{
+		StatsFunction* self = reinterpret_cast<StatsFunction*>(self_);
+		FunctionStats& s = *self->stats;
+
+		unsigned long allocs = g_allocs;
+		double start = now();
+		PyObject* result = PyObject_Call(self->func, args, kw);
+		s.time += now() - start;
+		s.allocs += g_allocs - allocs;
+		++s.calls;
+
+		return result;
+	}
+
+	// binds as a method, in the same way as Boost.Python.function
+	PyObject* statsFunction_descr_get(PyObject* self, PyObject* obj, PyObject* type)
+	{
+#if PY_MAJOR_VERSION >= 3
+		if((obj == Py_None) || (obj == NULL))
+		{
+			Py_INCREF(self);
+			return self;
+		}
+		return PyMethod_New(self, obj);
+#else
+		if(obj == Py_None)
+			obj = NULL;
+		return PyMethod_New(self, obj, type);
+#endif
+	}
+
+	// forward __doc__, __name__ etc to the wrapped function
+	PyObject* statsFunction_getattro(PyObject* self, PyObject* name)
+	{
+		PyObject* result = PyObject_GenericGetAttr(self, name);
+		if(!result && PyErr_ExceptionMatches(PyExc_AttributeError))
+		{
+			PyErr_Clear();
+			result = PyObject_GetAttr(reinterpret_cast<StatsFunction*>(self)->func, name);
+		}
+		return result;
+	}
+
+	void statsFunction_dealloc(PyObject* self)
+	{
+		Py_XDECREF(reinterpret_cast<StatsFunction*>(self)->func);
+		PyObject_Del(self);
+	}
+
+
+	// boost.python functions, or the dispatchers and fast call entry points which replace
+	// them (see dispatch.hpp, fastcall.hpp)
+	bool isBoostFunction(PyObject* o)
+	{
+		return (std::strcmp(Py_TYPE(o)->tp_name, "Boost.Python.function") == 0)
+			|| (std::strcmp(Py_TYPE(o)->tp_name, "pimath.Dispatcher") == 0)
+			|| PyObject_TypeCheck(o, &PyMethodDescr_Type)
+			|| PyCFunction_Check(o);
+	}
+
+	bool isBoostClass(PyObject* o) {
+		return PyType_Check(o) && (std::strcmp(Py_TYPE(o)->tp_name, "Boost.Python.class") == 0);
+	}
+
+
+	PyObject* wrap(PyObject* func, const std::string& name)
+	{
+		StatsFunction* f = PyObject_New(StatsFunction, &StatsFunctionType);
+		if(!f)
+			bp::throw_error_already_set();
+
+		Py_INCREF(func);
+		f->func = func;
+		f->stats = &g_stats[name];
+		return reinterpret_cast<PyObject*>(f);
+	}
+
+
+	// returns a new reference to the instrumented version of 'value', or NULL if it
+	// should be left as it is
+	PyObject* instrumentValue(PyObject* value, const std::string& name)
+	{
+		if(isBoostFunction(value))
+			return wrap(value, name);
+
+		if(Py_TYPE(value) == &PyStaticMethod_Type)
+		{
+			bp::object func(bp::handle<>(PyObject_GetAttrString(value, "__func__")));
+			if(!isBoostFunction(func.ptr()))
+				return NULL;
+
+			bp::object wrapped(bp::handle<>(wrap(func.ptr(), name)));
+			return PyStaticMethod_New(wrapped.ptr());
+		}
+
+		if(PyObject_TypeCheck(value, &PyProperty_Type))
+		{
+			bp::object prop(bp::handle<>(bp::borrowed(value)));
+			bp::object fget = prop.attr("fget");
+			bp::object fset = prop.attr("fset");
+
+			if(fget.ptr() != Py_None && isBoostFunction(fget.ptr()))
+				fget = bp::object(bp::handle<>(wrap(fget.ptr(), name + ".get")));
+			if(fset.ptr() != Py_None && isBoostFunction(fset.ptr()))
+				fset = bp::object(bp::handle<>(wrap(fset.ptr(), name + ".set")));
+
+			return PyObject_CallFunctionObjArgs(reinterpret_cast<PyObject*>(&PyProperty_Type),
+				fget.ptr(), fset.ptr(), NULL);
+		}
+
+		return NULL;
+	}
+
+
+	void instrument(PyObject* owner, const std::string& prefix, std::set<PyObject*>& visited)
+	{
+		if(!visited.insert(owner).second)
+			return;
+
+		PyObject* dict = PyType_Check(owner)?
+			reinterpret_cast<PyTypeObject*>(owner)->tp_dict : PyModule_GetDict(owner);
+
+		std::vector<std::pair<bp::object, bp::object> > replacements;
+		std::vector<PyObject*> classes;
+
+		PyObject *key, *value;
+		Py_ssize_t pos = 0;
+		while(PyDict_Next(dict, &pos, &key, &value))
+		{
+			if(isBoostClass(value))
+			{
+				classes.push_back(value);
+				continue;
+			}
+
+			std::string name = prefix + bp::extract<std::string>(key)();
+
+			// module hooks such as __getattr__ are not part of the api
+			if(!PyType_Check(owner) && name.compare(0, 2, "__") == 0)
+				continue;
+
+			PyObject* replacement = instrumentValue(value, name);
+			if(replacement)
+			{
+				replacements.push_back(std::make_pair(
+					bp::object(bp::handle<>(bp::borrowed(key))),
+					bp::object(bp::handle<>(replacement))));
+			}
+		}
+
+		for(std::size_t i=0; i<replacements.size(); ++i)
+		{
+			if(PyObject_SetAttr(owner, replacements[i].first.ptr(), replacements[i].second.ptr()) < 0)
+				bp::throw_error_already_set();
+		}
+
+		// Classes seen in earlier passes are scanned again too, since a group registered
+		// later may add methods to them; what is already wrapped is left alone.
+		for(std::size_t i=0; i<classes.size(); ++i)
+		{
+			PyTypeObject* type = reinterpret_cast<PyTypeObject*>(classes[i]);
+			if(visited.count(classes[i]))
+				continue;
+
+			if(type->tp_alloc != countingAlloc)
+			{
+				g_allocFuncs[type] = type->tp_alloc;
+				type->tp_alloc = countingAlloc;
+			}
+
+			instrument(classes[i], std::string(type->tp_name) + ".", visited);
+		}
+	}
+
+
+	bp::dict stats()
+	{
+		bp::dict d;
+		for(stats_map::const_iterator it=g_stats.begin(); it!=g_stats.end(); ++it)
+		{
+			bp::dict entry;
+			entry["calls"] = it->second.calls;
+			entry["time"] = it->second.time;
+			entry["allocs"] = it->second.allocs;
+			d[it->first] = entry;
+		}
+		return d;
+	}
+
+	void resetStats()
+	{
+		for(stats_map::iterator it=g_stats.begin(); it!=g_stats.end(); ++it)
+			it->second = FunctionStats();
+	}
+
+	bool statsEnabled() {
+		return true;
+	}
+}
+
+#else
+
+namespace {
+
+	bp::dict stats() {
+		return bp::dict();
+	}
+
+	void resetStats() {}
+
+	bool statsEnabled() {
+		return false;
+	}
+}
+
+#endif
+
+
+void _pimath_export_stats()
+{
+	bp::def("stats", stats);
+	bp::def("resetStats", resetStats);
+	bp::def("statsEnabled", statsEnabled);
+
+#ifdef PIMATH_STATS
+	StatsFunctionType.tp_name = "pimath.StatsFunction";
+	StatsFunctionType.tp_basicsize = sizeof(StatsFunction);
+	StatsFunctionType.tp_flags = Py_TPFLAGS_DEFAULT;
+	StatsFunctionType.tp_call = statsFunction_call;
+	StatsFunctionType.tp_descr_get = statsFunction_descr_get;
+	StatsFunctionType.tp_getattro = statsFunction_getattro;
+	StatsFunctionType.tp_dealloc = statsFunction_dealloc;
+	if(PyType_Ready(&StatsFunctionType) < 0)
+		bp::throw_error_already_set();
+
+#endif
+}
+
+
+void _pimath_instrument_stats()
+{
+#ifdef PIMATH_STATS
+	// stats(), resetStats() and statsEnabled() are not instrumented themselves. The module
+	// is revisited on every call, since lazily registered groups add to it; already
+	// instrumented functions are skipped.
+	bp::object scope = bp::scope();
+	bp::object statsFn = scope.attr("stats");
+	bp::object resetFn = scope.attr("resetStats");
+	bp::object enabledFn = scope.attr("statsEnabled");
+	std::set<PyObject*> visited;
+	instrument(scope.ptr(), "", visited);
+	scope.attr("stats") = statsFn;
+	scope.attr("resetStats") = resetFn;
+	scope.attr("statsEnabled") = enabledFn;
+#endif
+}
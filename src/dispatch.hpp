@@ -0,0 +1,116 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_DISPATCH__H_
+#define _PIMATH_DISPATCH__H_
+
+#include <boost/python.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/mpl/at.hpp>
+
+
+/*
+ * Many functions are bound once per scalar type and matrix dimension (extractSHRT has five
+ * overloads per type, for example), and boost.python resolves a call by trying each overload
+ * in turn, running its argument converters until one succeeds. Overloads bound with
+ * defDispatch are instead resolved by a per-name dispatcher, which caches the chosen
+ * overload against the exact python types of the arguments. A call with types seen before
+ * goes straight to the right overload.
+ *
+ * The generic boost.python overload chain is still built as usual, and is used for calls
+ * with keyword arguments, with arguments whose conversion may depend on their value (eg
+ * sequences), or when no dispatched overload matches. Overloads bound with defDispatch take
+ * priority over any bound with a plain def, so they should be bound last.
+ *
+ * Dispatchers replace the bound functions when installDispatchers() is called at the end
+ * of module initialisation.
+ */
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	typedef bool(*dispatch_check_fn)(PyObject* args);
+
+	// records an overload of ns.name for the dispatcher
+	void addDispatchOverload(const bp::object& ns, const char* name, const bp::object& fn,
+		int arity, dispatch_check_fn check);
+
+	// replaces every function with dispatched overloads by its dispatcher
+	void installDispatchers();
+
+
+	// true if each of the python args can be converted to the corresponding C++ argument
+	// in Sig, using the same converter lookup boost.python does (but without calling anything)
+	template<typename Sig, int I, int N>
+	struct DispatchCheck
+	{
+		static bool apply(PyObject* args)
+		{
+			typedef typename boost::mpl::at_c<Sig, I+1>::type arg_type;
+			bp::arg_from_python<arg_type> c(PyTuple_GET_ITEM(args, I));
+			return c.convertible() && DispatchCheck<Sig, I+1, N>::apply(args);
+		}
+	};
+
+	template<typename Sig, int N>
+	struct DispatchCheck<Sig, N, N>
+	{
+		static bool apply(PyObject*) {
+			return true;
+		}
+	};
+
+
+	template<typename Sig>
+	void addDispatchOverload(const bp::object& ns, const char* name, const bp::object& fn, Sig)
+	{
+		static const int arity = boost::mpl::size<Sig>::value - 1;
+		addDispatchOverload(ns, name, fn, arity, &DispatchCheck<Sig, 0, arity>::apply);
+	}
+
+
+	// bp::def, with the overload also added to the dispatcher for 'name'
+	template<typename F>
+	void defDispatch(const char* name, F f)
+	{
+		bp::def(name, f);
+		addDispatchOverload(bp::scope(), name, bp::make_function(f), bp::detail::get_signature(f));
+	}
+
+	// class_::def, with the overload also added to the dispatcher for 'name'
+	template<typename BpClass, typename F>
+	void defDispatch(BpClass& cl, const char* name, F f)
+	{
+		cl.def(name, f);
+		addDispatchOverload(cl, name, bp::make_function(f), bp::detail::get_signature(f));
+	}
+
+}
+
+#endif
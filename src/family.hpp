@@ -0,0 +1,177 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_FAMILY__H_
+#define _PIMATH_FAMILY__H_
+
+#include <boost/python.hpp>
+#include <vector>
+#include "traits.hpp"
+#include "util.h"
+
+
+/*
+ * A class family is one Imath template over pimath's different scalar types - eg V3i, V3f,
+ * V3d and V3h. Binding a function once per scalar type in the family multiplies the
+ * number of template instantiations (and so the size of the module) by the size of the
+ * family. Instead, a function can take a FamilyValue<D> argument, where D is the family's
+ * double-precision member (eg V3d): this accepts an instance of any member, converted to D
+ * at runtime. The conversion is exact for every scalar type pimath uses. Results can be
+ * converted back to the type of the argument with FamilyValue::make().
+ *
+ * Classes register themselves with bindFamilyMember(). Cross-type functions taking a
+ * FamilyValue are typically bound alongside a native overload for the class's own scalar
+ * type, which keeps Imath's arithmetic precision for the common, same-type case.
+ *
+ * Cross-type arithmetic through a FamilyValue (eg an M44d transforming a V3f) is done in
+ * double and rounded to the result's type once, where Imath would round intermediate
+ * values (such as the homogeneous w) to the result's type too. Results can differ from
+ * Imath's in the last bit, and are never less accurate.
+ */
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+
+	template<typename T>
+	struct family_of {
+		typedef typename imath_traits<T>::template rebind<double>::type type;
+	};
+
+
+	struct FamilyMember
+	{
+		PyTypeObject* 	type;
+		void 			(*get)(PyObject* o, void* value);	// writes the family's double type
+		PyObject* 		(*make)(const void* value);			// reads the family's double type
+	};
+
+	typedef std::vector<FamilyMember> family_members;
+
+	// the (stable) member list of the family whose double type is 'family'
+	family_members& familyMembers(const bp::type_info& family);
+
+
+	template<typename D>
+	struct FamilyValue
+	{
+		typedef D value_type;
+
+		// a new instance of the argument's type, holding 'd'
+		bp::object make(const D& d) const {
+			return bp::object(bp::handle<>(member->make(&d)));
+		}
+
+		D 						value;
+		const FamilyMember* 	member;
+	};
+
+
+	// from-python converter for FamilyValue<D>
+	template<typename D>
+	struct FamilyConverter
+	{
+		static const family_members& members()
+		{
+			static const family_members& m = familyMembers(bp::type_id<D>());
+			return m;
+		}
+
+		static const FamilyMember* find(PyObject* o)
+		{
+			const family_members& m = members();
+			for(std::size_t i=0; i<m.size(); ++i)
+			{
+				if(Py_TYPE(o) == m[i].type)
+					return &m[i];
+			}
+
+			// subclasses, eg a C3f passed as a V3f
+			for(std::size_t i=0; i<m.size(); ++i)
+			{
+				if(PyObject_TypeCheck(o, m[i].type))
+					return &m[i];
+			}
+			return 0;
+		}
+
+		static void* convertible(PyObject* o) {
+			return const_cast<FamilyMember*>(find(o));
+		}
+
+		static void construct(PyObject* o, bp::converter::rvalue_from_python_stage1_data* data)
+		{
+			const FamilyMember* member = static_cast<const FamilyMember*>(data->convertible);
+			void* storage = ((bp::converter::rvalue_from_python_storage<FamilyValue<D> >*)data)->storage.bytes;
+
+			FamilyValue<D>* v = new (storage) FamilyValue<D>();
+			v->member = member;
+			member->get(o, &v->value);
+			data->convertible = storage;
+		}
+	};
+
+
+	template<typename T>
+	struct FamilyMemberOps
+	{
+		typedef typename family_of<T>::type 	family_type;
+
+		static void get(PyObject* o, void* value) {
+			*static_cast<family_type*>(value) = family_type(*heldValue<T>(o));
+		}
+
+		static PyObject* make(const void* value) {
+			return toPython(T(*static_cast<const family_type*>(value)));
+		}
+	};
+
+
+	// adds the class T to its family, so that FamilyValue arguments accept it
+	template<typename T, typename Class>
+	void bindFamilyMember(Class& cl)
+	{
+		typedef typename family_of<T>::type family_type;
+
+		family_members& members = familyMembers(bp::type_id<family_type>());
+		if(members.empty())
+		{
+			bp::converter::registry::push_back(&FamilyConverter<family_type>::convertible,
+				&FamilyConverter<family_type>::construct, bp::type_id<FamilyValue<family_type> >());
+		}
+
+		FamilyMember member;
+		member.type = reinterpret_cast<PyTypeObject*>(cl.ptr());
+		member.get = &FamilyMemberOps<T>::get;
+		member.make = &FamilyMemberOps<T>::make;
+		members.push_back(member);
+	}
+}
+
+#endif
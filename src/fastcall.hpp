@@ -0,0 +1,140 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_FASTCALL__H_
+#define _PIMATH_FASTCALL__H_
+
+#include <boost/python.hpp>
+#include "util.h"
+
+
+/*
+ * Calling a boost.python function packs the arguments into a tuple, then tries each
+ * overload's converters in turn. For the most frequently called methods (dot, length,
+ * normalized, multVecMatrix etc) bindFastCall adds a METH_FASTCALL entry point on python
+ * 3.8 and later, which takes its arguments as a plain array and so avoids the tuple.
+ *
+ * A fast call implementation takes (self, args, nargs) and handles only the common case,
+ * eg both vectors exactly of the class's own type. It returns NULL without setting an
+ * exception if it doesn't handle the call, which then goes to the original boost.python
+ * function, as does any call with keyword arguments. For module-level functions self is
+ * NULL.
+ *
+ * The fast entry points replace the original functions when installFastCalls() is called at
+ * the end of module initialisation. Several may be bound to the same name (eg slerp, once
+ * per scalar type); each falls back to the one bound before it. On earlier pythons
+ * bindFastCall does nothing.
+ */
+
+#if PY_VERSION_HEX >= 0x03080000
+#define PIMATH_FASTCALL
+#endif
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	typedef PyObject* (*fastcall_impl)(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+
+	// replaces every function with a fast call entry point
+	void installFastCalls();
+
+
+#ifdef PIMATH_FASTCALL
+
+	// records a fast call entry point for ns.name
+	void addFastCall(const bp::object& ns, const char* name, PyMethodDef* def, PyObject** fallback);
+
+	// calls the original function, with self prepended to the args for a method; returns
+	// NULL with the python error set on failure, and never throws
+	PyObject* callFastCallFallback(PyObject* fallback, PyObject* self,
+		PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames);
+
+
+	template<fastcall_impl Impl>
+	struct FastCall
+	{
+		static PyMethodDef 	s_def;
+		static PyObject* 	s_fallback;
+
+		static PyObject* call(PyObject* self, PyObject* const* args, Py_ssize_t nargs,
+			PyObject* kwnames)
+		{
+			// c++ exceptions must not leave a METH_FASTCALL entry point
+			try
+			{
+				if(!kwnames)
+				{
+					PyObject* result = Impl(self, args, nargs);
+					if(result || PyErr_Occurred())
+						return result;
+				}
+
+				return callFastCallFallback(s_fallback, self, args, nargs, kwnames);
+			}
+			catch(...)
+			{
+				bp::handle_exception();
+				return NULL;
+			}
+		}
+	};
+
+	template<fastcall_impl Impl>
+	PyMethodDef FastCall<Impl>::s_def = {
+		0, reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)()>(FastCall<Impl>::call)),
+		METH_FASTCALL|METH_KEYWORDS, 0
+	};
+
+	template<fastcall_impl Impl>
+	PyObject* FastCall<Impl>::s_fallback = 0;
+
+#endif
+
+
+	// adds a fast call entry point for the method 'name' of a class
+	template<fastcall_impl Impl, typename BpClass>
+	void bindFastCall(BpClass& cl, const char* name)
+	{
+#ifdef PIMATH_FASTCALL
+		addFastCall(cl, name, &FastCall<Impl>::s_def, &FastCall<Impl>::s_fallback);
+#endif
+	}
+
+	// adds a fast call entry point for the function 'name' in the current scope
+	template<fastcall_impl Impl>
+	void defFastCall(const char* name)
+	{
+#ifdef PIMATH_FASTCALL
+		addFastCall(bp::scope(), name, &FastCall<Impl>::s_def, &FastCall<Impl>::s_fallback);
+#endif
+	}
+
+}
+
+#endif
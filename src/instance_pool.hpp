@@ -0,0 +1,176 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_INSTANCE_POOL__H_
+#define _PIMATH_INSTANCE_POOL__H_
+
+#include <boost/python.hpp>
+#include <vector>
+#include <string>
+#include <cstring>
+
+
+/*
+ * Small value types (V3f, Quatf, M44f etc) are created and destroyed at a very high rate
+ * by python code - every '+' or 'normalized' creates a new instance. The instance pool
+ * replaces tp_alloc/tp_free on these classes with versions that keep freed instances on
+ * a per-type free list, and hand them back out on the next allocation.
+ *
+ * Only instances of the bound class itself are pooled; python subclasses allocate
+ * normally. pimath.instancePoolStats() reports the hit rate for each pooled type.
+ */
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	struct InstancePoolData
+	{
+		InstancePoolData()
+		:	type(0), alloc(0), free(0), nitems(-1), enabled(true),
+			hits(0), misses(0), recycled(0)
+		{}
+
+		PyTypeObject* 			type;
+		allocfunc 				alloc;		// the type's original tp_alloc
+		freefunc 				free;		// the type's original tp_free
+		Py_ssize_t 				nitems;		// instance size, fixed by the first allocation
+		bool 					enabled;
+		std::vector<PyObject*> 	freeList;
+
+		unsigned long 			hits;
+		unsigned long 			misses;
+		unsigned long 			recycled;
+
+		// releases all pooled instances back to python
+		void clear()
+		{
+			for(std::size_t i=0; i<freeList.size(); ++i)
+				free(freeList[i]);
+			freeList.clear();
+		}
+	};
+
+
+	// pool registry, shared by all types
+	struct InstancePools
+	{
+		static void add(InstancePoolData* pool);
+		static bp::dict stats();
+		static void clear();
+		static void setCapacity(std::size_t capacity);
+
+		static std::size_t s_capacity;
+	};
+
+
+	template<typename T>
+	struct InstancePool
+	{
+		static void enable(PyTypeObject* type)
+		{
+			if(s_pool.type)
+				return;
+
+			s_pool.type = type;
+			s_pool.alloc = type->tp_alloc;
+			s_pool.free = type->tp_free;
+			type->tp_alloc = alloc;
+			type->tp_free = free;
+			InstancePools::add(&s_pool);
+		}
+
+		static PyObject* alloc(PyTypeObject* type, Py_ssize_t nitems)
+		{
+			InstancePoolData& p = s_pool;
+
+			if((type == p.type) && p.enabled)
+			{
+				if(p.nitems < 0)
+					p.nitems = nitems;
+				else if(nitems != p.nitems)
+				{
+					// boost.python always asks for the same size per type. If that
+					// ever changes, pooled storage may be too small - stop pooling.
+					p.enabled = false;
+					p.clear();
+				}
+
+				if(p.enabled && !p.freeList.empty())
+				{
+					PyObject* obj = p.freeList.back();
+					p.freeList.pop_back();
+					++p.hits;
+
+					// as per PyType_GenericAlloc
+					std::memset(obj, 0, _PyObject_VAR_SIZE(type, nitems+1));
+#if PY_VERSION_HEX < 0x03080000
+					if(type->tp_flags & Py_TPFLAGS_HEAPTYPE)
+						Py_INCREF(type);
+#endif
+					PyObject_INIT_VAR(reinterpret_cast<PyVarObject*>(obj), type, nitems);
+					if(PyType_IS_GC(type))
+						PyObject_GC_Track(obj);
+					return obj;
+				}
+			}
+
+			++p.misses;
+			return p.alloc(type, nitems);
+		}
+
+		static void free(void* ptr)
+		{
+			InstancePoolData& p = s_pool;
+			PyObject* obj = static_cast<PyObject*>(ptr);
+
+			if(	(Py_TYPE(obj) == p.type) && p.enabled &&
+				(p.freeList.size() < InstancePools::s_capacity))
+			{
+				p.freeList.push_back(obj);
+				++p.recycled;
+			}
+			else
+				p.free(ptr);
+		}
+
+		static InstancePoolData s_pool;
+	};
+
+	template<typename T>
+	InstancePoolData InstancePool<T>::s_pool;
+
+
+	template<typename BpClass, typename T>
+	void bindInstancePool(BpClass& cl)
+	{
+		InstancePool<T>::enable(reinterpret_cast<PyTypeObject*>(cl.ptr()));
+	}
+}
+
+#endif
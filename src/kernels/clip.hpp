@@ -0,0 +1,224 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_CLIP__H_
+#define _PIMATH_KERNELS_CLIP__H_
+
+#include <ImathVec.h>
+#include <ImathPlane.h>
+#include <ImathBox.h>
+#include <vector>
+#include <cstddef>
+#include "parallel.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	/*
+	 * Clipped triangles, compacted: triangle i of the output is points[3*i] to points[3*i+2],
+	 * cut from input triangle sources[i]. barycentrics[3*i+j] gives output vertex j as weights
+	 * of the source triangle's three vertices, for interpolating its other attributes.
+	 * Triangles wholly inside are passed through unchanged, with weights (1,0,0), (0,1,0)
+	 * and (0,0,1).
+	 */
+	template<typename T>
+	struct ClippedTriangles
+	{
+		std::vector<Imath::Vec3<T> > 	points;
+		std::vector<int> 				sources;
+		std::vector<Imath::Vec3<T> > 	barycentrics;
+
+		void clear()
+		{
+			points.clear();
+			sources.clear();
+			barycentrics.clear();
+		}
+	};
+
+
+	namespace detail
+	{
+		// a polygon vertex during clipping: its position, and its weights in the source triangle
+		template<typename T>
+		struct ClipVertex
+		{
+			Imath::Vec3<T> p;
+			Imath::Vec3<T> w;
+		};
+
+		template<typename T>
+		struct ClipTask
+		{
+			ClipTask(const Imath::Vec3<T>* points, const Imath::Plane3<T>* planes, std::size_t nPlanes,
+				std::vector<ClippedTriangles<T> >& pieces)
+			:	m_points(points), m_planes(planes), m_nPlanes(nPlanes), m_pieces(pieces) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				typedef Imath::Vec3<T> vec_type;
+
+				ClippedTriangles<T>& out = m_pieces[piece];
+				out.clear();
+
+				// Each pass builds a new polygon by push_back. A convex polygon gains at most
+				// one vertex per plane in exact arithmetic, but with nearly coincident planes
+				// rounding can add more, so no size is assumed.
+				std::vector<ClipVertex<T> > poly, clipped;
+				std::vector<T> dist;
+
+				for(std::size_t tri=begin; tri<end; ++tri)
+				{
+					const vec_type* p = m_points + tri*3;
+					poly.resize(3);
+					for(int j=0; j<3; ++j)
+					{
+						poly[j].p = p[j];
+						poly[j].w = vec_type(T(j == 0), T(j == 1), T(j == 2));
+					}
+
+					for(std::size_t k=0; (k<m_nPlanes) && (poly.size() >= 3); ++k)
+					{
+						const std::size_t count = poly.size();
+						dist.resize(count);
+						std::size_t inside = 0;
+						for(std::size_t j=0; j<count; ++j)
+						{
+							dist[j] = m_planes[k].distanceTo(poly[j].p);
+							inside += (dist[j] <= 0);
+						}
+						if(inside == count)
+							continue;
+
+						// Sutherland-Hodgman: keep inside vertices, and add a vertex where an
+						// edge strictly crosses the plane (a vertex on the plane is kept, and
+						// is not repeated as a crossing). Crossings are found from the inside
+						// end, so that triangles sharing an edge cut it at exactly the same point.
+						clipped.clear();
+						for(std::size_t j=0; j<count; ++j)
+						{
+							const std::size_t next = (j+1 == count)? 0 : j+1;
+							const bool in = (dist[j] <= 0);
+							if(in)
+								clipped.push_back(poly[j]);
+							if(((dist[j] < 0) && (dist[next] > 0)) || ((dist[j] > 0) && (dist[next] < 0)))
+							{
+								const std::size_t a = in? j : next;
+								const std::size_t b = in? next : j;
+								const T s = dist[a] / (dist[a] - dist[b]);
+								ClipVertex<T> v;
+								v.p = poly[a].p + (poly[b].p - poly[a].p) * s;
+								v.w = poly[a].w + (poly[b].w - poly[a].w) * s;
+								clipped.push_back(v);
+							}
+						}
+						poly.swap(clipped);
+					}
+
+					// the clipped polygon as a fan, leaving out triangles of zero area
+					for(std::size_t j=1; j+1<poly.size(); ++j)
+					{
+						if(((poly[j].p - poly[0].p) % (poly[j+1].p - poly[0].p)) == vec_type(0))
+							continue;
+
+						out.points.push_back(poly[0].p);
+						out.points.push_back(poly[j].p);
+						out.points.push_back(poly[j+1].p);
+						out.barycentrics.push_back(poly[0].w);
+						out.barycentrics.push_back(poly[j].w);
+						out.barycentrics.push_back(poly[j+1].w);
+						out.sources.push_back(static_cast<int>(tri));
+					}
+				}
+			}
+
+			const Imath::Vec3<T>* m_points;
+			const Imath::Plane3<T>* m_planes;
+			std::size_t m_nPlanes;
+			std::vector<ClippedTriangles<T> >& m_pieces;
+		};
+	}
+
+
+	/*
+	 * Clips a triangle soup (points holds three vertices per triangle) to the region behind
+	 * every plane, where Plane3::distanceTo is <= 0, by Sutherland-Hodgman. Imath's
+	 * Frustum::planes point outwards, so clipping to them keeps what is inside the frustum.
+	 * Triangles of zero area - degenerate ones, and those clipped down to an edge or point
+	 * lying on a plane - are left out. Triangles run in parallel, each thread into a buffer
+	 * of its own, and the buffers are then joined in triangle order, so the result doesn't
+	 * depend on the number of threads.
+	 */
+	template<typename T>
+	void clipTriangles(const Imath::Vec3<T>* points, std::size_t triangles,
+		const Imath::Plane3<T>* planes, std::size_t nPlanes, ClippedTriangles<T>& result)
+	{
+		std::vector<ClippedTriangles<T> > pieces(threadCount());
+		parallelFor(triangles, static_cast<int>(pieces.size()),
+			detail::ClipTask<T>(points, planes, nPlanes, pieces));
+
+		result.clear();
+		std::size_t total = 0;
+		for(std::size_t i=0; i<pieces.size(); ++i)
+			total += pieces[i].sources.size();
+		result.points.reserve(total*3);
+		result.sources.reserve(total);
+		result.barycentrics.reserve(total*3);
+
+		for(std::size_t i=0; i<pieces.size(); ++i)
+		{
+			const ClippedTriangles<T>& piece = pieces[i];
+			result.points.insert(result.points.end(), piece.points.begin(), piece.points.end());
+			result.sources.insert(result.sources.end(), piece.sources.begin(), piece.sources.end());
+			result.barycentrics.insert(result.barycentrics.end(), piece.barycentrics.begin(),
+				piece.barycentrics.end());
+		}
+	}
+
+	// as above, to the inside of a box; everything is clipped away by an empty box
+	template<typename T>
+	void clipTriangles(const Imath::Vec3<T>* points, std::size_t triangles,
+		const Imath::Box<Imath::Vec3<T> >& box, ClippedTriangles<T>& result)
+	{
+		typedef Imath::Vec3<T> vec_type;
+
+		// the box's faces, with outward normals
+		Imath::Plane3<T> planes[6];
+		for(int j=0; j<3; ++j)
+		{
+			vec_type n(0);
+			n[j] = 1;
+			planes[2*j] = Imath::Plane3<T>(-n, -box.min[j]);
+			planes[2*j+1] = Imath::Plane3<T>(n, box.max[j]);
+		}
+		clipTriangles(points, triangles, planes, 6, result);
+	}
+
+} }
+
+#endif
@@ -0,0 +1,387 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_HASHGRID__H_
+#define _PIMATH_KERNELS_HASHGRID__H_
+
+#include <ImathVec.h>
+#include <ImathBox.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "parallel.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	/*
+	 * A uniform grid over Vec3 points, for radius queries which are cheaper to rebuild
+	 * than a KdTree. The grid's cell size is bounds.size() / resolution and its origin is
+	 * bounds.min, but points outside the bounds are still indexed: cells are hashed into a
+	 * table of about one bucket per point, so the grid is unbounded and its memory depends
+	 * only on the number of points.
+	 *
+	 * build() counting-sorts the points by bucket in parallel (a stable radix sort, so the
+	 * result doesn't depend on the number of threads), reusing its storage from one build
+	 * to the next. Results are indices into the array it was built from.
+	 */
+	template<typename T>
+	class HashGrid
+	{
+	public:
+
+		typedef Imath::Vec3<T> 				vec_type;
+		typedef Imath::Box<vec_type> 		box_type;
+		typedef Imath::V3i 					cell_type;
+		typedef std::pair<int, int> 		pair_type;
+
+		HashGrid(const box_type& bounds, const cell_type& resolution)
+		:	m_origin(bounds.isEmpty()? vec_type(T(0)) : bounds.min),
+			m_mask(0)
+		{
+			for(int i=0; i<3; ++i)
+			{
+				const T size = bounds.isEmpty()? T(0) : bounds.max[i] - bounds.min[i];
+				m_cellSize[i] = size / T(std::max(resolution[i], 1));
+				if(!(m_cellSize[i] > T(0)))
+					m_cellSize[i] = T(1);
+				m_invCellSize[i] = T(1) / m_cellSize[i];
+			}
+			m_start.assign(2, 0);
+		}
+
+		std::size_t size() const 				{ return m_points.size(); }
+		const vec_type& cellSize() const 		{ return m_cellSize; }
+
+		cell_type cellOf(const vec_type& p) const
+		{
+			return cell_type(toCell((p.x - m_origin.x) * m_invCellSize.x),
+				toCell((p.y - m_origin.y) * m_invCellSize.y),
+				toCell((p.z - m_origin.z) * m_invCellSize.z));
+		}
+
+		void build(const vec_type* points, std::size_t n)
+		{
+			unsigned bits = 0;
+			while((std::size_t(1) << bits) < n)
+				++bits;
+			m_mask = (1u << bits) - 1;
+
+			m_items.resize(n);
+			m_temp.resize(n);
+			parallelFor(n, KeyTask(*this, points));
+
+			// least significant digit first, which keeps each pass stable; digits are as
+			// even as possible, since each pass costs the same
+			const unsigned passes = (bits + MaxDigitBits - 1) / MaxDigitBits;
+			const unsigned digitBits = passes? (bits + passes - 1) / passes : 0;
+			for(unsigned shift=0; shift<bits; shift+=digitBits)
+			{
+				sortPass(shift, digitBits);
+				m_items.swap(m_temp);
+			}
+
+			m_points.resize(n);
+			m_index.resize(n);
+			m_start.resize(std::size_t(m_mask) + 2);
+			parallelFor(n, GatherTask(*this, points));
+			if(!n)
+				m_start.assign(m_start.size(), 0);
+		}
+
+		// appends the indices of the points in cell c
+		void cell(const cell_type& c, std::vector<int>& result) const
+		{
+			const unsigned b = bucketOf(c);
+			for(int i=m_start[b]; i<m_start[b+1]; ++i)
+			{
+				if(cellOf(m_points[i]) == c)
+					result.push_back(m_index[i]);
+			}
+		}
+
+		// appends the indices of every point within 'radius' of q, in no particular order
+		void radius(const vec_type& q, T radius, std::vector<int>& result) const {
+			visit(q, radius, 0, IndexVisitor(*this, result));
+		}
+
+		// appends every pair of points (i, j), i < j, no further than 'radius' apart
+		void pairs(T radius, std::vector<pair_type>& result) const
+		{
+			const int pieces = threadCount();
+			std::vector<std::vector<pair_type> > found(pieces);
+			parallelFor(size(), pieces, PairsTask(*this, radius, found));
+
+			for(int p=0; p<pieces; ++p)
+				result.insert(result.end(), found[p].begin(), found[p].end());
+		}
+
+	private:
+
+		enum { MaxDigitBits = 12 };
+
+		struct Item
+		{
+			unsigned key;
+			int index;
+		};
+
+		static int toCell(T x)
+		{
+			const T limit = T(1 << 30);
+			x = std::floor(x);
+			return (x < -limit)? -(1 << 30) : (x > limit)? (1 << 30) : static_cast<int>(x);
+		}
+
+		unsigned bucketOf(const cell_type& c) const
+		{
+			return ((unsigned(c.x) * 73856093u) ^ (unsigned(c.y) * 19349663u)
+				^ (unsigned(c.z) * 83492791u)) & m_mask;
+		}
+
+		struct KeyTask
+		{
+			KeyTask(HashGrid& grid, const vec_type* points):m_grid(&grid), m_points(points) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					Item& item = m_grid->m_items[i];
+					item.key = m_grid->bucketOf(m_grid->cellOf(m_points[i]));
+					item.index = static_cast<int>(i);
+				}
+			}
+
+			HashGrid* m_grid;
+			const vec_type* m_points;
+		};
+
+		struct CountTask
+		{
+			CountTask(const std::vector<Item>& items, unsigned shift, unsigned digits,
+				std::vector<std::size_t>& counts)
+			:	m_items(&items), m_shift(shift), m_digits(digits), m_counts(&counts) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				std::size_t* counts = &(*m_counts)[std::size_t(piece) * m_digits];
+				for(std::size_t i=begin; i<end; ++i)
+					++counts[((*m_items)[i].key >> m_shift) & (m_digits-1)];
+			}
+
+			const std::vector<Item>* m_items;
+			unsigned m_shift;
+			unsigned m_digits;
+			std::vector<std::size_t>* m_counts;
+		};
+
+		struct ScatterTask
+		{
+			ScatterTask(const std::vector<Item>& items, std::vector<Item>& dst, unsigned shift,
+				unsigned digits, std::vector<std::size_t>& offsets)
+			:	m_items(&items), m_dst(&dst), m_shift(shift), m_digits(digits), m_offsets(&offsets) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				std::size_t* offsets = &(*m_offsets)[std::size_t(piece) * m_digits];
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const Item& item = (*m_items)[i];
+					(*m_dst)[offsets[(item.key >> m_shift) & (m_digits-1)]++] = item;
+				}
+			}
+
+			const std::vector<Item>* m_items;
+			std::vector<Item>* m_dst;
+			unsigned m_shift;
+			unsigned m_digits;
+			std::vector<std::size_t>* m_offsets;
+		};
+
+		// one counting sort pass, on the digit at 'shift', from m_items into m_temp
+		void sortPass(unsigned shift, unsigned digitBits)
+		{
+			const unsigned digits = 1u << digitBits;
+			const int pieces = threadCount();
+			std::vector<std::size_t> counts(std::size_t(pieces) * digits, 0);
+			parallelFor(m_items.size(), pieces, CountTask(m_items, shift, digits, counts));
+
+			// each piece writes after the earlier pieces' items with the same digit
+			std::size_t offset = 0;
+			for(unsigned d=0; d<digits; ++d)
+			{
+				for(int p=0; p<pieces; ++p)
+				{
+					std::size_t& c = counts[std::size_t(p) * digits + d];
+					const std::size_t count = c;
+					c = offset;
+					offset += count;
+				}
+			}
+
+			parallelFor(m_items.size(), pieces,
+				ScatterTask(m_items, m_temp, shift, digits, counts));
+		}
+
+		struct GatherTask
+		{
+			GatherTask(HashGrid& grid, const vec_type* points):m_grid(&grid), m_points(points) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				const std::vector<Item>& items = m_grid->m_items;
+				std::vector<int>& start = m_grid->m_start;
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					m_grid->m_points[i] = m_points[items[i].index];
+					m_grid->m_index[i] = items[i].index;
+
+					// the buckets which start here, including any empty ones before it
+					const std::size_t first = i? std::size_t(items[i-1].key) + 1 : 0;
+					for(std::size_t b=first; b<=items[i].key; ++b)
+						start[b] = static_cast<int>(i);
+					if(i+1 == items.size())
+					{
+						for(std::size_t b=std::size_t(items[i].key) + 1; b<start.size(); ++b)
+							start[b] = static_cast<int>(items.size());
+					}
+				}
+			}
+
+			HashGrid* m_grid;
+			const vec_type* m_points;
+		};
+
+		// calls fn(i) for each point i (a position in m_points) within 'radius' of q,
+		// skipping positions before 'from'
+		template<typename Fn>
+		void visit(const vec_type& q, T radius, std::size_t from, const Fn& fn) const
+		{
+			const T r2 = radius * radius;
+			const cell_type lo = cellOf(q - vec_type(radius));
+			const cell_type hi = cellOf(q + vec_type(radius));
+
+			// past about one cell per point, scanning them all is cheaper
+			const double cells = (double(hi.x) - lo.x + 1) * (double(hi.y) - lo.y + 1)
+				* (double(hi.z) - lo.z + 1);
+			if(cells > double(m_start.size()))
+			{
+				for(std::size_t i=from; i<size(); ++i)
+				{
+					if((m_points[i] - q).length2() <= r2)
+						fn(i);
+				}
+				return;
+			}
+
+			for(int z=lo.z; z<=hi.z; ++z)
+			{
+				for(int y=lo.y; y<=hi.y; ++y)
+				{
+					for(int x=lo.x; x<=hi.x; ++x)
+					{
+						// a bucket may hold several cells; each is visited as its own
+						const cell_type c(x, y, z);
+						const unsigned b = bucketOf(c);
+						const std::size_t end = m_start[b+1];
+						for(std::size_t i=std::max(std::size_t(m_start[b]), from); i<end; ++i)
+						{
+							if(((m_points[i] - q).length2() <= r2) && (cellOf(m_points[i]) == c))
+								fn(i);
+						}
+					}
+				}
+			}
+		}
+
+		struct IndexVisitor
+		{
+			IndexVisitor(const HashGrid& grid, std::vector<int>& result)
+			:	m_grid(&grid), m_result(&result) {}
+
+			void operator()(std::size_t i) const { m_result->push_back(m_grid->m_index[i]); }
+
+			const HashGrid* m_grid;
+			std::vector<int>* m_result;
+		};
+
+		struct PairVisitor
+		{
+			PairVisitor(const HashGrid& grid, int index, std::vector<pair_type>& result)
+			:	m_grid(&grid), m_index(index), m_result(&result) {}
+
+			void operator()(std::size_t i) const
+			{
+				const int j = m_grid->m_index[i];
+				m_result->push_back((m_index < j)? pair_type(m_index, j) : pair_type(j, m_index));
+			}
+
+			const HashGrid* m_grid;
+			int m_index;
+			std::vector<pair_type>* m_result;
+		};
+
+		struct PairsTask
+		{
+			PairsTask(const HashGrid& grid, T radius, std::vector<std::vector<pair_type> >& found)
+			:	m_grid(&grid), m_radius(radius), m_found(&found) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				// each pair is found once, from the point earlier in m_points
+				std::vector<pair_type>& found = (*m_found)[piece];
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					m_grid->visit(m_grid->m_points[i], m_radius, i+1,
+						PairVisitor(*m_grid, m_grid->m_index[i], found));
+				}
+			}
+
+			const HashGrid* m_grid;
+			T m_radius;
+			std::vector<std::vector<pair_type> >* m_found;
+		};
+
+		vec_type m_origin;
+		vec_type m_cellSize;
+		vec_type m_invCellSize;
+		unsigned m_mask;
+
+		std::vector<Item> m_items;
+		std::vector<Item> m_temp;
+		std::vector<vec_type> m_points;
+		std::vector<int> m_index;
+		std::vector<int> m_start; 		// bucket b's points are [m_start[b], m_start[b+1])
+	};
+
+} }
+
+#endif
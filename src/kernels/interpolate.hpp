@@ -0,0 +1,58 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_INTERPOLATE__H_
+#define _PIMATH_KERNELS_INTERPOLATE__H_
+
+#include <ImathVec.h>
+#include <cstddef>
+
+
+namespace pimath { namespace kernels
+{
+	// dst[i] = a[i]*(1-t) + b[i]*t, as Imath::lerp. dst may equal a or b.
+	template<typename Vec>
+	void lerp(const Vec* a, const Vec* b, typename Vec::BaseType t, Vec* dst, std::size_t n)
+	{
+		typedef typename Vec::BaseType T;
+		for(std::size_t i=0; i<n; ++i)
+			dst[i] = a[i] * (T(1) - t) + b[i] * t;
+	}
+
+	// as above, with a weight per element
+	template<typename Vec>
+	void lerp(const Vec* a, const Vec* b, const typename Vec::BaseType* t, Vec* dst, std::size_t n)
+	{
+		typedef typename Vec::BaseType T;
+		for(std::size_t i=0; i<n; ++i)
+			dst[i] = a[i] * (T(1) - t[i]) + b[i] * t[i];
+	}
+
+} }
+
+#endif
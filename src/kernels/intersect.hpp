@@ -0,0 +1,76 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_INTERSECT__H_
+#define _PIMATH_KERNELS_INTERSECT__H_
+
+#include <ImathLine.h>
+#include <ImathSphere.h>
+#include <cstddef>
+
+
+namespace pimath { namespace kernels
+{
+	// Intersects rays with spheres, as Sphere3::intersect, over flat arrays. Ray i starts at
+	// origins[i*rayStep] with direction dirs[i*rayStep] (unit length, as Line3::dir), and
+	// sphere i is centers[i*sphereStep] with radius radii[i*sphereStep]. Steps are 0 or 1,
+	// and 0 repeats the first element, so this tests many rays against one sphere, one ray
+	// against many spheres, or n rays against n spheres pairwise. Where ray i hits, hit[i]
+	// is set to 1, t[i] to the ray parameter and p[i] (unless p is null) to the hit point;
+	// otherwise hit[i] is 0 and t[i] and p[i] are left untouched. hit holds an int per ray
+	// so that the vector versions in simd.hpp can store their lane masks directly. Returns
+	// the number of hits.
+	template<typename T>
+	std::size_t intersectSpheres(const Imath::Vec3<T>* origins, const Imath::Vec3<T>* dirs,
+		std::size_t rayStep, const Imath::Vec3<T>* centers, const T* radii, std::size_t sphereStep,
+		std::size_t n, T* t, Imath::Vec3<T>* p, int* hit)
+	{
+		std::size_t hits = 0;
+		Imath::Line3<T> ray;
+		for(std::size_t i=0; i<n; ++i)
+		{
+			ray.pos = origins[i*rayStep];
+			ray.dir = dirs[i*rayStep];
+			const Imath::Sphere3<T> sphere(centers[i*sphereStep], radii[i*sphereStep]);
+
+			T ti;
+			hit[i] = sphere.intersectT(ray, ti);
+			if(hit[i])
+			{
+				t[i] = ti;
+				if(p)
+					p[i] = ray(ti);
+				++hits;
+			}
+		}
+		return hits;
+	}
+
+} }
+
+#endif
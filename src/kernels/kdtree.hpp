@@ -0,0 +1,473 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_KDTREE__H_
+#define _PIMATH_KERNELS_KDTREE__H_
+
+#include <ImathVec.h>
+#include <ImathBox.h>
+#include <ImathLine.h>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <cmath>
+#include <cstddef>
+#include "parallel.hpp"
+#include "points.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	/*
+	 * A balanced kd-tree over a copy of n Vec3 points. Each node splits its points at
+	 * their median along the axis of greatest extent, so the tree is implicit: node i's
+	 * children are 2i+1 and 2i+2, and a node's points are found by halving its parent's
+	 * range. Leaves hold at most 'leafSize' points. The points are stored in tree order,
+	 * and results are indices into the original array.
+	 *
+	 * The build runs the top levels serially and the subtrees below them in parallel.
+	 * Queries are const and may run concurrently; the batched forms run in parallel.
+	 * Query results are -1 (and a distance of max()) where there is no point to return.
+	 */
+	template<typename T>
+	class KdTree
+	{
+	public:
+
+		typedef Imath::Vec3<T> 				vec_type;
+		typedef Imath::Box<vec_type> 		box_type;
+		typedef Imath::Line3<T> 			line_type;
+
+		KdTree(const vec_type* points, std::size_t n, int leafSize = 16)
+		:	m_leafSize(std::max(leafSize, 1)),
+			m_depth(0),
+			m_bounds(kernels::bounds(points, n)),
+			m_index(n)
+		{
+			while(((n + (std::size_t(1) << m_depth) - 1) >> m_depth) > std::size_t(m_leafSize))
+				++m_depth;
+
+			const std::size_t internal = (std::size_t(1) << m_depth) - 1;
+			m_axis.resize(internal);
+			m_split.resize(internal);
+
+			// built on (point, index) pairs, which keeps the partitioning cache friendly
+			std::vector<Item> items(n);
+			for(std::size_t i=0; i<n; ++i)
+			{
+				items[i].p = points[i];
+				items[i].index = static_cast<int>(i);
+			}
+
+			build(items);
+
+			m_points.resize(n);
+			for(std::size_t i=0; i<n; ++i)
+			{
+				m_points[i] = items[i].p;
+				m_index[i] = items[i].index;
+			}
+		}
+
+		std::size_t size() const 			{ return m_points.size(); }
+		const box_type& bounds() const 		{ return m_bounds; }
+
+		// the index of the point closest to q, and its squared distance
+		int nearest(const vec_type& q, T* dist2 = 0) const
+		{
+			Best best;
+			nearest(0, 0, 0, size(), q, best);
+			if(dist2)
+				*dist2 = best.dist2;
+			return best.index;
+		}
+
+		// the k points closest to q, nearest first. Returns how many were found (at most k);
+		// index and dist2 must have room for k entries.
+		int knn(const vec_type& q, int k, int* index, T* dist2) const
+		{
+			std::vector<std::pair<T, int> > heap;
+			if(k > 0)
+			{
+				heap.reserve(k);
+				knn(0, 0, 0, size(), q, std::size_t(k), heap);
+			}
+
+			std::sort_heap(heap.begin(), heap.end());
+			for(std::size_t i=0; i<heap.size(); ++i)
+			{
+				index[i] = heap[i].second;
+				dist2[i] = heap[i].first;
+			}
+			return static_cast<int>(heap.size());
+		}
+
+		// appends the indices of every point within 'radius' of q, in no particular order
+		void radius(const vec_type& q, T radius, std::vector<int>& result) const {
+			withinRadius(0, 0, 0, size(), q, radius * radius, result);
+		}
+
+		// the point closest to a ray - line.pos + line.dir*t, for t >= 0 - and its squared
+		// distance from it, eg for picking
+		int nearestToRay(const line_type& line, T* dist2 = 0) const
+		{
+			Best best;
+			if(size())
+				nearestToRay(0, 0, 0, size(), m_bounds, line, best);
+			if(dist2)
+				*dist2 = best.dist2;
+			return best.index;
+		}
+
+		// batched queries, in parallel: nearest for n points, and knn with k results per
+		// point (unused entries are -1)
+		void nearest(const vec_type* q, std::size_t n, int* index, T* dist) const {
+			parallelFor(n, NearestTask(*this, q, index, dist));
+		}
+
+		void knn(const vec_type* q, std::size_t n, int k, int* index, T* dist) const {
+			parallelFor(n, KnnTask(*this, q, k, index, dist));
+		}
+
+	private:
+
+		struct Best
+		{
+			Best():index(-1), dist2(std::numeric_limits<T>::max()){}
+
+			int index;
+			T dist2;
+		};
+
+		struct Item
+		{
+			vec_type p;
+			int index;
+		};
+
+		struct AxisLess
+		{
+			AxisLess(int axis):m_axis(axis){}
+			bool operator()(const Item& a, const Item& b) const { return a.p[m_axis] < b.p[m_axis]; }
+
+			int m_axis;
+		};
+
+		struct Subtree
+		{
+			std::size_t node, level, begin, end;
+		};
+
+		struct BuildTask
+		{
+			BuildTask(KdTree& tree, std::vector<Item>& items, const std::vector<Subtree>& subtrees)
+			:	m_tree(&tree), m_items(&items), m_subtrees(&subtrees) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const Subtree& s = (*m_subtrees)[i];
+					m_tree->build(*m_items, s.node, s.level, s.begin, s.end, 0);
+				}
+			}
+
+			KdTree* m_tree;
+			std::vector<Item>* m_items;
+			const std::vector<Subtree>* m_subtrees;
+		};
+
+		struct NearestTask
+		{
+			NearestTask(const KdTree& tree, const vec_type* q, int* index, T* dist)
+			:	m_tree(&tree), m_q(q), m_index(index), m_dist(dist) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					T d2;
+					m_index[i] = m_tree->nearest(m_q[i], &d2);
+					m_dist[i] = (m_index[i] < 0)? d2 : std::sqrt(d2);
+				}
+			}
+
+			const KdTree* m_tree;
+			const vec_type* m_q;
+			int* m_index;
+			T* m_dist;
+		};
+
+		struct KnnTask
+		{
+			KnnTask(const KdTree& tree, const vec_type* q, int k, int* index, T* dist)
+			:	m_tree(&tree), m_q(q), m_k(k), m_index(index), m_dist(dist) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					int* index = m_index + i*m_k;
+					T* dist = m_dist + i*m_k;
+					const int found = m_tree->knn(m_q[i], m_k, index, dist);
+					for(int j=0; j<found; ++j)
+						dist[j] = std::sqrt(dist[j]);
+					for(int j=found; j<m_k; ++j)
+					{
+						index[j] = -1;
+						dist[j] = std::numeric_limits<T>::max();
+					}
+				}
+			}
+
+			const KdTree* m_tree;
+			const vec_type* m_q;
+			int m_k;
+			int* m_index;
+			T* m_dist;
+		};
+
+
+		void build(std::vector<Item>& items)
+		{
+			// enough subtrees to keep every thread busy
+			std::size_t levels = 0;
+			while((std::size_t(1) << levels) < std::size_t(4 * threadCount()))
+				++levels;
+			levels = std::min(levels, m_depth);
+
+			std::vector<Subtree> subtrees;
+			build(items, 0, 0, 0, items.size(), levels, &subtrees);
+			parallelFor(subtrees.size(), static_cast<int>(subtrees.size()),
+				BuildTask(*this, items, subtrees));
+		}
+
+		// builds down to level 'stop' (0 for the whole subtree), and lists the subtrees
+		// left below it
+		void build(std::vector<Item>& items, std::size_t node, std::size_t level,
+			std::size_t begin, std::size_t end, std::size_t stop, std::vector<Subtree>* rest = 0)
+		{
+			if(level == m_depth)
+				return;
+
+			if(stop && (level == stop))
+			{
+				Subtree s = { node, level, begin, end };
+				rest->push_back(s);
+				return;
+			}
+
+			box_type box;
+			for(std::size_t i=begin; i<end; ++i)
+				box.extendBy(items[i].p);
+
+			const vec_type size = box.max - box.min;
+			int axis = (size.y > size.x)? 1 : 0;
+			if(size.z > size[axis])
+				axis = 2;
+
+			const std::size_t mid = begin + (end - begin) / 2;
+			if(mid < end)
+			{
+				std::nth_element(items.begin() + begin, items.begin() + mid,
+					items.begin() + end, AxisLess(axis));
+				m_split[node] = items[mid].p[axis];
+			}
+			else
+				m_split[node] = T(0);
+			m_axis[node] = static_cast<unsigned char>(axis);
+
+			build(items, 2*node+1, level+1, begin, mid, stop, rest);
+			build(items, 2*node+2, level+1, mid, end, stop, rest);
+		}
+
+		void nearest(std::size_t node, std::size_t level, std::size_t begin, std::size_t end,
+			const vec_type& q, Best& best) const
+		{
+			if(level == m_depth)
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const T d2 = (m_points[i] - q).length2();
+					if(d2 < best.dist2)
+					{
+						best.dist2 = d2;
+						best.index = m_index[i];
+					}
+				}
+				return;
+			}
+
+			const std::size_t mid = begin + (end - begin) / 2;
+			const T diff = q[m_axis[node]] - m_split[node];
+			if(diff < 0)
+			{
+				nearest(2*node+1, level+1, begin, mid, q, best);
+				if(diff * diff < best.dist2)
+					nearest(2*node+2, level+1, mid, end, q, best);
+			}
+			else
+			{
+				nearest(2*node+2, level+1, mid, end, q, best);
+				if(diff * diff < best.dist2)
+					nearest(2*node+1, level+1, begin, mid, q, best);
+			}
+		}
+
+		void knn(std::size_t node, std::size_t level, std::size_t begin, std::size_t end,
+			const vec_type& q, std::size_t k, std::vector<std::pair<T, int> >& heap) const
+		{
+			if(level == m_depth)
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const T d2 = (m_points[i] - q).length2();
+					if(heap.size() < k)
+					{
+						heap.push_back(std::make_pair(d2, m_index[i]));
+						std::push_heap(heap.begin(), heap.end());
+					}
+					else if(d2 < heap.front().first)
+					{
+						std::pop_heap(heap.begin(), heap.end());
+						heap.back() = std::make_pair(d2, m_index[i]);
+						std::push_heap(heap.begin(), heap.end());
+					}
+				}
+				return;
+			}
+
+			const std::size_t mid = begin + (end - begin) / 2;
+			const T diff = q[m_axis[node]] - m_split[node];
+			const bool leftFirst = (diff < 0);
+
+			if(leftFirst)
+				knn(2*node+1, level+1, begin, mid, q, k, heap);
+			else
+				knn(2*node+2, level+1, mid, end, q, k, heap);
+
+			if((heap.size() < k) || (diff * diff < heap.front().first))
+			{
+				if(leftFirst)
+					knn(2*node+2, level+1, mid, end, q, k, heap);
+				else
+					knn(2*node+1, level+1, begin, mid, q, k, heap);
+			}
+		}
+
+		void withinRadius(std::size_t node, std::size_t level, std::size_t begin, std::size_t end,
+			const vec_type& q, T r2, std::vector<int>& result) const
+		{
+			if(level == m_depth)
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					if((m_points[i] - q).length2() <= r2)
+						result.push_back(m_index[i]);
+				}
+				return;
+			}
+
+			const std::size_t mid = begin + (end - begin) / 2;
+			const T diff = q[m_axis[node]] - m_split[node];
+			if((diff <= 0) || (diff * diff <= r2))
+				withinRadius(2*node+1, level+1, begin, mid, q, r2, result);
+			if((diff >= 0) || (diff * diff <= r2))
+				withinRadius(2*node+2, level+1, mid, end, q, r2, result);
+		}
+
+		static T rayDistance2(const line_type& line, const vec_type& p)
+		{
+			const vec_type v = p - line.pos;
+			const T dd = line.dir ^ line.dir;
+			T t = (dd > T(0))? (v ^ line.dir) / dd : T(0);
+			if(t < T(0))
+				t = T(0);
+			return (v - line.dir * t).length2();
+		}
+
+		void nearestToRay(std::size_t node, std::size_t level, std::size_t begin, std::size_t end,
+			const box_type& box, const line_type& line, Best& best) const
+		{
+			if(level == m_depth)
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const T d2 = rayDistance2(line, m_points[i]);
+					if(d2 < best.dist2)
+					{
+						best.dist2 = d2;
+						best.index = m_index[i];
+					}
+				}
+				return;
+			}
+
+			const std::size_t mid = begin + (end - begin) / 2;
+			const int axis = m_axis[node];
+
+			box_type child[2] = { box, box };
+			child[0].max[axis] = m_split[node];
+			child[1].min[axis] = m_split[node];
+
+			// a lower bound on the distance from the ray to each child, via its bounding sphere
+			T bound[2];
+			for(int c=0; c<2; ++c)
+			{
+				const vec_type halfSize = (child[c].max - child[c].min) * T(0.5);
+				const T d = std::sqrt(rayDistance2(line, child[c].min + halfSize)) - halfSize.length();
+				bound[c] = (d > T(0))? d*d : T(0);
+			}
+
+			const int first = (bound[1] < bound[0])? 1 : 0;
+			for(int j=0; j<2; ++j)
+			{
+				const int c = j? 1-first : first;
+				if(bound[c] < best.dist2)
+				{
+					if(c)
+						nearestToRay(2*node+2, level+1, mid, end, child[1], line, best);
+					else
+						nearestToRay(2*node+1, level+1, begin, mid, child[0], line, best);
+				}
+			}
+		}
+
+		int m_leafSize;
+		std::size_t m_depth;
+		box_type m_bounds;
+		std::vector<int> m_index;
+		std::vector<unsigned char> m_axis;
+		std::vector<T> m_split;
+		std::vector<vec_type> m_points;
+	};
+
+} }
+
+#endif
@@ -0,0 +1,76 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS__H_
+#define _PIMATH_KERNELS__H_
+
+/*
+ * The bulk kernels behind pimath's array types, as a header-only C++ library. These
+ * headers depend only on Imath and the standard library - not on python or boost.python -
+ * so native code can call them directly. They work on plain arrays of Imath values
+ * (eg const V3f* points, std::size_t n), and the pimath bindings wrap them.
+ *
+ * points.hpp 		transform, normalize and bounds over Vec3 arrays
+ * interpolate.hpp 	lerp over vector arrays, by one weight or a weight per element
+ * intersect.hpp 	batches of rays against spheres over flat arrays
+ * kdtree.hpp 		a kd-tree over Vec3 points, for nearest, k-nearest, radius and ray queries
+ * hashgrid.hpp 	a uniform grid over Vec3 points, for radius and all-pairs queries
+ * octree.hpp 		an out-of-core level-of-detail octree over point clouds, in a file
+ * normals.hpp 	face and vertex normals of triangle meshes
+ * pca.hpp 		compensated mean and covariance, a symmetric 3x3 eigen solver, and
+ * 					oriented bounding boxes
+ * planes.hpp 		signed distances, front/back/straddle classification of points, boxes
+ * 					and spheres, and line intersection against a plane
+ * clip.hpp 		Sutherland-Hodgman clipping of triangle soups to planes or a box
+ * spheres.hpp 	minimal (Welzl) and approximate (Ritter) bounding spheres, parallel
+ * 					ray-sphere batches and nearest-hit picking
+ * weld.hpp 		vertex welding within a tolerance, over quantized cells
+ * parallel.hpp 	parallelFor, over OpenMP when enabled
+ * random.hpp 		per-thread generators (ThreadRand) and bulk sampling
+ * simd.hpp 		SSE2/AVX2/AVX-512 versions of the float point and ray-sphere kernels,
+ * 					and half conversion. Including it makes the float overloads visible; for
+ * 					float arrays always include it (or this header) before calling.
+ */
+
+#include "points.hpp"
+#include "simd.hpp"
+#include "interpolate.hpp"
+#include "intersect.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include "kdtree.hpp"
+#include "hashgrid.hpp"
+#include "octree.hpp"
+#include "weld.hpp"
+#include "normals.hpp"
+#include "pca.hpp"
+#include "spheres.hpp"
+#include "planes.hpp"
+#include "clip.hpp"
+
+#endif
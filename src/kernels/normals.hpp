@@ -0,0 +1,209 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_NORMALS__H_
+#define _PIMATH_KERNELS_NORMALS__H_
+
+#include <ImathVec.h>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include "parallel.hpp"
+#include "points.hpp"
+#include "simd.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	enum NormalWeighting
+	{
+		AreaWeighted, 		// each face counts in proportion to its area
+		AngleWeighted 		// each face counts by its angle at the vertex
+	};
+
+
+	/*
+	 * The faces around each vertex of a triangle mesh, in compressed rows: vertex v's are
+	 * corners[offsets[v]] to corners[offsets[v+1]-1], where a corner is face*3 + (0, 1 or
+	 * 2). Build it once per topology; it lets vertex normals be summed per vertex, in
+	 * parallel and without locks, in the same order whatever the number of threads.
+	 * triangles holds three vertex indices per face, all less than nPoints.
+	 */
+	class VertexFaces
+	{
+	public:
+
+		VertexFaces(const int* triangles, std::size_t faces, std::size_t nPoints)
+		:	m_offsets(nPoints + 1, 0),
+			m_corners(faces * 3)
+		{
+			for(std::size_t i=0; i<faces*3; ++i)
+				++m_offsets[triangles[i] + 1];
+			for(std::size_t v=0; v<nPoints; ++v)
+				m_offsets[v+1] += m_offsets[v];
+
+			std::vector<int> fill(m_offsets.begin(), m_offsets.end() - 1);
+			for(std::size_t i=0; i<faces*3; ++i)
+				m_corners[fill[triangles[i]]++] = static_cast<int>(i);
+		}
+
+		std::size_t points() const 				{ return m_offsets.size() - 1; }
+		int begin(std::size_t v) const 			{ return m_offsets[v]; }
+		int end(std::size_t v) const 			{ return m_offsets[v+1]; }
+		int corner(int i) const 				{ return m_corners[i]; }
+
+	private:
+
+		std::vector<int> m_offsets;
+		std::vector<int> m_corners;
+	};
+
+
+	namespace detail
+	{
+		// unnormalized face normals: the cross product of two edges, twice the face's area
+		template<typename T>
+		struct FaceCrossTask
+		{
+			FaceCrossTask(const Imath::Vec3<T>* points, const int* triangles, Imath::Vec3<T>* normals)
+			:	m_points(points), m_triangles(triangles), m_normals(normals) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t f=begin; f<end; ++f)
+				{
+					const int* t = m_triangles + f*3;
+					const Imath::Vec3<T>& a = m_points[t[0]];
+					m_normals[f] = (m_points[t[1]] - a) % (m_points[t[2]] - a);
+				}
+			}
+
+			const Imath::Vec3<T>* m_points;
+			const int* m_triangles;
+			Imath::Vec3<T>* m_normals;
+		};
+
+		template<typename T>
+		struct VertexSumTask
+		{
+			VertexSumTask(const VertexFaces& faces, const Imath::Vec3<T>* points,
+				const int* triangles, const Imath::Vec3<T>* faceNormals,
+				NormalWeighting weighting, Imath::Vec3<T>* normals)
+			:	m_faces(&faces), m_points(points), m_triangles(triangles),
+				m_faceNormals(faceNormals), m_weighting(weighting), m_normals(normals) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t v=begin; v<end; ++v)
+				{
+					Imath::Vec3<T> sum(T(0));
+					for(int i=m_faces->begin(v); i<m_faces->end(v); ++i)
+					{
+						const int c = m_faces->corner(i);
+						const Imath::Vec3<T>& n = m_faceNormals[c/3];
+						if(m_weighting == AreaWeighted)
+						{
+							sum += n;
+							continue;
+						}
+
+						// the angle between the corner's two edges
+						const int* t = m_triangles + (c - c%3);
+						const Imath::Vec3<T>& p = m_points[t[c%3]];
+						const Imath::Vec3<T> e1 = m_points[t[(c+1)%3]] - p;
+						const Imath::Vec3<T> e2 = m_points[t[(c+2)%3]] - p;
+						const T len = n.length();
+						if(len > T(0))
+							sum += n * (std::atan2(len, e1 ^ e2) / len);
+					}
+					m_normals[v] = sum;
+				}
+			}
+
+			const VertexFaces* m_faces;
+			const Imath::Vec3<T>* m_points;
+			const int* m_triangles;
+			const Imath::Vec3<T>* m_faceNormals;
+			NormalWeighting m_weighting;
+			Imath::Vec3<T>* m_normals;
+		};
+
+		template<typename T>
+		struct NormalizeTask
+		{
+			NormalizeTask(Imath::Vec3<T>* p):m_p(p) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const {
+				normalize(m_p + begin, end - begin);
+			}
+
+			Imath::Vec3<T>* m_p;
+		};
+	}
+
+
+	// the unit normal of each face, by the right-hand rule; degenerate faces get (0,0,0)
+	template<typename T>
+	void faceNormals(const Imath::Vec3<T>* points, const int* triangles, std::size_t faces,
+		Imath::Vec3<T>* normals)
+	{
+		parallelFor(faces, detail::FaceCrossTask<T>(points, triangles, normals));
+		parallelFor(faces, detail::NormalizeTask<T>(normals));
+	}
+
+	/*
+	 * The unit normal of each vertex: the sum of its faces' normals, weighted by area or
+	 * angle. Vertices in no face (or only degenerate ones) get (0,0,0). The sums run in
+	 * parallel over vertices, and the normalization uses the SIMD kernels for floats.
+	 */
+	template<typename T>
+	void vertexNormals(const VertexFaces& vertexFaces, const Imath::Vec3<T>* points,
+		const int* triangles, std::size_t faces, NormalWeighting weighting, Imath::Vec3<T>* normals)
+	{
+		std::vector<Imath::Vec3<T> > crosses(faces);
+		if(faces)
+			parallelFor(faces, detail::FaceCrossTask<T>(points, triangles, &crosses[0]));
+
+		const std::size_t n = vertexFaces.points();
+		parallelFor(n, detail::VertexSumTask<T>(vertexFaces, points, triangles,
+			faces? &crosses[0] : 0, weighting, normals));
+		parallelFor(n, detail::NormalizeTask<T>(normals));
+	}
+
+	// as above, building the vertex-face table for a single call
+	template<typename T>
+	void vertexNormals(const Imath::Vec3<T>* points, std::size_t nPoints, const int* triangles,
+		std::size_t faces, NormalWeighting weighting, Imath::Vec3<T>* normals)
+	{
+		vertexNormals(VertexFaces(triangles, faces, nPoints), points, triangles, faces,
+			weighting, normals);
+	}
+
+} }
+
+#endif
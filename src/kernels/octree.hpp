@@ -0,0 +1,534 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_OCTREE__H_
+#define _PIMATH_KERNELS_OCTREE__H_
+
+#include <ImathVec.h>
+#include <ImathBox.h>
+#include <ImathMatrix.h>
+#include <ImathPlane.h>
+#include <ImathFrustum.h>
+#include <vector>
+#include <queue>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+
+namespace pimath { namespace kernels
+{
+	/*
+	 * An out-of-core, level-of-detail octree over a point cloud too large for memory,
+	 * stored in a single file. OctreeWriter builds it from points streamed in any number
+	 * of batches; PointOctree reads it back, picks the nodes a view needs, and loads only
+	 * those.
+	 *
+	 * Each node's box is an octant of its parent's, down from the root bounds, and holds a
+	 * subsample of the points within it: the first point to reach each empty cell of a
+	 * gridSize^3 grid over the node stays there, and the rest move on to the child octant.
+	 * Nodes at maxDepth keep every point which reaches them. A node's points are not
+	 * repeated in its children, so a view draws every node it selects (coarse nodes first).
+	 *
+	 * Points are written in chunks, as float offsets from their node's box.min (which keeps
+	 * their precision relative to the node), followed by an index of the nodes and their
+	 * chunks. The file is in native byte order.
+	 */
+	namespace octree
+	{
+		static const char Magic[8] = { 'P', 'I', 'O', 'C', 'T', 'R', 'E', 'E' };
+		static const char EndMagic[8] = { 'P', 'I', 'O', 'C', 'T', 'E', 'N', 'D' };
+		static const unsigned Version = 1;
+
+		struct Chunk
+		{
+			unsigned long long offset;
+			unsigned count;
+		};
+
+		template<typename V>
+		inline void write(std::ostream& os, const V& v) {
+			os.write(reinterpret_cast<const char*>(&v), sizeof(V));
+		}
+
+		template<typename V>
+		inline void read(std::istream& is, V& v) {
+			is.read(reinterpret_cast<char*>(&v), sizeof(V));
+		}
+
+		inline Imath::Box3d octant(const Imath::Box3d& box, int i)
+		{
+			const Imath::V3d c = (box.min + box.max) * 0.5;
+			Imath::Box3d result(box);
+			for(int a=0; a<3; ++a)
+			{
+				if(i & (1 << a))
+					result.min[a] = c[a];
+				else
+					result.max[a] = c[a];
+			}
+			return result;
+		}
+
+		inline void fail(const std::string& path, const char* what) {
+			throw std::runtime_error("Point octree " + path + ": " + what);
+		}
+	}
+
+
+	class OctreeWriter
+	{
+	public:
+
+		typedef Imath::V3d 				vec_type;
+		typedef Imath::Box3d 			box_type;
+
+		// memoryBudget is the number of points buffered before they're written out
+		OctreeWriter(const std::string& path, const box_type& bounds, int gridSize = 32,
+			int maxDepth = 16, std::size_t memoryBudget = 1 << 22)
+		:	m_path(path),
+			m_bounds(bounds),
+			m_gridSize(std::max(gridSize, 1)),
+			m_maxDepth(std::max(maxDepth, 0)),
+			m_budget(std::max(memoryBudget, std::size_t(1))),
+			m_buffered(0),
+			m_points(0),
+			m_outside(0),
+			m_file(path.c_str(), std::ios::binary | std::ios::trunc)
+		{
+			if(!m_file)
+				octree::fail(path, "can't open for writing.");
+			m_file.write(octree::Magic, sizeof(octree::Magic));
+			m_nodes.push_back(Node(-1, 0, 0, bounds));
+		}
+
+		~OctreeWriter()
+		{
+			try { close(); }
+			catch(...) {}
+		}
+
+		// points written, and points skipped because they were outside the root bounds
+		unsigned long long pointCount() const 		{ return m_points; }
+		unsigned long long outsideCount() const 	{ return m_outside; }
+
+		void add(const vec_type* points, std::size_t n)
+		{
+			if(!m_file.is_open())
+				octree::fail(m_path, "already closed.");
+
+			for(std::size_t i=0; i<n; ++i)
+				add(points[i]);
+		}
+
+		// flushes the remaining points and writes the index. Called by the destructor.
+		void close()
+		{
+			if(!m_file.is_open())
+				return;
+
+			for(std::size_t i=0; i<m_nodes.size(); ++i)
+				flush(m_nodes[i]);
+
+			const unsigned long long indexOffset = m_file.tellp();
+			octree::write(m_file, octree::Version);
+			octree::write(m_file, m_gridSize);
+			octree::write(m_file, m_maxDepth);
+			octree::write(m_file, m_bounds);
+			octree::write(m_file, static_cast<unsigned long long>(m_nodes.size()));
+			for(std::size_t i=0; i<m_nodes.size(); ++i)
+			{
+				const Node& node = m_nodes[i];
+				octree::write(m_file, node.parent);
+				octree::write(m_file, node.octant);
+				octree::write(m_file, node.count);
+				octree::write(m_file, static_cast<unsigned>(node.chunks.size()));
+				for(std::size_t j=0; j<node.chunks.size(); ++j)
+				{
+					octree::write(m_file, node.chunks[j].offset);
+					octree::write(m_file, node.chunks[j].count);
+				}
+			}
+			octree::write(m_file, indexOffset);
+			m_file.write(octree::EndMagic, sizeof(octree::EndMagic));
+
+			const bool ok = m_file.good();
+			m_file.close();
+			if(!ok)
+				octree::fail(m_path, "write failed.");
+		}
+
+	private:
+
+		struct Node
+		{
+			Node(int parent_, int octant_, int depth_, const box_type& box_)
+			:	parent(parent_), octant(octant_), depth(depth_), box(box_), count(0)
+			{
+				std::fill(child, child+8, -1);
+			}
+
+			int parent;
+			int octant;
+			int depth;
+			box_type box;
+			int child[8];
+			unsigned long long count;
+			std::vector<unsigned> occupied; 	// one bit per grid cell, allocated on first use
+			std::vector<Imath::V3f> buffer;
+			std::vector<octree::Chunk> chunks;
+		};
+
+		enum { ChunkSize = 16384 };
+
+		void add(const vec_type& p)
+		{
+			if(!m_bounds.intersects(p))
+			{
+				++m_outside;
+				return;
+			}
+
+			int index = 0;
+			for(;;)
+			{
+				Node& node = m_nodes[index];
+				if((node.depth == m_maxDepth) || claim(node, p))
+				{
+					accept(node, p);
+					return;
+				}
+
+				const vec_type c = (node.box.min + node.box.max) * 0.5;
+				const int octant = (p.x >= c.x? 1 : 0) | (p.y >= c.y? 2 : 0) | (p.z >= c.z? 4 : 0);
+				int child = node.child[octant];
+				if(child < 0)
+				{
+					child = static_cast<int>(m_nodes.size());
+					m_nodes[index].child[octant] = child;
+					const Node& parent = m_nodes[index];
+					m_nodes.push_back(Node(index, octant, parent.depth+1,
+						octree::octant(parent.box, octant)));
+				}
+				index = child;
+			}
+		}
+
+		// marks p's grid cell in node occupied, returning false if it already was
+		bool claim(Node& node, const vec_type& p)
+		{
+			const std::size_t g = m_gridSize;
+			if(node.occupied.empty())
+				node.occupied.assign((g*g*g + 31) / 32, 0u);
+
+			std::size_t cell = 0;
+			for(int a=2; a>=0; --a)
+			{
+				const double size = node.box.max[a] - node.box.min[a];
+				const double x = (size > 0.0)? (p[a] - node.box.min[a]) / size * double(g) : 0.0;
+				const std::size_t i = std::min(static_cast<std::size_t>(std::max(x, 0.0)), g-1);
+				cell = cell * g + i;
+			}
+
+			unsigned& word = node.occupied[cell / 32];
+			const unsigned bit = 1u << (cell % 32);
+			if(word & bit)
+				return false;
+			word |= bit;
+			return true;
+		}
+
+		void accept(Node& node, const vec_type& p)
+		{
+			const vec_type offset = p - node.box.min;
+			node.buffer.push_back(Imath::V3f(float(offset.x), float(offset.y), float(offset.z)));
+			++node.count;
+			++m_points;
+			++m_buffered;
+
+			if(node.buffer.size() >= std::size_t(ChunkSize))
+				flush(node);
+
+			if(m_buffered >= m_budget)
+			{
+				for(std::size_t i=0; i<m_nodes.size(); ++i)
+					flush(m_nodes[i]);
+			}
+		}
+
+		void flush(Node& node)
+		{
+			if(node.buffer.empty())
+				return;
+
+			octree::Chunk chunk;
+			chunk.offset = m_file.tellp();
+			chunk.count = static_cast<unsigned>(node.buffer.size());
+			m_file.write(reinterpret_cast<const char*>(&node.buffer[0]),
+				node.buffer.size() * sizeof(Imath::V3f));
+			if(!m_file)
+				octree::fail(m_path, "write failed.");
+
+			node.chunks.push_back(chunk);
+			m_buffered -= node.buffer.size();
+			std::vector<Imath::V3f>().swap(node.buffer);
+		}
+
+		std::string m_path;
+		box_type m_bounds;
+		int m_gridSize;
+		int m_maxDepth;
+		std::size_t m_budget;
+		std::size_t m_buffered;
+		unsigned long long m_points;
+		unsigned long long m_outside;
+		std::ofstream m_file;
+		std::vector<Node> m_nodes;
+	};
+
+
+	class PointOctree
+	{
+	public:
+
+		typedef Imath::V3d 				vec_type;
+		typedef Imath::Box3d 			box_type;
+		typedef Imath::Frustum<double> 	frustum_type;
+		typedef Imath::M44d 			matrix_type;
+
+		// reads the index; points are read by load()
+		explicit PointOctree(const std::string& path)
+		:	m_path(path),
+			m_points(0)
+		{
+			std::ifstream is(path.c_str(), std::ios::binary);
+			char magic[8];
+			is.read(magic, sizeof(magic));
+			if(!is || std::memcmp(magic, octree::Magic, sizeof(magic)))
+				octree::fail(path, "not a point octree.");
+
+			unsigned long long indexOffset = 0;
+			is.seekg(-std::streamoff(sizeof(indexOffset) + sizeof(magic)), std::ios::end);
+			octree::read(is, indexOffset);
+			is.read(magic, sizeof(magic));
+			if(!is || std::memcmp(magic, octree::EndMagic, sizeof(magic)))
+				octree::fail(path, "incomplete, it wasn't closed.");
+
+			unsigned version = 0;
+			unsigned long long count = 0;
+			is.seekg(std::streamoff(indexOffset));
+			octree::read(is, version);
+			if(version != octree::Version)
+				octree::fail(path, "unsupported version.");
+			octree::read(is, m_gridSize);
+			octree::read(is, m_maxDepth);
+			octree::read(is, m_bounds);
+			octree::read(is, count);
+
+			m_nodes.resize(std::size_t(count));
+			for(std::size_t i=0; i<m_nodes.size(); ++i)
+			{
+				Node& node = m_nodes[i];
+				unsigned chunks = 0;
+				octree::read(is, node.parent);
+				octree::read(is, node.octant);
+				octree::read(is, node.count);
+				octree::read(is, chunks);
+				node.chunks.resize(chunks);
+				for(unsigned j=0; j<chunks; ++j)
+				{
+					octree::read(is, node.chunks[j].offset);
+					octree::read(is, node.chunks[j].count);
+				}
+				if(!is || (node.parent >= int(i)) || ((node.parent < 0) != (i == 0)))
+					octree::fail(path, "corrupt index.");
+
+				// parents are always written before their children
+				if(node.parent < 0)
+				{
+					node.depth = 0;
+					node.box = m_bounds;
+				}
+				else
+				{
+					Node& parent = m_nodes[node.parent];
+					node.depth = parent.depth + 1;
+					node.box = octree::octant(parent.box, node.octant);
+					parent.child[node.octant & 7] = static_cast<int>(i);
+				}
+				m_points += node.count;
+			}
+		}
+
+		std::size_t size() const 							{ return m_nodes.size(); }
+		unsigned long long pointCount() const 				{ return m_points; }
+		const box_type& bounds() const 						{ return m_bounds; }
+		int gridSize() const 								{ return m_gridSize; }
+
+		const box_type& nodeBox(std::size_t i) const 		{ return m_nodes[i].box; }
+		int nodeDepth(std::size_t i) const 					{ return m_nodes[i].depth; }
+		int nodeParent(std::size_t i) const 				{ return m_nodes[i].parent; }
+		int nodeChild(std::size_t i, int octant) const 		{ return m_nodes[i].child[octant]; }
+		unsigned long long nodePointCount(std::size_t i) const 	{ return m_nodes[i].count; }
+
+		// the distance between a node's points, roughly: the size of its grid cells
+		double nodeSpacing(std::size_t i) const
+		{
+			const vec_type size = m_nodes[i].box.max - m_nodes[i].box.min;
+			return std::max(size.x, std::max(size.y, size.z)) / m_gridSize;
+		}
+
+		/*
+		 * Appends the nodes to draw for a view, coarsest first. worldToCamera takes the
+		 * points into the frustum's camera space (the inverse of the camera's transform, so
+		 * it should be rigid). Nodes outside the frustum are skipped, and a node is refined
+		 * while its spacing projects (as Frustum.worldRadius) larger than screenSize, in the
+		 * frustum's screen units - eg (right - left) / width for a pixel. Selection stops
+		 * before the selected nodes would hold more than maxPoints points.
+		 */
+		void select(const frustum_type& frustum, const matrix_type& worldToCamera,
+			double screenSize, unsigned long long maxPoints, std::vector<int>& result) const
+		{
+			if(m_nodes.empty())
+				return;
+
+			Imath::Plane3d planes[6];
+			frustum.planes(planes);
+
+			std::priority_queue<std::pair<double, int> > queue;
+			double size;
+			if(visible(0, frustum, planes, worldToCamera, size))
+				queue.push(std::make_pair(size, 0));
+
+			unsigned long long total = 0;
+			while(!queue.empty())
+			{
+				const int i = queue.top().second;
+				size = queue.top().first;
+				queue.pop();
+
+				const Node& node = m_nodes[i];
+				if(total + node.count > maxPoints)
+					break;
+				total += node.count;
+				result.push_back(i);
+
+				if(size <= screenSize)
+					continue;
+
+				for(int c=0; c<8; ++c)
+				{
+					double childSize;
+					if((node.child[c] >= 0)
+						&& visible(node.child[c], frustum, planes, worldToCamera, childSize))
+					{
+						queue.push(std::make_pair(childSize, node.child[c]));
+					}
+				}
+			}
+		}
+
+		// appends node i's points
+		void load(std::size_t i, std::vector<vec_type>& points) const
+		{
+			const Node& node = m_nodes[i];
+			std::ifstream is(m_path.c_str(), std::ios::binary);
+			std::vector<Imath::V3f> chunk;
+			points.reserve(points.size() + std::size_t(node.count));
+
+			for(std::size_t j=0; j<node.chunks.size(); ++j)
+			{
+				chunk.resize(node.chunks[j].count);
+				is.seekg(std::streamoff(node.chunks[j].offset));
+				if(!chunk.empty())
+					is.read(reinterpret_cast<char*>(&chunk[0]), chunk.size() * sizeof(Imath::V3f));
+				if(!is)
+					octree::fail(m_path, "read failed.");
+
+				for(std::size_t k=0; k<chunk.size(); ++k)
+					points.push_back(node.box.min + vec_type(chunk[k].x, chunk[k].y, chunk[k].z));
+			}
+		}
+
+	private:
+
+		struct Node
+		{
+			Node():parent(-1), octant(0), depth(0), count(0) { std::fill(child, child+8, -1); }
+
+			int parent;
+			int octant;
+			int depth;
+			box_type box;
+			int child[8];
+			unsigned long long count;
+			std::vector<octree::Chunk> chunks;
+		};
+
+		// whether node i's bounding sphere is at least partly inside the frustum, and if
+		// so the screen size of its spacing, at its nearest
+		bool visible(int i, const frustum_type& frustum, const Imath::Plane3d* planes,
+			const matrix_type& worldToCamera, double& size) const
+		{
+			const box_type& box = m_nodes[i].box;
+			const double radius = (box.max - box.min).length() * 0.5;
+			vec_type c;
+			worldToCamera.multVecMatrix((box.min + box.max) * 0.5, c);
+
+			for(int p=0; p<6; ++p)
+			{
+				if(planes[p].distanceTo(c) > radius)
+					return false;
+			}
+
+			const double z = c.z + radius;
+			if(frustum.orthographic())
+				size = nodeSpacing(i);
+			else if(z >= -frustum.near())
+				size = std::numeric_limits<double>::max();
+			else
+				size = nodeSpacing(i) / frustum.worldRadius(vec_type(0.0, 0.0, z), 1.0);
+			return true;
+		}
+
+		std::string m_path;
+		int m_gridSize;
+		int m_maxDepth;
+		box_type m_bounds;
+		unsigned long long m_points;
+		std::vector<Node> m_nodes;
+	};
+
+} }
+
+#endif
@@ -0,0 +1,173 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_PARALLEL__H_
+#define _PIMATH_KERNELS_PARALLEL__H_
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+namespace pimath { namespace kernels
+{
+	namespace detail
+	{
+		// The count set by setThreadCount, or 0 for OpenMP's default. This is kept here
+		// rather than by omp_set_num_threads, which only sets it for the calling thread, so
+		// that kernels started from any thread use it.
+		inline int& threadCountSetting()
+		{
+			static int n = 0;
+			return n;
+		}
+	}
+
+	// the number of threads parallel kernels use, 1 without OpenMP
+	inline int threadCount()
+	{
+#ifdef _OPENMP
+		const int n = detail::threadCountSetting();
+		return (n > 0)? n : omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+
+	inline void setThreadCount(int n)
+	{
+#ifdef _OPENMP
+		if(n > 0)
+			detail::threadCountSetting() = n;
+#else
+		(void)n;
+#endif
+	}
+
+
+	namespace detail
+	{
+		// The first exception thrown by a parallelFor piece. An exception can't leave an
+		// OpenMP region (it calls std::terminate), so each piece catches its own, and the
+		// first is thrown again once the region ends: bad_alloc as itself, so that python
+		// sees MemoryError, and anything else as a runtime_error with the same message.
+		class PieceError
+		{
+		public:
+			PieceError():m_kind(None){}
+
+			void setBadAlloc() 					{ set(BadAlloc, ""); }
+			void setOther(const char* what) 	{ set(Other, what); }
+
+			void rethrow() const
+			{
+				if(m_kind == BadAlloc)
+					throw std::bad_alloc();
+				if(m_kind == Other)
+					throw std::runtime_error(m_what);
+			}
+
+		private:
+			enum Kind { None, BadAlloc, Other };
+
+			void set(Kind kind, const char* what)
+			{
+#ifdef _OPENMP
+				#pragma omp critical(pimath_piece_error)
+#endif
+				{
+					if(m_kind == None)
+					{
+						m_kind = kind;
+						try { m_what = what; }
+						catch(...) { m_kind = BadAlloc; }
+					}
+				}
+			}
+
+			Kind 			m_kind;
+			std::string 	m_what;
+		};
+	}
+
+
+	// Splits [0, n) into 'pieces' contiguous ranges and calls fn(begin, end, piece) for each,
+	// in parallel. The split depends only on n and pieces, never on the number of threads,
+	// so a kernel which keeps per-piece state (see random.hpp) is deterministic. If fn
+	// throws, the other pieces still run, and the first exception is then thrown again as
+	// described for detail::PieceError.
+	template<typename Fn>
+	void parallelFor(std::size_t n, int pieces, const Fn& fn)
+	{
+		if(pieces < 1)
+			pieces = 1;
+
+		detail::PieceError error;
+
+#ifdef _OPENMP
+		const int threads = threadCount();
+		#pragma omp parallel for schedule(static) num_threads(threads) if((n > 1) && (pieces > 1))
+#endif
+		for(int p=0; p<pieces; ++p)
+		{
+			const std::size_t begin = n * p / pieces;
+			const std::size_t end = n * (p+1) / pieces;
+			if(begin < end)
+			{
+				try {
+					fn(begin, end, p);
+				}
+				catch(const std::bad_alloc&) {
+					error.setBadAlloc();
+				}
+				catch(const std::exception& e) {
+					error.setOther(e.what());
+				}
+				catch(...) {
+					error.setOther("Unknown exception in a parallel kernel.");
+				}
+			}
+		}
+
+		error.rethrow();
+	}
+
+	// as above, with one piece per thread
+	template<typename Fn>
+	void parallelFor(std::size_t n, const Fn& fn) {
+		parallelFor(n, threadCount(), fn);
+	}
+
+} }
+
+#endif
@@ -0,0 +1,354 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_PCA__H_
+#define _PIMATH_KERNELS_PCA__H_
+
+#include <ImathVec.h>
+#include <ImathMatrix.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "parallel.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	// a double sum with Neumaier's compensation, so adding millions of values loses
+	// almost nothing to rounding
+	class CompensatedSum
+	{
+	public:
+
+		CompensatedSum():m_sum(0.0), m_c(0.0){}
+
+		void add(double x)
+		{
+			const double t = m_sum + x;
+			if(std::abs(m_sum) >= std::abs(x))
+				m_c += (m_sum - t) + x;
+			else
+				m_c += (x - t) + m_sum;
+			m_sum = t;
+		}
+
+		void add(const CompensatedSum& s)
+		{
+			add(s.m_sum);
+			add(s.m_c);
+		}
+
+		double value() const { return m_sum + m_c; }
+
+	private:
+
+		double m_sum;
+		double m_c;
+	};
+
+
+	namespace detail
+	{
+		// a fixed number of partial sums, so results don't vary with the thread count
+		enum { SumPieces = 64 };
+
+		template<typename T>
+		struct MeanTask
+		{
+			MeanTask(const Imath::Vec3<T>* p, std::vector<CompensatedSum>& sums)
+			:	m_p(p), m_sums(&sums) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				CompensatedSum* s = &(*m_sums)[piece * 3];
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					s[0].add(m_p[i].x);
+					s[1].add(m_p[i].y);
+					s[2].add(m_p[i].z);
+				}
+			}
+
+			const Imath::Vec3<T>* m_p;
+			std::vector<CompensatedSum>* m_sums;
+		};
+
+		template<typename T>
+		struct CovarianceTask
+		{
+			CovarianceTask(const Imath::Vec3<T>* p, const Imath::V3d& mean,
+				std::vector<CompensatedSum>& sums)
+			:	m_p(p), m_mean(mean), m_sums(&sums) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				CompensatedSum* s = &(*m_sums)[piece * 6];
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const double x = double(m_p[i].x) - m_mean.x;
+					const double y = double(m_p[i].y) - m_mean.y;
+					const double z = double(m_p[i].z) - m_mean.z;
+					s[0].add(x*x);
+					s[1].add(x*y);
+					s[2].add(x*z);
+					s[3].add(y*y);
+					s[4].add(y*z);
+					s[5].add(z*z);
+				}
+			}
+
+			const Imath::Vec3<T>* m_p;
+			Imath::V3d m_mean;
+			std::vector<CompensatedSum>* m_sums;
+		};
+
+		// the extent of the points along three axes (the columns of 'axes')
+		template<typename T>
+		struct ExtentTask
+		{
+			ExtentTask(const Imath::Vec3<T>* p, const Imath::M33d& axes, std::vector<Imath::V3d>& lo,
+				std::vector<Imath::V3d>& hi)
+			:	m_p(p), m_axes(axes), m_lo(&lo), m_hi(&hi) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				Imath::V3d& lo = (*m_lo)[piece];
+				Imath::V3d& hi = (*m_hi)[piece];
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					for(int a=0; a<3; ++a)
+					{
+						const double d = m_p[i].x * m_axes[0][a] + m_p[i].y * m_axes[1][a]
+							+ m_p[i].z * m_axes[2][a];
+						lo[a] = std::min(lo[a], d);
+						hi[a] = std::max(hi[a], d);
+					}
+				}
+			}
+
+			const Imath::Vec3<T>* m_p;
+			Imath::M33d m_axes;
+			std::vector<Imath::V3d>* m_lo;
+			std::vector<Imath::V3d>* m_hi;
+		};
+
+		inline double combine(const std::vector<CompensatedSum>& sums, int i, int stride)
+		{
+			CompensatedSum s;
+			for(int p=0; p<SumPieces; ++p)
+				s.add(sums[p * stride + i]);
+			return s.value();
+		}
+	}
+
+
+	// the mean of n points, summed in double with compensation; (0,0,0) if n is 0
+	template<typename T>
+	Imath::V3d mean(const Imath::Vec3<T>* p, std::size_t n)
+	{
+		if(!n)
+			return Imath::V3d(0.0);
+
+		std::vector<CompensatedSum> sums(detail::SumPieces * 3);
+		parallelFor(n, detail::SumPieces, detail::MeanTask<T>(p, sums));
+		return Imath::V3d(detail::combine(sums, 0, 3), detail::combine(sums, 1, 3),
+			detail::combine(sums, 2, 3)) / double(n);
+	}
+
+	// the (population) covariance of n points about 'mean', summed as above
+	template<typename T>
+	Imath::M33d covariance(const Imath::Vec3<T>* p, std::size_t n, const Imath::V3d& mean)
+	{
+		std::vector<CompensatedSum> sums(detail::SumPieces * 6);
+		parallelFor(n, detail::SumPieces, detail::CovarianceTask<T>(p, mean, sums));
+
+		const int index[3][3] = { {0, 1, 2}, {1, 3, 4}, {2, 4, 5} };
+		Imath::M33d c;
+		for(int i=0; i<3; ++i)
+		{
+			for(int j=0; j<3; ++j)
+				c[i][j] = n? detail::combine(sums, index[i][j], 6) / double(n) : 0.0;
+		}
+		return c;
+	}
+
+
+	/*
+	 * Eigenvalues and eigenvectors of a symmetric 3x3 matrix, by cyclic Jacobi rotations,
+	 * as Imath::jacobiEigenSolve in newer versions of Imath: A is diagonalized in place,
+	 * S receives the eigenvalues and the columns of V the matching unit eigenvectors, so
+	 * that the original A = V * diag(S) * V.transposed(). tol is relative to A's size.
+	 */
+	template<typename T>
+	void jacobiEigenSolve(Imath::Matrix33<T>& A, Imath::Vec3<T>& S, Imath::Matrix33<T>& V,
+		const T tol = std::numeric_limits<T>::epsilon())
+	{
+		for(int i=0; i<3; ++i)
+		{
+			for(int j=0; j<3; ++j)
+				V[i][j] = (i == j)? T(1) : T(0);
+		}
+
+		T norm = T(0);
+		for(int i=0; i<3; ++i)
+		{
+			for(int j=0; j<3; ++j)
+				norm += A[i][j] * A[i][j];
+		}
+
+		for(int sweep=0; sweep<50; ++sweep)
+		{
+			const T off = A[0][1]*A[0][1] + A[0][2]*A[0][2] + A[1][2]*A[1][2];
+			if(off <= tol * tol * norm)
+				break;
+
+			for(int p=0; p<2; ++p)
+			{
+				for(int q=p+1; q<3; ++q)
+				{
+					if(A[p][q] == T(0))
+						continue;
+
+					// the rotation in the p,q plane which zeroes A[p][q]
+					const T theta = (A[q][q] - A[p][p]) / (T(2) * A[p][q]);
+					T t = T(1) / (std::abs(theta) + std::sqrt(theta*theta + T(1)));
+					if(theta < T(0))
+						t = -t;
+					const T c = T(1) / std::sqrt(t*t + T(1));
+					const T s = t * c;
+
+					for(int k=0; k<3; ++k)
+					{
+						const T akp = A[k][p], akq = A[k][q];
+						A[k][p] = c*akp - s*akq;
+						A[k][q] = s*akp + c*akq;
+					}
+					for(int k=0; k<3; ++k)
+					{
+						const T apk = A[p][k], aqk = A[q][k];
+						A[p][k] = c*apk - s*aqk;
+						A[q][k] = s*apk + c*aqk;
+					}
+					for(int k=0; k<3; ++k)
+					{
+						const T vkp = V[k][p], vkq = V[k][q];
+						V[k][p] = c*vkp - s*vkq;
+						V[k][q] = s*vkp + c*vkq;
+					}
+				}
+			}
+		}
+
+		S = Imath::Vec3<T>(A[0][0], A[1][1], A[2][2]);
+	}
+
+	// orders the results of jacobiEigenSolve by decreasing eigenvalue
+	template<typename T>
+	void sortEigen(Imath::Vec3<T>& S, Imath::Matrix33<T>& V)
+	{
+		for(int i=0; i<2; ++i)
+		{
+			int k = i;
+			for(int j=i+1; j<3; ++j)
+			{
+				if(S[j] > S[k])
+					k = j;
+			}
+			if(k == i)
+				continue;
+
+			std::swap(S[i], S[k]);
+			for(int r=0; r<3; ++r)
+				std::swap(V[r][i], V[r][k]);
+		}
+	}
+
+
+	/*
+	 * An oriented box around n points, fitted along the principal axes of their covariance.
+	 * Points p in the box satisfy |(p * frame.inverse())[i]| <= halfExtents[i]: frame's rows
+	 * are the box's unit axes (in order of decreasing spread, and right-handed) and its
+	 * translation is the box's center. With no points, frame is the identity and halfExtents
+	 * is (0,0,0).
+	 */
+	template<typename T>
+	void fitObb(const Imath::Vec3<T>* p, std::size_t n, Imath::Matrix44<T>& frame,
+		Imath::Vec3<T>& halfExtents)
+	{
+		for(int i=0; i<4; ++i)
+		{
+			for(int j=0; j<4; ++j)
+				frame[i][j] = (i == j)? T(1) : T(0);
+		}
+		halfExtents = Imath::Vec3<T>(T(0));
+		if(!n)
+			return;
+
+		Imath::M33d c = covariance(p, n, mean(p, n));
+		Imath::V3d s;
+		Imath::M33d axes;
+		jacobiEigenSolve(c, s, axes);
+		sortEigen(s, axes);
+
+		// the third axis from the first two, so the frame is a rotation
+		const Imath::V3d x(axes[0][0], axes[1][0], axes[2][0]);
+		const Imath::V3d y(axes[0][1], axes[1][1], axes[2][1]);
+		const Imath::V3d z = x % y;
+		for(int r=0; r<3; ++r)
+			axes[r][2] = z[r];
+
+		const double big = std::numeric_limits<double>::max();
+		const int pieces = threadCount();
+		std::vector<Imath::V3d> lo(pieces, Imath::V3d(big)), hi(pieces, Imath::V3d(-big));
+		parallelFor(n, pieces, detail::ExtentTask<T>(p, axes, lo, hi));
+		for(int i=1; i<pieces; ++i)
+		{
+			for(int a=0; a<3; ++a)
+			{
+				lo[0][a] = std::min(lo[0][a], lo[i][a]);
+				hi[0][a] = std::max(hi[0][a], hi[i][a]);
+			}
+		}
+
+		const Imath::V3d center = (lo[0] + hi[0]) * 0.5;
+		for(int a=0; a<3; ++a)
+		{
+			halfExtents[a] = T((hi[0][a] - lo[0][a]) * 0.5);
+			for(int r=0; r<3; ++r)
+			{
+				frame[a][r] = T(axes[r][a]);
+				frame[3][r] += T(center[a] * axes[r][a]);
+			}
+		}
+	}
+
+} }
+
+#endif
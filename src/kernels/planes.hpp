@@ -0,0 +1,250 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_PLANES__H_
+#define _PIMATH_KERNELS_PLANES__H_
+
+#include <ImathVec.h>
+#include <ImathPlane.h>
+#include <ImathLine.h>
+#include <vector>
+#include <cstddef>
+#include "parallel.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	// which side of a plane something lies on: PlaneFront is the side the normal points to
+	enum PlaneSide
+	{
+		PlaneBack = -1,
+		PlaneStraddle = 0, 		// crosses or touches the plane (or, for points, is within tolerance)
+		PlaneFront = 1
+	};
+
+
+	namespace detail
+	{
+		template<typename T>
+		struct PlaneDistanceTask
+		{
+			PlaneDistanceTask(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* points, T* distances)
+			:	m_plane(plane), m_points(points), m_distances(distances) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+					m_distances[i] = m_plane.distanceTo(m_points[i]);
+			}
+
+			Imath::Plane3<T> m_plane;
+			const Imath::Vec3<T>* m_points;
+			T* m_distances;
+		};
+
+		template<typename T>
+		struct PointSideTask
+		{
+			PointSideTask(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* points, T tolerance, int* sides)
+			:	m_plane(plane), m_points(points), m_tolerance(tolerance), m_sides(sides) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const T d = m_plane.distanceTo(m_points[i]);
+					m_sides[i] = (d > m_tolerance)? PlaneFront : ((d < -m_tolerance)? PlaneBack : PlaneStraddle);
+				}
+			}
+
+			Imath::Plane3<T> m_plane;
+			const Imath::Vec3<T>* m_points;
+			T m_tolerance;
+			int* m_sides;
+		};
+
+		template<typename T>
+		struct BoxSideTask
+		{
+			BoxSideTask(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* mins, const Imath::Vec3<T>* maxs,
+				int* sides)
+			:	m_plane(plane), m_mins(mins), m_maxs(maxs), m_sides(sides) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				const Imath::Vec3<T>& n = m_plane.normal;
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const Imath::Vec3<T>& lo = m_mins[i];
+					const Imath::Vec3<T>& hi = m_maxs[i];
+					if((lo.x > hi.x) || (lo.y > hi.y) || (lo.z > hi.z))
+					{
+						m_sides[i] = PlaneBack;
+						continue;
+					}
+
+					// the corners furthest along and against the normal
+					const Imath::Vec3<T> front((n.x < 0)? lo.x : hi.x, (n.y < 0)? lo.y : hi.y, (n.z < 0)? lo.z : hi.z);
+					const Imath::Vec3<T> back((n.x < 0)? hi.x : lo.x, (n.y < 0)? hi.y : lo.y, (n.z < 0)? hi.z : lo.z);
+					if(m_plane.distanceTo(back) > 0)
+						m_sides[i] = PlaneFront;
+					else if(m_plane.distanceTo(front) < 0)
+						m_sides[i] = PlaneBack;
+					else
+						m_sides[i] = PlaneStraddle;
+				}
+			}
+
+			Imath::Plane3<T> m_plane;
+			const Imath::Vec3<T>* m_mins;
+			const Imath::Vec3<T>* m_maxs;
+			int* m_sides;
+		};
+
+		template<typename T>
+		struct SphereSideTask
+		{
+			SphereSideTask(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* centers, const T* radii,
+				int* sides)
+			:	m_plane(plane), m_centers(centers), m_radii(radii), m_sides(sides) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					const T d = m_plane.distanceTo(m_centers[i]);
+					m_sides[i] = (d > m_radii[i])? PlaneFront : ((d < -m_radii[i])? PlaneBack : PlaneStraddle);
+				}
+			}
+
+			Imath::Plane3<T> m_plane;
+			const Imath::Vec3<T>* m_centers;
+			const T* m_radii;
+			int* m_sides;
+		};
+
+		template<typename T>
+		struct LinePlaneTask
+		{
+			LinePlaneTask(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* origins,
+				const Imath::Vec3<T>* dirs, T* t, Imath::Vec3<T>* p, int* hit, std::size_t* hits)
+			:	m_plane(plane), m_origins(origins), m_dirs(dirs), m_t(t), m_p(p), m_hit(hit), m_hits(hits) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				std::size_t hits = 0;
+				Imath::Line3<T> line;
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					line.pos = m_origins[i];
+					line.dir = m_dirs[i];
+
+					T ti;
+					m_hit[i] = m_plane.intersectT(line, ti);
+					if(m_hit[i])
+					{
+						m_t[i] = ti;
+						if(m_p)
+							m_p[i] = line(ti);
+						++hits;
+					}
+				}
+				m_hits[piece] = hits;
+			}
+
+			Imath::Plane3<T> m_plane;
+			const Imath::Vec3<T>* m_origins;
+			const Imath::Vec3<T>* m_dirs;
+			T* m_t;
+			Imath::Vec3<T>* m_p;
+			int* m_hit;
+			std::size_t* m_hits;
+		};
+	}
+
+
+	// the signed distance of each point to the plane, as Plane3::distanceTo
+	template<typename T>
+	void planeDistances(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* points, std::size_t n,
+		T* distances)
+	{
+		parallelFor(n, detail::PlaneDistanceTask<T>(plane, points, distances));
+	}
+
+	// the PlaneSide of each point; points within 'tolerance' of the plane are PlaneStraddle
+	template<typename T>
+	void classifyPoints(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* points, std::size_t n,
+		T tolerance, int* sides)
+	{
+		parallelFor(n, detail::PointSideTask<T>(plane, points, tolerance, sides));
+	}
+
+	/*
+	 * The PlaneSide of each box mins[i] to maxs[i], from its corners nearest and furthest
+	 * along the plane normal. A box touching the plane straddles it. An empty box (any min
+	 * greater than its max), which holds no points, is PlaneBack.
+	 */
+	template<typename T>
+	void classifyBoxes(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* mins,
+		const Imath::Vec3<T>* maxs, std::size_t n, int* sides)
+	{
+		parallelFor(n, detail::BoxSideTask<T>(plane, mins, maxs, sides));
+	}
+
+	// the PlaneSide of each sphere; a sphere touching the plane straddles it
+	template<typename T>
+	void classifySpheres(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* centers, const T* radii,
+		std::size_t n, int* sides)
+	{
+		parallelFor(n, detail::SphereSideTask<T>(plane, centers, radii, sides));
+	}
+
+	/*
+	 * Intersects n lines with the plane, as Plane3::intersectT and intersect: line i passes
+	 * through origins[i] along dirs[i], in both directions. Where line i meets the plane,
+	 * hit[i] is set to 1, t[i] to its parameter and p[i] (unless p is null) to the point;
+	 * lines parallel to the plane get hit[i] = 0 and leave t[i] and p[i] untouched. Returns
+	 * the number of hits.
+	 */
+	template<typename T>
+	std::size_t intersectLines(const Imath::Plane3<T>& plane, const Imath::Vec3<T>* origins,
+		const Imath::Vec3<T>* dirs, std::size_t n, T* t, Imath::Vec3<T>* p, int* hit)
+	{
+		std::vector<std::size_t> hits(threadCount(), 0);
+		parallelFor(n, static_cast<int>(hits.size()),
+			detail::LinePlaneTask<T>(plane, origins, dirs, t, p, hit, &hits[0]));
+
+		std::size_t total = 0;
+		for(std::size_t i=0; i<hits.size(); ++i)
+			total += hits[i];
+		return total;
+	}
+
+} }
+
+#endif
@@ -0,0 +1,86 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_POINTS__H_
+#define _PIMATH_KERNELS_POINTS__H_
+
+#include <ImathVec.h>
+#include <ImathMatrix.h>
+#include <ImathBox.h>
+#include <cstddef>
+
+
+namespace pimath { namespace kernels
+{
+	// dst[i] = src[i] * m, as Matrix44::multVecMatrix. src may equal dst.
+	template<typename T>
+	void transformPoints(const Imath::Matrix44<T>& m, const Imath::Vec3<T>* src,
+		Imath::Vec3<T>* dst, std::size_t n)
+	{
+		for(std::size_t i=0; i<n; ++i)
+		{
+			Imath::Vec3<T> v;
+			m.multVecMatrix(src[i], v);
+			dst[i] = v;
+		}
+	}
+
+	// dst[i] = src[i] * m, as Matrix44::multDirMatrix. src may equal dst.
+	template<typename T>
+	void transformDirs(const Imath::Matrix44<T>& m, const Imath::Vec3<T>* src,
+		Imath::Vec3<T>* dst, std::size_t n)
+	{
+		for(std::size_t i=0; i<n; ++i)
+		{
+			Imath::Vec3<T> v;
+			m.multDirMatrix(src[i], v);
+			dst[i] = v;
+		}
+	}
+
+	// normalizes in place, as Vec3::normalize
+	template<typename T>
+	void normalize(Imath::Vec3<T>* p, std::size_t n)
+	{
+		for(std::size_t i=0; i<n; ++i)
+			p[i].normalize();
+	}
+
+	// the box enclosing all points, empty if n is 0
+	template<typename T>
+	Imath::Box<Imath::Vec3<T> > bounds(const Imath::Vec3<T>* p, std::size_t n)
+	{
+		Imath::Box<Imath::Vec3<T> > b;
+		for(std::size_t i=0; i<n; ++i)
+			b.extendBy(p[i]);
+		return b;
+	}
+
+} }
+
+#endif
@@ -0,0 +1,176 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_RANDOM__H_
+#define _PIMATH_KERNELS_RANDOM__H_
+
+#include <ImathRandom.h>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include "parallel.hpp"
+
+#ifndef PIMATH_CACHE_LINE
+#define PIMATH_CACHE_LINE 64
+#endif
+
+
+namespace pimath { namespace kernels
+{
+	// Imath's Rand32 and Rand48 are not thread safe, so bulk sampling gives each piece of
+	// its parallelFor split (see parallel.hpp) a generator of its own: ThreadRand holds
+	// one generator per piece, each on its own cache line, with generator i seeded from
+	// (seed, i). Results so depend only on the seed and the number of generators.
+
+	// a well mixed seed for generator 'index' of 'seed' (splitmix64)
+	inline unsigned long streamSeed(unsigned long seed, std::size_t index)
+	{
+		unsigned long long z = static_cast<unsigned long long>(seed) +
+			0x9e3779b97f4a7c15ULL * (static_cast<unsigned long long>(index) + 1);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return static_cast<unsigned long>(z ^ (z >> 31));
+	}
+
+
+	template<typename Rand>
+	class ThreadRand
+	{
+	public:
+
+		typedef Rand rand_type;
+
+		ThreadRand(unsigned long seed, int count)
+		:	m_count(count > 0? count : 1),
+			m_memory((m_count + 1) * sizeof(Slot))
+		{
+			// align the first slot; each slot is a whole number of cache lines
+			std::size_t offset = reinterpret_cast<std::size_t>(&m_memory[0]) % PIMATH_CACHE_LINE;
+			m_slots = reinterpret_cast<Slot*>(&m_memory[0] + (offset? PIMATH_CACHE_LINE - offset : 0));
+
+			for(int i=0; i<m_count; ++i)
+				new (&m_slots[i]) Slot(streamSeed(seed, i));
+		}
+
+		int size() const 					{ return m_count; }
+		Rand& operator[](int i) 			{ return m_slots[i].rand; }
+
+	private:
+
+		// Rand32 and Rand48 are trivially destructible, so slots are never destroyed
+		struct Slot
+		{
+			Slot(unsigned long seed):rand(seed){}
+
+			Rand rand;
+			char pad[PIMATH_CACHE_LINE - sizeof(Rand) % PIMATH_CACHE_LINE];
+		};
+
+		// not copyable, since m_slots points into m_memory
+		ThreadRand(const ThreadRand&);
+		ThreadRand& operator=(const ThreadRand&);
+
+		int m_count;
+		std::vector<char> m_memory;
+		Slot* m_slots;
+	};
+
+
+	namespace detail
+	{
+		template<typename T, typename Rand>
+		struct SampleTask
+		{
+			typedef T (*sample_fn)(Rand&);
+
+			SampleTask(sample_fn fn, T* dst, ThreadRand<Rand>& rands)
+			:	m_fn(fn), m_dst(dst), m_rands(&rands) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				Rand& rand = (*m_rands)[piece];
+				for(std::size_t i=begin; i<end; ++i)
+					m_dst[i] = m_fn(rand);
+			}
+
+			sample_fn m_fn;
+			T* m_dst;
+			ThreadRand<Rand>* m_rands;
+		};
+
+		template<typename T, typename Rand>
+		struct UniformTask
+		{
+			UniformTask(T* dst, T min, T max, ThreadRand<Rand>& rands)
+			:	m_dst(dst), m_min(min), m_max(max), m_rands(&rands) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				Rand& rand = (*m_rands)[piece];
+				for(std::size_t i=begin; i<end; ++i)
+					m_dst[i] = static_cast<T>(rand.nextf(m_min, m_max));
+			}
+
+			T* m_dst;
+			T m_min, m_max;
+			ThreadRand<Rand>* m_rands;
+		};
+	}
+
+
+	// dst[i] = fn(generator), in parallel with one piece per generator in 'rands'
+	template<typename T, typename Rand>
+	void sample(T (*fn)(Rand&), T* dst, std::size_t n, ThreadRand<Rand>& rands) {
+		parallelFor(n, rands.size(), detail::SampleTask<T, Rand>(fn, dst, rands));
+	}
+
+	// uniform values in [min, max), as Rand::nextf(min, max)
+	template<typename T, typename Rand>
+	void uniformRand(T* dst, std::size_t n, T min, T max, ThreadRand<Rand>& rands) {
+		parallelFor(n, rands.size(), detail::UniformTask<T, Rand>(dst, min, max, rands));
+	}
+
+	// as Imath's solidSphereRand, hollowSphereRand and gaussSphereRand, per element
+	template<typename Vec, typename Rand>
+	void solidSphereRand(Vec* dst, std::size_t n, ThreadRand<Rand>& rands) {
+		sample(&Imath::solidSphereRand<Vec, Rand>, dst, n, rands);
+	}
+
+	template<typename Vec, typename Rand>
+	void hollowSphereRand(Vec* dst, std::size_t n, ThreadRand<Rand>& rands) {
+		sample(&Imath::hollowSphereRand<Vec, Rand>, dst, n, rands);
+	}
+
+	template<typename Vec, typename Rand>
+	void gaussSphereRand(Vec* dst, std::size_t n, ThreadRand<Rand>& rands) {
+		sample(&Imath::gaussSphereRand<Vec, Rand>, dst, n, rands);
+	}
+
+} }
+
+#endif
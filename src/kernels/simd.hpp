@@ -0,0 +1,821 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_SIMD__H_
+#define _PIMATH_KERNELS_SIMD__H_
+
+#include <ImathVec.h>
+#include <ImathMatrix.h>
+#include <ImathBox.h>
+#include <half.h>
+#include <cfloat>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include "points.hpp"
+#include "intersect.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PIMATH_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define PIMATH_TARGET_AVX2 		__attribute__((target("avx2,f16c")))
+#define PIMATH_TARGET_AVX512 	__attribute__((target("avx512f")))
+#else
+#define PIMATH_TARGET_AVX2
+#define PIMATH_TARGET_AVX512
+#endif
+
+
+/*
+ * Bulk kernels, compiled for several x86 instruction sets and selected on first use:
+ * the best level the cpu (and os) supports is found via cpuid, and can be lowered by
+ * setting the PIMATH_SIMD environment variable to 'scalar', 'sse2', 'avx2' or 'avx512'
+ * (pimath selects at import). pimath.simdLevel() returns the level in use.
+ *
+ * Every level gives bitwise identical results to the scalar (Imath) code, except that
+ * signalling NaNs may be quietened by the half conversions, and bounds may pick either
+ * sign for a zero extent.
+ *
+ * The float overloads of transformPoints, normalize, bounds and intersectSpheres at the end
+ * of this file dispatch to these kernels, so including it is enough to speed up callers of
+ * points.hpp and intersect.hpp.
+ */
+
+namespace pimath { namespace kernels
+{
+	enum SimdLevel
+	{
+		SimdScalar,
+		SimdSSE2,
+		SimdAVX2, 		// also requires F16C
+		SimdAVX512		// AVX-512F
+	};
+
+
+	struct SimdKernels
+	{
+		// dst[i] = src[i] * m, as M44f::multVecMatrix, for n V3f points. src may equal dst.
+		void (*transformPoints)(const float* m, const float* src, float* dst, std::size_t n);
+
+		// the min and max corners of n V3f points, or an empty Box3f's corners if n is 0
+		void (*bounds)(const float* p, std::size_t n, float* min, float* max);
+
+		// normalizes n V3f vectors in place, as V3f::normalize
+		void (*normalize)(float* p, std::size_t n);
+
+		// dst[i] = float(src[i]) * scale, and dst[i] = half(src[i] * scale)
+		void (*halfToFloat)(const half* src, float* dst, std::size_t n, float scale);
+		void (*floatToHalf)(const float* src, half* dst, std::size_t n, float scale);
+
+		// intersectSpheres (intersect.hpp) over V3f rays and spheres, with steps of 0 or 1
+		std::size_t (*intersectSpheres)(const float* origins, const float* dirs, std::size_t rayStep,
+			const float* centers, const float* radii, std::size_t sphereStep, std::size_t n,
+			float* t, float* p, int* hit);
+	};
+
+
+	inline const char* simdLevelName(SimdLevel level)
+	{
+		switch(level)
+		{
+		case SimdSSE2: 		return "sse2";
+		case SimdAVX2: 		return "avx2";
+		case SimdAVX512: 	return "avx512";
+		default: 			return "scalar";
+		}
+	}
+
+
+// the vector code below must round exactly as the scalar code does
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+	namespace detail
+	{
+		// scalar reference kernels, which the others must match
+		inline void scalarTransformPoints(const float* m, const float* src, float* dst, std::size_t n)
+		{
+			transformPoints(*reinterpret_cast<const Imath::M44f*>(m),
+				reinterpret_cast<const Imath::V3f*>(src), reinterpret_cast<Imath::V3f*>(dst), n);
+		}
+
+		inline void scalarBounds(const float* p, std::size_t n, float* min, float* max)
+		{
+			Imath::Box3f b = bounds(reinterpret_cast<const Imath::V3f*>(p), n);
+			for(int j=0; j<3; ++j)
+			{
+				min[j] = b.min[j];
+				max[j] = b.max[j];
+			}
+		}
+
+		inline void scalarNormalize(float* p, std::size_t n) {
+			normalize(reinterpret_cast<Imath::V3f*>(p), n);
+		}
+
+		inline void scalarHalfToFloat(const half* src, float* dst, std::size_t n, float scale)
+		{
+			for(std::size_t i=0; i<n; ++i)
+				dst[i] = static_cast<float>(src[i]) * scale;
+		}
+
+		inline void scalarFloatToHalf(const float* src, half* dst, std::size_t n, float scale)
+		{
+			for(std::size_t i=0; i<n; ++i)
+				dst[i] = half(src[i] * scale);
+		}
+
+		inline std::size_t scalarIntersectSpheres(const float* origins, const float* dirs,
+			std::size_t rayStep, const float* centers, const float* radii, std::size_t sphereStep,
+			std::size_t n, float* t, float* p, int* hit)
+		{
+			return intersectSpheres(reinterpret_cast<const Imath::V3f*>(origins),
+				reinterpret_cast<const Imath::V3f*>(dirs), rayStep,
+				reinterpret_cast<const Imath::V3f*>(centers), radii, sphereStep, n,
+				t, reinterpret_cast<Imath::V3f*>(p), hit);
+		}
+
+		inline const SimdKernels& scalarKernels()
+		{
+			static const SimdKernels k = {
+				scalarTransformPoints, scalarBounds, scalarNormalize,
+				scalarHalfToFloat, scalarFloatToHalf, scalarIntersectSpheres
+			};
+			return k;
+		}
+
+
+#ifdef PIMATH_SIMD_X86
+
+		// SSE2. V3f arrays are processed 4 points (3 registers) at a time, transposed to x, y and z.
+		inline void load4(const float* p, __m128& x, __m128& y, __m128& z)
+		{
+			// xyzx yzxy zxyz
+			__m128 v0 = _mm_loadu_ps(p), v1 = _mm_loadu_ps(p+4), v2 = _mm_loadu_ps(p+8);
+			x = _mm_shuffle_ps(v0, _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0,1,0,2)), _MM_SHUFFLE(2,0,3,0));
+			y = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0,0,0,1)),
+				_mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0,2,0,3)), _MM_SHUFFLE(2,0,2,0));
+			z = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0,1,0,2)),
+				_mm_shuffle_ps(v2, v2, _MM_SHUFFLE(0,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+		}
+
+		inline void store4(float* p, __m128 x, __m128 y, __m128 z)
+		{
+			__m128 xyLo = _mm_unpacklo_ps(x, y); 	// x0 y0 x1 y1
+			__m128 xyHi = _mm_unpackhi_ps(x, y); 	// x2 y2 x3 y3
+			_mm_storeu_ps(p, _mm_shuffle_ps(xyLo,
+				_mm_shuffle_ps(z, xyLo, _MM_SHUFFLE(0,2,0,0)), _MM_SHUFFLE(2,0,1,0)));
+			_mm_storeu_ps(p+4, _mm_shuffle_ps(
+				_mm_shuffle_ps(xyLo, z, _MM_SHUFFLE(0,1,0,3)), xyHi, _MM_SHUFFLE(1,0,2,0)));
+			_mm_storeu_ps(p+8, _mm_shuffle_ps(
+				_mm_shuffle_ps(z, xyHi, _MM_SHUFFLE(0,2,0,2)),
+				_mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(0,3,0,3)), _MM_SHUFFLE(2,0,2,0)));
+		}
+
+		inline void sse2TransformPoints(const float* m, const float* src, float* dst, std::size_t n)
+		{
+			__m128 c[16];
+			for(int i=0; i<16; ++i)
+				c[i] = _mm_set1_ps(m[i]);
+
+			std::size_t i = 0;
+			for(; i+4<=n; i+=4)
+			{
+				__m128 x, y, z;
+				load4(src+i*3, x, y, z);
+
+				// in the same order as M44f::multVecMatrix
+				__m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[0]), _mm_mul_ps(y, c[4])), _mm_mul_ps(z, c[8])), c[12]);
+				__m128 b = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[1]), _mm_mul_ps(y, c[5])), _mm_mul_ps(z, c[9])), c[13]);
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[2]), _mm_mul_ps(y, c[6])), _mm_mul_ps(z, c[10])), c[14]);
+				__m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[3]), _mm_mul_ps(y, c[7])), _mm_mul_ps(z, c[11])), c[15]);
+
+				store4(dst+i*3, _mm_div_ps(a, w), _mm_div_ps(b, w), _mm_div_ps(d, w));
+			}
+			scalarTransformPoints(m, src+i*3, dst+i*3, n-i);
+		}
+
+		inline void sse2Bounds(const float* p, std::size_t n, float* min, float* max)
+		{
+			scalarBounds(p, 0, min, max);
+
+			std::size_t i = 0;
+			if(n >= 4)
+			{
+				__m128 lo[3] = { _mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX) };
+				__m128 hi[3] = { _mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX) };
+
+				for(; i+4<=n; i+=4)
+				{
+					__m128 v[3];
+					load4(p+i*3, v[0], v[1], v[2]);
+
+					// min/maxps return their second operand for NaNs, which are so ignored
+					for(int j=0; j<3; ++j)
+					{
+						lo[j] = _mm_min_ps(v[j], lo[j]);
+						hi[j] = _mm_max_ps(v[j], hi[j]);
+					}
+				}
+
+				float l[4], h[4];
+				for(int j=0; j<3; ++j)
+				{
+					_mm_storeu_ps(l, lo[j]);
+					_mm_storeu_ps(h, hi[j]);
+					for(int k=0; k<4; ++k)
+					{
+						if(l[k] < min[j]) min[j] = l[k];
+						if(h[k] > max[j]) max[j] = h[k];
+					}
+				}
+			}
+
+			float tmin[3], tmax[3];
+			scalarBounds(p+i*3, n-i, tmin, tmax);
+			for(int j=0; j<3; ++j)
+			{
+				if(tmin[j] < min[j]) min[j] = tmin[j];
+				if(tmax[j] > max[j]) max[j] = tmax[j];
+			}
+		}
+
+		inline void sse2Normalize(float* p, std::size_t n)
+		{
+			// vectors shorter than this take Imath's lengthTiny path
+			const __m128 tiny = _mm_set1_ps(2.0f * FLT_MIN);
+
+			std::size_t i = 0;
+			for(; i+4<=n; i+=4)
+			{
+				__m128 x, y, z;
+				load4(p+i*3, x, y, z);
+
+				__m128 l2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+				if(_mm_movemask_ps(_mm_cmpge_ps(l2, tiny)) != 0xf)
+				{
+					scalarNormalize(p+i*3, 4);
+					continue;
+				}
+
+				__m128 l = _mm_sqrt_ps(l2);
+				store4(p+i*3, _mm_div_ps(x, l), _mm_div_ps(y, l), _mm_div_ps(z, l));
+			}
+			scalarNormalize(p+i*3, n-i);
+		}
+		// the number of set bits in a movemask
+		inline std::size_t maskCount(int m)
+		{
+			std::size_t c = 0;
+			for(; m; m &= m-1)
+				++c;
+			return c;
+		}
+
+		// Sphere3f::intersectT on 4 rays and spheres, in the same order: returns the mask of
+		// hits, and sets t. Lanes which miss may hold any t.
+		inline __m128 sse2RaySphere(const __m128* o, const __m128* d, const __m128* c, __m128 r, __m128& t)
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 v[3] = { _mm_sub_ps(o[0], c[0]), _mm_sub_ps(o[1], c[1]), _mm_sub_ps(o[2], c[2]) };
+
+			__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], v[0]), _mm_mul_ps(d[1], v[1])), _mm_mul_ps(d[2], v[2]));
+			b = _mm_mul_ps(_mm_set1_ps(2.0f), b);
+			__m128 cc = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v[0], v[0]), _mm_mul_ps(v[1], v[1])), _mm_mul_ps(v[2], v[2]));
+			cc = _mm_sub_ps(cc, _mm_mul_ps(r, r));
+			__m128 discr = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(4.0f), cc));
+
+			// the sqrt of a negative discriminant is a NaN, in lanes which miss anyway
+			__m128 root = _mm_sqrt_ps(discr);
+			__m128 negB = _mm_xor_ps(b, _mm_set1_ps(-0.0f));
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(negB, root), _mm_set1_ps(0.5f));
+			__m128 t1 = _mm_mul_ps(_mm_add_ps(negB, root), _mm_set1_ps(0.5f));
+			__m128 second = _mm_cmplt_ps(t0, zero);
+			t = _mm_or_ps(_mm_and_ps(second, t1), _mm_andnot_ps(second, t0));
+
+			// not less than, rather than greater or equal, so that NaNs hit as they do in Imath
+			return _mm_and_ps(_mm_cmpnlt_ps(discr, zero), _mm_cmpnlt_ps(t, zero));
+		}
+
+		inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		inline void splat4(const float* p, __m128* v)
+		{
+			for(int j=0; j<3; ++j)
+				v[j] = _mm_set1_ps(p[j]);
+		}
+
+		inline std::size_t sse2IntersectSpheres(const float* origins, const float* dirs,
+			std::size_t rayStep, const float* centers, const float* radii, std::size_t sphereStep,
+			std::size_t n, float* t, float* p, int* hit)
+		{
+			__m128 o[3], d[3], c[3], r = _mm_setzero_ps();
+			if(n && !rayStep)
+			{
+				splat4(origins, o);
+				splat4(dirs, d);
+			}
+			if(n && !sphereStep)
+			{
+				splat4(centers, c);
+				r = _mm_set1_ps(radii[0]);
+			}
+
+			std::size_t hits = 0;
+			std::size_t i = 0;
+			for(; i+4<=n; i+=4)
+			{
+				if(rayStep)
+				{
+					load4(origins+i*3, o[0], o[1], o[2]);
+					load4(dirs+i*3, d[0], d[1], d[2]);
+				}
+				if(sphereStep)
+				{
+					load4(centers+i*3, c[0], c[1], c[2]);
+					r = _mm_loadu_ps(radii+i);
+				}
+
+				__m128 ti;
+				const __m128 mask = sse2RaySphere(o, d, c, r, ti);
+				const int m = _mm_movemask_ps(mask);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(hit+i), _mm_srli_epi32(_mm_castps_si128(mask), 31));
+				if(!m)
+					continue;
+
+				hits += maskCount(m);
+				_mm_storeu_ps(t+i, select4(mask, ti, _mm_loadu_ps(t+i)));
+				if(p)
+				{
+					// as Line3f::operator(), pos + dir * t
+					__m128 q[3];
+					load4(p+i*3, q[0], q[1], q[2]);
+					for(int j=0; j<3; ++j)
+						q[j] = select4(mask, _mm_add_ps(o[j], _mm_mul_ps(d[j], ti)), q[j]);
+					store4(p+i*3, q[0], q[1], q[2]);
+				}
+			}
+			return hits + scalarIntersectSpheres(origins+i*3*rayStep, dirs+i*3*rayStep, rayStep,
+				centers+i*3*sphereStep, radii+i*sphereStep, sphereStep, n-i, t+i, p? p+i*3 : 0, hit+i);
+		}
+
+		inline const SimdKernels& sse2Kernels()
+		{
+			static const SimdKernels k = {
+				sse2TransformPoints, sse2Bounds, sse2Normalize,
+				scalarHalfToFloat, scalarFloatToHalf, sse2IntersectSpheres
+			};
+			return k;
+		}
+
+
+		// AVX2, 8 points at a time
+		PIMATH_TARGET_AVX2 inline void load8(const float* p, __m256& x, __m256& y, __m256& z)
+		{
+			__m128 x0, y0, z0, x1, y1, z1;
+			load4(p, x0, y0, z0);
+			load4(p+12, x1, y1, z1);
+			x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+			y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+			z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+		}
+
+		PIMATH_TARGET_AVX2 inline void store8(float* p, __m256 x, __m256 y, __m256 z)
+		{
+			store4(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+			store4(p+12, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+		}
+
+		PIMATH_TARGET_AVX2 inline void avx2TransformPoints(const float* m, const float* src, float* dst, std::size_t n)
+		{
+			__m256 c[16];
+			for(int i=0; i<16; ++i)
+				c[i] = _mm256_set1_ps(m[i]);
+
+			std::size_t i = 0;
+			for(; i+8<=n; i+=8)
+			{
+				__m256 x, y, z;
+				load8(src+i*3, x, y, z);
+
+				__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, c[0]), _mm256_mul_ps(y, c[4])), _mm256_mul_ps(z, c[8])), c[12]);
+				__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, c[1]), _mm256_mul_ps(y, c[5])), _mm256_mul_ps(z, c[9])), c[13]);
+				__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, c[2]), _mm256_mul_ps(y, c[6])), _mm256_mul_ps(z, c[10])), c[14]);
+				__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, c[3]), _mm256_mul_ps(y, c[7])), _mm256_mul_ps(z, c[11])), c[15]);
+
+				store8(dst+i*3, _mm256_div_ps(a, w), _mm256_div_ps(b, w), _mm256_div_ps(d, w));
+			}
+			sse2TransformPoints(m, src+i*3, dst+i*3, n-i);
+		}
+
+		PIMATH_TARGET_AVX2 inline void avx2Normalize(float* p, std::size_t n)
+		{
+			const __m256 tiny = _mm256_set1_ps(2.0f * FLT_MIN);
+
+			std::size_t i = 0;
+			for(; i+8<=n; i+=8)
+			{
+				__m256 x, y, z;
+				load8(p+i*3, x, y, z);
+
+				__m256 l2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+				if(_mm256_movemask_ps(_mm256_cmp_ps(l2, tiny, _CMP_GE_OQ)) != 0xff)
+				{
+					scalarNormalize(p+i*3, 8);
+					continue;
+				}
+
+				__m256 l = _mm256_sqrt_ps(l2);
+				store8(p+i*3, _mm256_div_ps(x, l), _mm256_div_ps(y, l), _mm256_div_ps(z, l));
+			}
+			sse2Normalize(p+i*3, n-i);
+		}
+
+		PIMATH_TARGET_AVX2 inline void avx2HalfToFloat(const half* src, float* dst, std::size_t n, float scale)
+		{
+			const __m256 s = _mm256_set1_ps(scale);
+
+			std::size_t i = 0;
+			for(; i+8<=n; i+=8)
+			{
+				__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+				_mm256_storeu_ps(dst+i, _mm256_mul_ps(_mm256_cvtph_ps(h), s));
+			}
+			scalarHalfToFloat(src+i, dst+i, n-i, scale);
+		}
+
+		PIMATH_TARGET_AVX2 inline void avx2FloatToHalf(const float* src, half* dst, std::size_t n, float scale)
+		{
+			const __m256 s = _mm256_set1_ps(scale);
+
+			std::size_t i = 0;
+			for(; i+8<=n; i+=8)
+			{
+				__m256 f = _mm256_mul_ps(_mm256_loadu_ps(src+i), s);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),
+					_mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+			}
+			scalarFloatToHalf(src+i, dst+i, n-i, scale);
+		}
+		PIMATH_TARGET_AVX2 inline __m256 avx2RaySphere(const __m256* o, const __m256* d, const __m256* c,
+			__m256 r, __m256& t)
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 v[3] = { _mm256_sub_ps(o[0], c[0]), _mm256_sub_ps(o[1], c[1]), _mm256_sub_ps(o[2], c[2]) };
+
+			__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d[0], v[0]), _mm256_mul_ps(d[1], v[1])), _mm256_mul_ps(d[2], v[2]));
+			b = _mm256_mul_ps(_mm256_set1_ps(2.0f), b);
+			__m256 cc = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v[0], v[0]), _mm256_mul_ps(v[1], v[1])), _mm256_mul_ps(v[2], v[2]));
+			cc = _mm256_sub_ps(cc, _mm256_mul_ps(r, r));
+			__m256 discr = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_set1_ps(4.0f), cc));
+
+			__m256 root = _mm256_sqrt_ps(discr);
+			__m256 negB = _mm256_xor_ps(b, _mm256_set1_ps(-0.0f));
+			__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(negB, root), _mm256_set1_ps(0.5f));
+			__m256 t1 = _mm256_mul_ps(_mm256_add_ps(negB, root), _mm256_set1_ps(0.5f));
+			t = _mm256_blendv_ps(t0, t1, _mm256_cmp_ps(t0, zero, _CMP_LT_OQ));
+
+			return _mm256_and_ps(_mm256_cmp_ps(discr, zero, _CMP_NLT_UQ), _mm256_cmp_ps(t, zero, _CMP_NLT_UQ));
+		}
+
+		PIMATH_TARGET_AVX2 inline std::size_t avx2IntersectSpheres(const float* origins, const float* dirs,
+			std::size_t rayStep, const float* centers, const float* radii, std::size_t sphereStep,
+			std::size_t n, float* t, float* p, int* hit)
+		{
+			__m256 o[3], d[3], c[3], r = _mm256_setzero_ps();
+			for(int j=0; n && (j<3); ++j)
+			{
+				if(!rayStep)
+				{
+					o[j] = _mm256_set1_ps(origins[j]);
+					d[j] = _mm256_set1_ps(dirs[j]);
+				}
+				if(!sphereStep)
+				{
+					c[j] = _mm256_set1_ps(centers[j]);
+					r = _mm256_set1_ps(radii[0]);
+				}
+			}
+
+			std::size_t hits = 0;
+			std::size_t i = 0;
+			for(; i+8<=n; i+=8)
+			{
+				if(rayStep)
+				{
+					load8(origins+i*3, o[0], o[1], o[2]);
+					load8(dirs+i*3, d[0], d[1], d[2]);
+				}
+				if(sphereStep)
+				{
+					load8(centers+i*3, c[0], c[1], c[2]);
+					r = _mm256_loadu_ps(radii+i);
+				}
+
+				__m256 ti;
+				const __m256 mask = avx2RaySphere(o, d, c, r, ti);
+				const int m = _mm256_movemask_ps(mask);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(hit+i), _mm256_srli_epi32(_mm256_castps_si256(mask), 31));
+				if(!m)
+					continue;
+
+				hits += maskCount(m);
+				_mm256_storeu_ps(t+i, _mm256_blendv_ps(_mm256_loadu_ps(t+i), ti, mask));
+				if(p)
+				{
+					__m256 q[3];
+					load8(p+i*3, q[0], q[1], q[2]);
+					for(int j=0; j<3; ++j)
+						q[j] = _mm256_blendv_ps(q[j], _mm256_add_ps(o[j], _mm256_mul_ps(d[j], ti)), mask);
+					store8(p+i*3, q[0], q[1], q[2]);
+				}
+			}
+			return hits + sse2IntersectSpheres(origins+i*3*rayStep, dirs+i*3*rayStep, rayStep,
+				centers+i*3*sphereStep, radii+i*sphereStep, sphereStep, n-i, t+i, p? p+i*3 : 0, hit+i);
+		}
+
+		// bounds are memory bound, so the sse2 version is used
+		inline const SimdKernels& avx2Kernels()
+		{
+			static const SimdKernels k = {
+				avx2TransformPoints, sse2Bounds, avx2Normalize,
+				avx2HalfToFloat, avx2FloatToHalf, avx2IntersectSpheres
+			};
+			return k;
+		}
+
+
+		// AVX-512, 16 points at a time, via gather/scatter
+		PIMATH_TARGET_AVX512 inline __m512i xyzIndex()
+		{
+			return _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45);
+		}
+
+		PIMATH_TARGET_AVX512 inline void avx512TransformPoints(const float* m, const float* src, float* dst, std::size_t n)
+		{
+			const __m512i index = xyzIndex();
+			__m512 c[16];
+			for(int i=0; i<16; ++i)
+				c[i] = _mm512_set1_ps(m[i]);
+
+			std::size_t i = 0;
+			for(; i+16<=n; i+=16)
+			{
+				const float* s = src+i*3;
+				__m512 x = _mm512_i32gather_ps(index, s, 4);
+				__m512 y = _mm512_i32gather_ps(index, s+1, 4);
+				__m512 z = _mm512_i32gather_ps(index, s+2, 4);
+
+				__m512 a = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, c[0]), _mm512_mul_ps(y, c[4])), _mm512_mul_ps(z, c[8])), c[12]);
+				__m512 b = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, c[1]), _mm512_mul_ps(y, c[5])), _mm512_mul_ps(z, c[9])), c[13]);
+				__m512 d = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, c[2]), _mm512_mul_ps(y, c[6])), _mm512_mul_ps(z, c[10])), c[14]);
+				__m512 w = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, c[3]), _mm512_mul_ps(y, c[7])), _mm512_mul_ps(z, c[11])), c[15]);
+
+				float* t = dst+i*3;
+				_mm512_i32scatter_ps(t, index, _mm512_div_ps(a, w), 4);
+				_mm512_i32scatter_ps(t+1, index, _mm512_div_ps(b, w), 4);
+				_mm512_i32scatter_ps(t+2, index, _mm512_div_ps(d, w), 4);
+			}
+			avx2TransformPoints(m, src+i*3, dst+i*3, n-i);
+		}
+
+		PIMATH_TARGET_AVX512 inline void avx512Normalize(float* p, std::size_t n)
+		{
+			const __m512i index = xyzIndex();
+			const __m512 tiny = _mm512_set1_ps(2.0f * FLT_MIN);
+
+			std::size_t i = 0;
+			for(; i+16<=n; i+=16)
+			{
+				float* s = p+i*3;
+				__m512 x = _mm512_i32gather_ps(index, s, 4);
+				__m512 y = _mm512_i32gather_ps(index, s+1, 4);
+				__m512 z = _mm512_i32gather_ps(index, s+2, 4);
+
+				__m512 l2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y)), _mm512_mul_ps(z, z));
+				if(_mm512_cmp_ps_mask(l2, tiny, _CMP_GE_OQ) != 0xffff)
+				{
+					scalarNormalize(s, 16);
+					continue;
+				}
+
+				__m512 l = _mm512_sqrt_ps(l2);
+				_mm512_i32scatter_ps(s, index, _mm512_div_ps(x, l), 4);
+				_mm512_i32scatter_ps(s+1, index, _mm512_div_ps(y, l), 4);
+				_mm512_i32scatter_ps(s+2, index, _mm512_div_ps(z, l), 4);
+			}
+			avx2Normalize(p+i*3, n-i);
+		}
+
+		PIMATH_TARGET_AVX512 inline void avx512HalfToFloat(const half* src, float* dst, std::size_t n, float scale)
+		{
+			const __m512 s = _mm512_set1_ps(scale);
+
+			std::size_t i = 0;
+			for(; i+16<=n; i+=16)
+			{
+				__m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+i));
+				_mm512_storeu_ps(dst+i, _mm512_mul_ps(_mm512_cvtph_ps(h), s));
+			}
+			avx2HalfToFloat(src+i, dst+i, n-i, scale);
+		}
+
+		PIMATH_TARGET_AVX512 inline void avx512FloatToHalf(const float* src, half* dst, std::size_t n, float scale)
+		{
+			const __m512 s = _mm512_set1_ps(scale);
+
+			std::size_t i = 0;
+			for(; i+16<=n; i+=16)
+			{
+				__m512 f = _mm512_mul_ps(_mm512_loadu_ps(src+i), s);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i),
+					_mm512_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+			}
+			avx2FloatToHalf(src+i, dst+i, n-i, scale);
+		}
+
+		// sphere intersection gains little from gather/scatter, so the avx2 version is used
+		inline const SimdKernels& avx512Kernels()
+		{
+			static const SimdKernels k = {
+				avx512TransformPoints, sse2Bounds, avx512Normalize,
+				avx512HalfToFloat, avx512FloatToHalf, avx2IntersectSpheres
+			};
+			return k;
+		}
+
+
+		inline void cpuid(int leaf, unsigned int* r)
+		{
+#if defined(_MSC_VER)
+			int regs[4];
+			__cpuidex(regs, leaf, 0);
+			for(int i=0; i<4; ++i)
+				r[i] = regs[i];
+#else
+			__cpuid_count(leaf, 0, r[0], r[1], r[2], r[3]);
+#endif
+		}
+
+		inline unsigned long long xgetbv()
+		{
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			unsigned int lo, hi;
+			__asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+		}
+
+#endif	// PIMATH_SIMD_X86
+
+
+		// the best level supported by both the cpu and the os
+		inline SimdLevel detectSimdLevel()
+		{
+#ifdef PIMATH_SIMD_X86
+			unsigned int r[4];	// eax, ebx, ecx, edx
+			cpuid(0, r);
+			const unsigned int maxLeaf = r[0];
+
+			cpuid(1, r);
+			if(!(r[3] & (1u << 26)))
+				return SimdScalar;
+
+			// avx state must be saved by the os (osxsave, then xcr0)
+			const bool osxsave = (r[2] & (1u << 27)) != 0;
+			const bool avx = (r[2] & (1u << 28)) != 0;
+			const bool f16c = (r[2] & (1u << 29)) != 0;
+			if(!osxsave || !avx || !f16c || maxLeaf < 7)
+				return SimdSSE2;
+
+			const unsigned long long xcr0 = xgetbv();
+			if((xcr0 & 0x6) != 0x6)
+				return SimdSSE2;
+
+			cpuid(7, r);
+			if(!(r[1] & (1u << 5)))
+				return SimdSSE2;
+
+			// avx512f, plus opmask and zmm state
+			if((r[1] & (1u << 16)) && ((xcr0 & 0xe6) == 0xe6))
+				return SimdAVX512;
+			return SimdAVX2;
+#else
+			return SimdScalar;
+#endif
+		}
+
+		// the detected level, lowered by PIMATH_SIMD if set
+		inline SimdLevel selectSimdLevel()
+		{
+			SimdLevel level = detectSimdLevel();
+			const char* env = std::getenv("PIMATH_SIMD");
+			for(int i=SimdScalar; env && (i<level); ++i)
+			{
+				if(!std::strcmp(env, simdLevelName(SimdLevel(i))))
+					level = SimdLevel(i);
+			}
+			return level;
+		}
+	}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+
+	// the level in use, chosen on first call
+	inline SimdLevel simdLevel()
+	{
+		static const SimdLevel level = detail::selectSimdLevel();
+		return level;
+	}
+
+	// the kernels for the level in use
+	inline const SimdKernels& simdKernels()
+	{
+		switch(simdLevel())
+		{
+#ifdef PIMATH_SIMD_X86
+		case SimdSSE2: 		return detail::sse2Kernels();
+		case SimdAVX2: 		return detail::avx2Kernels();
+		case SimdAVX512: 	return detail::avx512Kernels();
+#endif
+		default: 			return detail::scalarKernels();
+		}
+	}
+
+
+	// float overloads of the points.hpp kernels
+	inline void transformPoints(const Imath::M44f& m, const Imath::V3f* src, Imath::V3f* dst, std::size_t n) {
+		simdKernels().transformPoints(m[0], &src->x, &dst->x, n);
+	}
+
+	inline void normalize(Imath::V3f* p, std::size_t n) {
+		simdKernels().normalize(&p->x, n);
+	}
+
+	inline Imath::Box3f bounds(const Imath::V3f* p, std::size_t n)
+	{
+		Imath::Box3f b;
+		simdKernels().bounds(&p->x, n, &b.min.x, &b.max.x);
+		return b;
+	}
+
+	inline void halfToFloat(const half* src, float* dst, std::size_t n, float scale) {
+		simdKernels().halfToFloat(src, dst, n, scale);
+	}
+
+	inline void floatToHalf(const float* src, half* dst, std::size_t n, float scale) {
+		simdKernels().floatToHalf(src, dst, n, scale);
+	}
+
+	inline std::size_t intersectSpheres(const Imath::V3f* origins, const Imath::V3f* dirs,
+		std::size_t rayStep, const Imath::V3f* centers, const float* radii, std::size_t sphereStep,
+		std::size_t n, float* t, Imath::V3f* p, int* hit)
+	{
+		return simdKernels().intersectSpheres(&origins->x, &dirs->x, rayStep, &centers->x, radii,
+			sphereStep, n, t, p? &p->x : 0, hit);
+	}
+} }
+
+#endif
@@ -0,0 +1,352 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_SPHERES__H_
+#define _PIMATH_KERNELS_SPHERES__H_
+
+#include <ImathVec.h>
+#include <ImathSphere.h>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include "parallel.hpp"
+#include "simd.hpp"
+
+
+namespace pimath { namespace kernels
+{
+	enum SphereFit
+	{
+		ExactFit, 		// the smallest enclosing sphere (Welzl)
+		RitterFit 		// Ritter's approximation: linear, but typically 5-20% larger
+	};
+
+
+	namespace detail
+	{
+		// spheres through (or, where points are degenerate, around) 1-4 points, in double
+		struct Ball
+		{
+			Imath::V3d c;
+			double r2;
+
+			Ball():c(0.0), r2(-1.0){}
+			Ball(const Imath::V3d& c_, double r2_):c(c_), r2(r2_){}
+
+			// with some slack for rounding, so boundary points test as inside
+			bool contains(const Imath::V3d& p) const {
+				return (p - c).length2() <= r2 * (1.0 + 1e-12) + 1e-300;
+			}
+		};
+
+		inline Ball ball(const Imath::V3d& a) {
+			return Ball(a, 0.0);
+		}
+
+		inline Ball ball(const Imath::V3d& a, const Imath::V3d& b)
+		{
+			const Imath::V3d c = (a + b) * 0.5;
+			return Ball(c, (a - c).length2());
+		}
+
+		inline Ball ball(const Imath::V3d& a, const Imath::V3d& b, const Imath::V3d& c)
+		{
+			const Imath::V3d ab = b - a, ac = c - a;
+			const Imath::V3d n = ab % ac;
+			const double n2 = n.length2();
+			if(n2 <= 1e-24 * ab.length2() * ac.length2())
+			{
+				// collinear: the sphere on the two furthest apart
+				const double dab = ab.length2(), dac = ac.length2(), dbc = (c - b).length2();
+				if((dab >= dac) && (dab >= dbc))
+					return ball(a, b);
+				return (dac >= dbc)? ball(a, c) : ball(b, c);
+			}
+
+			const Imath::V3d o = ((n % ab) * ac.length2() + (ac % n) * ab.length2()) / (2.0 * n2);
+			return Ball(a + o, o.length2());
+		}
+
+		inline Ball ball(const Imath::V3d& a, const Imath::V3d& b, const Imath::V3d& c,
+			const Imath::V3d& d)
+		{
+			const Imath::V3d u = b - a, v = c - a, w = d - a;
+			const double det = u ^ (v % w);
+			const double scale = u.length() * v.length() * w.length();
+			if(std::abs(det) > 1e-12 * scale)
+			{
+				const Imath::V3d o = ((v % w) * u.length2() + (w % u) * v.length2()
+					+ (u % v) * w.length2()) / (2.0 * det);
+				return Ball(a + o, o.length2());
+			}
+
+			// coplanar: the smallest sphere through three of them which holds the fourth,
+			// or failing that (through rounding) the largest
+			const Imath::V3d p[4] = { a, b, c, d };
+			Ball best, largest;
+			for(int skip=0; skip<4; ++skip)
+			{
+				const Imath::V3d& x = p[skip? 0 : 1];
+				const Imath::V3d& y = p[(skip < 2)? 2 : 1];
+				const Imath::V3d& z = p[(skip < 3)? 3 : 2];
+				const Ball s = ball(x, y, z);
+				if(s.contains(p[skip]) && ((best.r2 < 0.0) || (s.r2 < best.r2)))
+					best = s;
+				if(s.r2 > largest.r2)
+					largest = s;
+			}
+			return (best.r2 < 0.0)? largest : best;
+		}
+
+		template<typename T>
+		inline Imath::V3d toDouble(const Imath::Vec3<T>& p) {
+			return Imath::V3d(p.x, p.y, p.z);
+		}
+
+		// Welzl's algorithm, iteratively: each loop fixes one more point on the boundary.
+		// Expected linear time, given the points in random order.
+		inline Ball welzl(const std::vector<Imath::V3d>& p)
+		{
+			const std::size_t n = p.size();
+			if(!n)
+				return Ball();
+
+			Ball s = ball(p[0]);
+			for(std::size_t i=1; i<n; ++i)
+			{
+				if(s.contains(p[i]))
+					continue;
+
+				s = ball(p[i]);
+				for(std::size_t j=0; j<i; ++j)
+				{
+					if(s.contains(p[j]))
+						continue;
+
+					s = ball(p[i], p[j]);
+					for(std::size_t k=0; k<j; ++k)
+					{
+						if(s.contains(p[k]))
+							continue;
+
+						s = ball(p[i], p[j], p[k]);
+						for(std::size_t l=0; l<k; ++l)
+						{
+							if(!s.contains(p[l]))
+								s = ball(p[i], p[j], p[k], p[l]);
+						}
+					}
+				}
+			}
+			return s;
+		}
+
+		template<typename T>
+		Imath::Sphere3<T> toSphere(const Ball& b)
+		{
+			if(b.r2 < 0.0)
+				return Imath::Sphere3<T>(Imath::Vec3<T>(T(0)), T(0));
+
+			// padded by a few ulps, so no point tests as outside in T's arithmetic either
+			const Imath::Vec3<T> c(T(b.c.x), T(b.c.y), T(b.c.z));
+			const double r = std::sqrt(b.r2) + (toDouble(c) - b.c).length();
+			return Imath::Sphere3<T>(c, T(r * (1.0 + 4.0 * std::numeric_limits<T>::epsilon())));
+		}
+	}
+
+
+	/*
+	 * The smallest sphere enclosing n points, by Welzl's algorithm over a copy of them in
+	 * double, shuffled by a fixed permutation (so the result is deterministic). A sphere
+	 * of radius 0 at the origin if n is 0.
+	 */
+	template<typename T>
+	Imath::Sphere3<T> minimalSphere(const Imath::Vec3<T>* points, std::size_t n)
+	{
+		std::vector<Imath::V3d> p(n);
+		for(std::size_t i=0; i<n; ++i)
+			p[i] = detail::toDouble(points[i]);
+
+		// a fixed shuffle, by a linear congruential generator
+		unsigned long long state = 0x9e3779b97f4a7c15ULL;
+		for(std::size_t i=n; i>1; --i)
+		{
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			std::swap(p[i-1], p[std::size_t((state >> 33) % i)]);
+		}
+
+		return detail::toSphere<T>(detail::welzl(p));
+	}
+
+	/*
+	 * Ritter's bounding sphere: the sphere on two far apart points (the furthest from the
+	 * furthest from the first), grown to take in each point outside it. Linear, but
+	 * typically 5-20% larger than the minimal sphere.
+	 */
+	template<typename T>
+	Imath::Sphere3<T> ritterSphere(const Imath::Vec3<T>* points, std::size_t n)
+	{
+		if(!n)
+			return detail::toSphere<T>(detail::Ball());
+
+		std::size_t y = 0, z = 0;
+		double d = -1.0;
+		const Imath::V3d x = detail::toDouble(points[0]);
+		for(std::size_t i=0; i<n; ++i)
+		{
+			const double di = (detail::toDouble(points[i]) - x).length2();
+			if(di > d) { d = di; y = i; }
+		}
+		d = -1.0;
+		for(std::size_t i=0; i<n; ++i)
+		{
+			const double di = (detail::toDouble(points[i]) - detail::toDouble(points[y])).length2();
+			if(di > d) { d = di; z = i; }
+		}
+
+		detail::Ball s = detail::ball(detail::toDouble(points[y]), detail::toDouble(points[z]));
+		double r = std::sqrt(s.r2);
+		for(std::size_t i=0; i<n; ++i)
+		{
+			const Imath::V3d p = detail::toDouble(points[i]);
+			const double dist = (p - s.c).length();
+			if(dist > r)
+			{
+				// the smallest sphere holding the old one and p
+				const double nr = (r + dist) * 0.5;
+				s.c += (p - s.c) * ((nr - r) / dist);
+				r = nr;
+			}
+		}
+		s.r2 = r * r;
+		return detail::toSphere<T>(s);
+	}
+
+	template<typename T>
+	Imath::Sphere3<T> boundingSphere(const Imath::Vec3<T>* points, std::size_t n, SphereFit fit) {
+		return (fit == ExactFit)? minimalSphere(points, n) : ritterSphere(points, n);
+	}
+
+
+	namespace detail
+	{
+		template<typename T>
+		struct SegmentSphereTask
+		{
+			SegmentSphereTask(const Imath::Vec3<T>* points, const int* offsets, SphereFit fit,
+				Imath::Sphere3<T>* spheres)
+			:	m_points(points), m_offsets(offsets), m_fit(fit), m_spheres(spheres) {}
+
+			void operator()(std::size_t begin, std::size_t end, int) const
+			{
+				for(std::size_t i=begin; i<end; ++i)
+				{
+					m_spheres[i] = boundingSphere(m_points + m_offsets[i],
+						std::size_t(m_offsets[i+1] - m_offsets[i]), m_fit);
+				}
+			}
+
+			const Imath::Vec3<T>* m_points;
+			const int* m_offsets;
+			SphereFit m_fit;
+			Imath::Sphere3<T>* m_spheres;
+		};
+
+		template<typename T>
+		struct RaySphereTask
+		{
+			RaySphereTask(const Imath::Vec3<T>* origins, const Imath::Vec3<T>* dirs, std::size_t rayStep,
+				const Imath::Vec3<T>* centers, const T* radii, std::size_t sphereStep,
+				T* t, Imath::Vec3<T>* p, int* hit, std::size_t* hits)
+			:	m_origins(origins), m_dirs(dirs), m_rayStep(rayStep), m_centers(centers), m_radii(radii),
+				m_sphereStep(sphereStep), m_t(t), m_p(p), m_hit(hit), m_hits(hits) {}
+
+			void operator()(std::size_t begin, std::size_t end, int piece) const
+			{
+				m_hits[piece] = intersectSpheres(m_origins + begin*m_rayStep, m_dirs + begin*m_rayStep,
+					m_rayStep, m_centers + begin*m_sphereStep, m_radii + begin*m_sphereStep, m_sphereStep,
+					end-begin, m_t + begin, m_p? m_p + begin : 0, m_hit + begin);
+			}
+
+			const Imath::Vec3<T>* m_origins;
+			const Imath::Vec3<T>* m_dirs;
+			std::size_t m_rayStep;
+			const Imath::Vec3<T>* m_centers;
+			const T* m_radii;
+			std::size_t m_sphereStep;
+			T* m_t;
+			Imath::Vec3<T>* m_p;
+			int* m_hit;
+			std::size_t* m_hits;
+		};
+	}
+
+	// a sphere for each of 'count' objects, in parallel: object i's points are
+	// points[offsets[i]] to points[offsets[i+1]-1], so offsets holds count+1 ascending entries
+	template<typename T>
+	void boundingSpheres(const Imath::Vec3<T>* points, const int* offsets, std::size_t count,
+		SphereFit fit, Imath::Sphere3<T>* spheres)
+	{
+		parallelFor(count, detail::SegmentSphereTask<T>(points, offsets, fit, spheres));
+	}
+
+	// intersectSpheres (see intersect.hpp) in parallel, for large batches of rays or spheres
+	template<typename T>
+	std::size_t intersectSpheresParallel(const Imath::Vec3<T>* origins, const Imath::Vec3<T>* dirs,
+		std::size_t rayStep, const Imath::Vec3<T>* centers, const T* radii, std::size_t sphereStep,
+		std::size_t n, T* t, Imath::Vec3<T>* p, int* hit)
+	{
+		std::vector<std::size_t> hits(threadCount(), 0);
+		parallelFor(n, static_cast<int>(hits.size()), detail::RaySphereTask<T>(origins, dirs, rayStep,
+			centers, radii, sphereStep, t, p, hit, &hits[0]));
+
+		std::size_t total = 0;
+		for(std::size_t i=0; i<hits.size(); ++i)
+			total += hits[i];
+		return total;
+	}
+
+	// the index of the nearest hit - the smallest t[i] where hit[i] is set, the first on a
+	// tie - or -1 if there are none. Picks with the output of intersectSpheres.
+	template<typename T>
+	long nearestHit(const T* t, const int* hit, std::size_t n)
+	{
+		long nearest = -1;
+		for(std::size_t i=0; i<n; ++i)
+		{
+			if(hit[i] && ((nearest < 0) || (t[i] < t[nearest])))
+				nearest = static_cast<long>(i);
+		}
+		return nearest;
+	}
+
+} }
+
+#endif
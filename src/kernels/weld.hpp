@@ -0,0 +1,187 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_KERNELS_WELD__H_
+#define _PIMATH_KERNELS_WELD__H_
+
+#include <ImathVec.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+
+namespace pimath { namespace kernels
+{
+	namespace detail
+	{
+		// the cells of a quantized grid, hashed with open addressing; each cell holds the
+		// head of a list of the unique vertices in it
+		class WeldTable
+		{
+		public:
+
+			WeldTable(std::size_t n)
+			{
+				std::size_t size = 16;
+				while(size < 2*n)
+					size *= 2;
+				m_mask = size - 1;
+				Slot empty = { Imath::V3i(0), -1 };
+				m_slots.assign(size, empty);
+			}
+
+			// the head of cell c's list, or -1
+			int head(const Imath::V3i& c) const
+			{
+				for(std::size_t i=hash(c);; i=(i+1) & m_mask)
+				{
+					const Slot& slot = m_slots[i];
+					if((slot.head < 0) || (slot.cell == c))
+						return slot.head;
+				}
+			}
+
+			// makes v the head of cell c's list, returning the previous head
+			int push(const Imath::V3i& c, int v)
+			{
+				std::size_t i = hash(c);
+				while((m_slots[i].head >= 0) && (m_slots[i].cell != c))
+					i = (i+1) & m_mask;
+
+				Slot& slot = m_slots[i];
+				const int previous = slot.head;
+				slot.cell = c;
+				slot.head = v;
+				return previous;
+			}
+
+		private:
+
+			std::size_t hash(const Imath::V3i& c) const
+			{
+				return ((unsigned(c.x) * 73856093u) ^ (unsigned(c.y) * 19349663u)
+					^ (unsigned(c.z) * 83492791u)) & m_mask;
+			}
+
+			struct Slot
+			{
+				Imath::V3i cell;
+				int head;
+			};
+
+			std::size_t m_mask;
+			std::vector<Slot> m_slots;
+		};
+
+		template<typename T>
+		inline int weldCell(T x)
+		{
+			const T limit = T(1 << 30);
+			x = std::floor(x);
+			return (x < -limit)? -(1 << 30) : (x > limit)? (1 << 30) : static_cast<int>(x);
+		}
+	}
+
+
+	/*
+	 * Welds n vertices: each vertex whose position is within 'tolerance' of an earlier
+	 * unique vertex's (per component, as Vec3.equalWithAbsError) - and whose optional
+	 * normal and uv are within their own tolerances of that vertex's - is merged into it.
+	 * remap[i] is the unique vertex vertex i became, and first[k] is the input vertex
+	 * which unique vertex k keeps, in input order; both need room for n entries. Returns
+	 * the number of unique vertices.
+	 *
+	 * Positions are quantized into cells eight times the tolerance across, so each vertex
+	 * is only compared with those in the cells its tolerance box overlaps (usually one or
+	 * two, at most eight).
+	 * Merges aren't transitive: a vertex joins the first match found, and never chains
+	 * unique vertices together.
+	 */
+	template<typename T>
+	std::size_t weld(const Imath::Vec3<T>* points, std::size_t n, T tolerance, int* remap,
+		int* first, const Imath::Vec3<T>* normals = 0, T normalTolerance = T(0),
+		const Imath::Vec2<T>* uvs = 0, T uvTolerance = T(0))
+	{
+		typedef Imath::Vec3<T> vec_type;
+
+		tolerance = std::max(tolerance, T(0));
+		const T scale = (tolerance > T(0))? T(1) / (tolerance * T(8)) : T(1);
+
+		detail::WeldTable table(n);
+		std::vector<int> next;
+		next.reserve(n);
+		std::size_t unique = 0;
+
+		for(std::size_t i=0; i<n; ++i)
+		{
+			const vec_type& p = points[i];
+			const vec_type lo = (p - vec_type(tolerance)) * scale;
+			const vec_type hi = (p + vec_type(tolerance)) * scale;
+			const Imath::V3i clo(detail::weldCell(lo.x), detail::weldCell(lo.y), detail::weldCell(lo.z));
+			const Imath::V3i chi(detail::weldCell(hi.x), detail::weldCell(hi.y), detail::weldCell(hi.z));
+
+			int match = -1;
+			for(int z=clo.z; (z<=chi.z) && (match<0); ++z)
+			{
+				for(int y=clo.y; (y<=chi.y) && (match<0); ++y)
+				{
+					for(int x=clo.x; (x<=chi.x) && (match<0); ++x)
+					{
+						for(int k=table.head(Imath::V3i(x, y, z)); k>=0; k=next[k])
+						{
+							const int j = first[k];
+							if(p.equalWithAbsError(points[j], tolerance)
+								&& (!normals || normals[i].equalWithAbsError(normals[j], normalTolerance))
+								&& (!uvs || uvs[i].equalWithAbsError(uvs[j], uvTolerance)))
+							{
+								match = k;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			if(match < 0)
+			{
+				const vec_type c = p * scale;
+				match = static_cast<int>(unique++);
+				first[match] = static_cast<int>(i);
+				next.push_back(table.push(Imath::V3i(detail::weldCell(c.x),
+					detail::weldCell(c.y), detail::weldCell(c.z)), match));
+			}
+			remap[i] = match;
+		}
+
+		return unique;
+	}
+
+} }
+
+#endif
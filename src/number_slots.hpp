@@ -0,0 +1,292 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_NUMBER_SLOTS__H_
+#define _PIMATH_NUMBER_SLOTS__H_
+
+#include <boost/python.hpp>
+#include <boost/mpl/bool.hpp>
+#include "util.h"
+
+
+/*
+ * Operators bound with 'bp::self + bp::self' etc go through boost.python's overload
+ * resolution on every call. If pimath is built with PIMATH_NUMBER_SLOTS (enable_number_slots
+ * in setup.py), bindNumberSlots replaces the class's nb_add, nb_subtract, nb_multiply,
+ * nb_true_divide (nb_divide on python 2), nb_negative and the in-place slots with C
+ * functions handling the common cases directly:
+ *
+ * - both operands exactly of the bound type;
+ * - the bound type and an exact python float or int, for multiply and divide.
+ *
+ * Anything else - mixed types, subclasses, scalar on the left - goes to the slot the class
+ * had before, so behaviour is unchanged. Ops says which of the operations the class binds;
+ * only those are replaced. Call bindNumberSlots after all operators have been bound.
+ */
+
+#if PY_MAJOR_VERSION >= 3
+#define PIMATH_NB_DIVIDE 			nb_true_divide
+#define PIMATH_NB_INPLACE_DIVIDE 	nb_inplace_true_divide
+#else
+#define PIMATH_NB_DIVIDE 			nb_divide
+#define PIMATH_NB_INPLACE_DIVIDE 	nb_inplace_divide
+#endif
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	enum NumberOps
+	{
+		AddOp 		= 1,
+		SubtractOp 	= 2,
+		MultiplyOp 	= 4,	// self * self
+		DivideOp 	= 8,	// self / self
+		ScaleOp 	= 16,	// self * scalar, self / scalar
+		NegateOp 	= 32
+	};
+
+
+	template<typename T, typename S, int Ops>
+	struct NumberSlots
+	{
+		typedef T value_type;
+		typedef S scalar_type;
+
+		// only operations in Ops are instantiated
+		typedef boost::mpl::bool_<(Ops & MultiplyOp) != 0> 	has_multiply;
+		typedef boost::mpl::bool_<(Ops & DivideOp) != 0> 	has_divide;
+		typedef boost::mpl::bool_<(Ops & ScaleOp) != 0> 	has_scale;
+
+		template<typename U> static T mul(const T& x, const U& y, boost::mpl::true_) { return x * y; }
+		template<typename U> static T div(const T& x, const U& y, boost::mpl::true_) { return x / y; }
+		template<typename U> static void imul(T& x, const U& y, boost::mpl::true_) { x *= y; }
+		template<typename U> static void idiv(T& x, const U& y, boost::mpl::true_) { x /= y; }
+		template<typename U> static T mul(const T& x, const U&, boost::mpl::false_) { return x; }
+		template<typename U> static T div(const T& x, const U&, boost::mpl::false_) { return x; }
+		template<typename U> static void imul(T&, const U&, boost::mpl::false_) {}
+		template<typename U> static void idiv(T&, const U&, boost::mpl::false_) {}
+
+		static PyTypeObject* 	s_type;
+		static PyNumberMethods 	s_original;
+
+		// the held T, if o is exactly of the bound type
+		static T* get(PyObject* o)
+		{
+			if(Py_TYPE(o) != s_type)
+				return 0;
+
+			bp::objects::instance<>* inst = reinterpret_cast<bp::objects::instance<>*>(o);
+			return (inst->objects)?
+				static_cast<T*>(inst->objects->holds(bp::type_id<T>(), false)) : 0;
+		}
+
+		static PyObject* result(const T& value)
+		{
+			try {
+				return toPython(value);
+			}
+			catch(const bp::error_already_set&) {
+				return NULL;
+			}
+		}
+
+		static PyObject* self(PyObject* o)
+		{
+			Py_INCREF(o);
+			return o;
+		}
+
+		static PyObject* fallback(binaryfunc f, PyObject* a, PyObject* b)
+		{
+			if(f)
+				return f(a, b);
+			Py_INCREF(Py_NotImplemented);
+			return Py_NotImplemented;
+		}
+
+		static PyObject* add(PyObject* a, PyObject* b)
+		{
+			T *x = get(a), *y = get(b);
+			return (x && y)? result(*x + *y) : fallback(s_original.nb_add, a, b);
+		}
+
+		static PyObject* subtract(PyObject* a, PyObject* b)
+		{
+			T *x = get(a), *y = get(b);
+			return (x && y)? result(*x - *y) : fallback(s_original.nb_subtract, a, b);
+		}
+
+		static PyObject* multiply(PyObject* a, PyObject* b)
+		{
+			if(T* x = get(a))
+			{
+				S s;
+				T* y = get(b);
+				if((Ops & MultiplyOp) && y)
+					return result(mul(*x, *y, has_multiply()));
+				if((Ops & ScaleOp) && !y && fromPython(b, s))
+					return result(mul(*x, s, has_scale()));
+			}
+			return fallback(s_original.nb_multiply, a, b);
+		}
+
+		static PyObject* divide(PyObject* a, PyObject* b)
+		{
+			if(T* x = get(a))
+			{
+				S s;
+				T* y = get(b);
+				if((Ops & DivideOp) && y)
+					return result(div(*x, *y, has_divide()));
+				if((Ops & ScaleOp) && !y && fromPython(b, s))
+					return result(div(*x, s, has_scale()));
+			}
+			return fallback(s_original.PIMATH_NB_DIVIDE, a, b);
+		}
+
+		static PyObject* negative(PyObject* a)
+		{
+			if(T* x = get(a))
+				return result(-*x);
+			return s_original.nb_negative(a);
+		}
+
+		static PyObject* inplaceAdd(PyObject* a, PyObject* b)
+		{
+			T *x = get(a), *y = get(b);
+			if(x && y)
+			{
+				*x += *y;
+				return self(a);
+			}
+			return fallback(s_original.nb_inplace_add, a, b);
+		}
+
+		static PyObject* inplaceSubtract(PyObject* a, PyObject* b)
+		{
+			T *x = get(a), *y = get(b);
+			if(x && y)
+			{
+				*x -= *y;
+				return self(a);
+			}
+			return fallback(s_original.nb_inplace_subtract, a, b);
+		}
+
+		static PyObject* inplaceMultiply(PyObject* a, PyObject* b)
+		{
+			if(T* x = get(a))
+			{
+				S s;
+				T* y = get(b);
+				if((Ops & MultiplyOp) && y)
+				{
+					imul(*x, *y, has_multiply());
+					return self(a);
+				}
+				if((Ops & ScaleOp) && !y && fromPython(b, s))
+				{
+					imul(*x, s, has_scale());
+					return self(a);
+				}
+			}
+			return fallback(s_original.nb_inplace_multiply, a, b);
+		}
+
+		static PyObject* inplaceDivide(PyObject* a, PyObject* b)
+		{
+			if(T* x = get(a))
+			{
+				S s;
+				T* y = get(b);
+				if((Ops & DivideOp) && y)
+				{
+					idiv(*x, *y, has_divide());
+					return self(a);
+				}
+				if((Ops & ScaleOp) && !y && fromPython(b, s))
+				{
+					idiv(*x, s, has_scale());
+					return self(a);
+				}
+			}
+			return fallback(s_original.PIMATH_NB_INPLACE_DIVIDE, a, b);
+		}
+
+		static void install(PyTypeObject* type)
+		{
+			PyNumberMethods* nb = type->tp_as_number;
+			s_type = type;
+			s_original = *nb;
+
+			if(Ops & AddOp)
+			{
+				nb->nb_add = add;
+				nb->nb_inplace_add = inplaceAdd;
+			}
+			if(Ops & SubtractOp)
+			{
+				nb->nb_subtract = subtract;
+				nb->nb_inplace_subtract = inplaceSubtract;
+			}
+			if(Ops & (MultiplyOp|ScaleOp))
+			{
+				nb->nb_multiply = multiply;
+				nb->nb_inplace_multiply = inplaceMultiply;
+			}
+			if(Ops & (DivideOp|ScaleOp))
+			{
+				nb->PIMATH_NB_DIVIDE = divide;
+				nb->PIMATH_NB_INPLACE_DIVIDE = inplaceDivide;
+			}
+			if(Ops & NegateOp)
+				nb->nb_negative = negative;
+
+			PyType_Modified(type);
+		}
+	};
+
+	template<typename T, typename S, int Ops>
+	PyTypeObject* NumberSlots<T,S,Ops>::s_type = 0;
+
+	template<typename T, typename S, int Ops>
+	PyNumberMethods NumberSlots<T,S,Ops>::s_original;
+
+
+	template<typename Slots, typename BpClass>
+	void bindNumberSlots(BpClass& cl)
+	{
+#ifdef PIMATH_NUMBER_SLOTS
+		Slots::install(reinterpret_cast<PyTypeObject*>(cl.ptr()));
+#endif
+	}
+
+}
+
+#endif
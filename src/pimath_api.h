@@ -0,0 +1,110 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_API__H_
+#define _PIMATH_API__H_
+
+/*
+ * The native API which pimath exports as the capsule 'pimath._C_API', for other
+ * extension modules to use pimath objects without going through python. Include this
+ * header (it needs only Python.h), then in your module init:
+ *
+ *     const PimathCAPI* pimath = pimath_import_api();
+ *     if(!pimath) return NULL;
+ *
+ * check(obj, type) 		1 if obj is an instance (or subclass) of the given type, else 0
+ * data(obj, type) 			pointer to the Imath value held by obj - eg an Imath::M44d* for
+ * 							PIMATH_M44d - or NULL with TypeError set. The pointer stays
+ * 							valid for as long as obj is alive.
+ * fromValue(type, value) 	new pimath object holding a copy of *value, or NULL on error
+ * v3fArrayData(obj, &n) 	the points of a V3fArray as n x y z triples, or NULL with
+ * 							TypeError set if obj isn't one. An empty array gives NULL
+ * 							and n = 0 with no error set. The pointer stays valid while
+ * 							obj is alive and isn't resized.
+ *
+ * The bulk kernels work on float arrays laid out as Imath's (V3f is 3 floats, M44f is 16
+ * floats in row order, half is 16 bits) and use the SIMD level pimath selected. Only
+ * they can be called without the GIL; check, data, fromValue and v3fArrayData all need
+ * it held. To work on a V3fArray's points without the GIL, get its data first, then
+ * release the GIL around the kernel calls.
+ */
+
+#include <Python.h>
+#include <stddef.h>
+
+#define PIMATH_API_VERSION 		1
+#define PIMATH_API_CAPSULE 		"pimath._C_API"
+
+
+enum PimathType
+{
+	PIMATH_V2i, PIMATH_V2f, PIMATH_V2d,
+	PIMATH_V3i, PIMATH_V3f, PIMATH_V3d,
+	PIMATH_V4i, PIMATH_V4f, PIMATH_V4d,
+	PIMATH_M33f, PIMATH_M33d,
+	PIMATH_M44f, PIMATH_M44d,
+	PIMATH_Quatf, PIMATH_Quatd,
+	PIMATH_Box3f, PIMATH_Box3d,
+	PIMATH_C3f, PIMATH_C4f,
+	PIMATH_NUM_TYPES
+};
+
+
+typedef struct
+{
+	int version;
+
+	int 		(*check)(PyObject* obj, int type);
+	void* 		(*data)(PyObject* obj, int type);
+	PyObject* 	(*fromValue)(int type, const void* value);
+	float* 		(*v3fArrayData)(PyObject* obj, size_t* n);
+
+	/* see kernels/simd.hpp */
+	void (*transformPoints)(const float* m, const float* src, float* dst, size_t n);
+	void (*bounds)(const float* p, size_t n, float* min, float* max);
+	void (*normalize)(float* p, size_t n);
+	void (*halfToFloat)(const unsigned short* src, float* dst, size_t n, float scale);
+	void (*floatToHalf)(const float* src, unsigned short* dst, size_t n, float scale);
+	const char* (*simdLevel)(void);
+
+} PimathCAPI;
+
+
+/* imports pimath and returns its api, or NULL with an exception set */
+static const PimathCAPI* pimath_import_api(void)
+{
+	const PimathCAPI* api = (const PimathCAPI*) PyCapsule_Import(PIMATH_API_CAPSULE, 0);
+	if(api && (api->version < PIMATH_API_VERSION))
+	{
+		PyErr_SetString(PyExc_ImportError, "pimath is older than the pimath_api.h in use.");
+		return NULL;
+	}
+	return api;
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*******************************************************************************
+Copyright (c) 2011, Dr. D. Studios
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or other
+materials provided with the distribution.
+Neither the name of the Dr. D. Studios nor the names of its contributors may be
+used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _PIMATH_SEQUENCE_SLOTS__H_
+#define _PIMATH_SEQUENCE_SLOTS__H_
+
+#include <boost/python.hpp>
+#include "util.h"
+
+
+/*
+ * Vectors, colors, quats and matrices are iterated and unpacked constantly ('x, y, z = v',
+ * 'tuple(m)'). Without __iter__ python falls back to calling __getitem__ until it raises
+ * IndexError, which goes through the boost.python overload machinery and a C++ throw for
+ * every element, and once more at the end.
+ *
+ * bindSequenceSlots gives a class __len__ and __iter__, and replaces its sq_length,
+ * mp_length, sq_item, mp_subscript and tp_iter slots with native versions. The iterator
+ * ends without raising. mp_subscript only handles plain int indices itself, anything else
+ * (eg a (row, col) tuple on a matrix) goes to the class's own __getitem__ as before.
+ *
+ * Python subclasses use the generic slots, but still get the native iterator via __iter__.
+ */
+
+namespace pimath
+{
+	namespace bp = boost::python;
+
+	// returns a new iterator over item(seq, 0) ... item(seq, len-1)
+	PyObject* newSequenceIterator(PyObject* seq, Py_ssize_t len, ssizeargfunc item);
+
+
+	// item i of a vector-like type, as a python scalar
+	template<typename T>
+	PyObject* scalarItem(const T& self, int i) {
+		return toPython(self[i]);
+	}
+
+
+	template<typename T, int N, PyObject* (*Item)(const T&, int)>
+	struct SequenceSlots
+	{
+		static const char* s_indexError;
+		static binaryfunc s_subscript;		// the class's original mp_subscript
+
+		static Py_ssize_t length(PyObject*) {
+			return N;
+		}
+
+		static PyObject* item(PyObject* self, Py_ssize_t i)
+		{
+			if((i<0) || (i>=N))
+			{
+				PyErr_SetString(PyExc_IndexError, s_indexError);
+				return NULL;
+			}
+
+			const T* p = static_cast<const T*>(bp::converter::get_lvalue_from_python(
+				self, bp::converter::registered<T>::converters));
+			if(!p)
+				return NULL;
+
+			try {
+				return Item(*p, static_cast<int>(i));
+			}
+			catch(const bp::error_already_set&) {
+				return NULL;
+			}
+		}
+
+		static PyObject* subscript(PyObject* self, PyObject* key)
+		{
+#if PY_MAJOR_VERSION < 3
+			if(PyInt_CheckExact(key))
+				return item(self, PyInt_AS_LONG(key));
+#endif
+			if(PyLong_CheckExact(key))
+			{
+				Py_ssize_t i = PyLong_AsSsize_t(key);
+				if((i == -1) && PyErr_Occurred())
+				{
+					PyErr_Clear();
+					PyErr_SetString(PyExc_IndexError, s_indexError);
+					return NULL;
+				}
+				return item(self, i);
+			}
+
+			return s_subscript(self, key);
+		}
+
+		static PyObject* iter(PyObject* self) {
+			return newSequenceIterator(self, N, item);
+		}
+
+		// python-visible __len__ and __iter__
+		static int len(const T&) {
+			return N;
+		}
+
+		static bp::object pyIter(const bp::object& self) {
+			return bp::object(bp::handle<>(iter(self.ptr())));
+		}
+	};
+
+	template<typename T, int N, PyObject* (*Item)(const T&, int)>
+	const char* SequenceSlots<T,N,Item>::s_indexError = "Index out of range.";
+
+	template<typename T, int N, PyObject* (*Item)(const T&, int)>
+	binaryfunc SequenceSlots<T,N,Item>::s_subscript = 0;
+
+
+	// call this after __getitem__ has been bound
+	template<typename Slots, typename BpClass>
+	void bindSequenceSlots(BpClass& cl, const char* indexError)
+	{
+		cl
+		.def("__len__", Slots::len)
+		.def("__iter__", Slots::pyIter)
+		;
+
+		PyTypeObject* type = reinterpret_cast<PyTypeObject*>(cl.ptr());
+		Slots::s_indexError = indexError;
+		if(type->tp_as_mapping->mp_subscript != Slots::subscript)
+			Slots::s_subscript = type->tp_as_mapping->mp_subscript;
+
+		type->tp_as_sequence->sq_length = Slots::length;
+		type->tp_as_sequence->sq_item = Slots::item;
+		type->tp_as_mapping->mp_length = Slots::length;
+		type->tp_as_mapping->mp_subscript = Slots::subscript;
+		type->tp_iter = Slots::iter;
+		PyType_Modified(type);
+	}
+
+}
+
+#endif
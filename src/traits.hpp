@@ -32,6 +32,8 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <ImathVec.h>
 #include <ImathMatrix.h>
 #include <ImathQuat.h>
+#include <ImathColor.h>
+#include <ImathShear.h>
 
 namespace pimath {
 
@@ -43,6 +45,7 @@ namespace pimath {
 	struct imath_traits<Imath::Vec2<T> >
 	{
 		typedef T scalar_type;
+		static const unsigned int _dimensions = 2;
 
 		template<typename S>
 		struct rebind { typedef Imath::Vec2<S> type; };
@@ -53,6 +56,7 @@ namespace pimath {
 	struct imath_traits<Imath::Vec3<T> >
 	{
 		typedef T scalar_type;
+		static const unsigned int _dimensions = 3;
 
 		template<typename S>
 		struct rebind { typedef Imath::Vec3<S> type; };
@@ -63,6 +67,7 @@ namespace pimath {
 	struct imath_traits<Imath::Vec4<T> >
 	{
 		typedef T scalar_type;
+		static const unsigned int _dimensions = 4;
 
 		template<typename S>
 		struct rebind { typedef Imath::Vec4<S> type; };
@@ -102,9 +107,35 @@ namespace pimath {
 	struct imath_traits<Imath::Quat<T> >
 	{
 		typedef T scalar_type;
+
+		template<typename S>
+		struct rebind { typedef Imath::Quat<S> type; };
+	};
+
+
+	template<typename T>
+	struct imath_traits<Imath::Color4<T> >
+	{
+		typedef T scalar_type;
+
+		template<typename S>
+		struct rebind { typedef Imath::Color4<S> type; };
+	};
+
+
+	template<typename T>
+	struct imath_traits<Imath::Shear6<T> >
+	{
+		typedef T scalar_type;
+
+		template<typename S>
+		struct rebind { typedef Imath::Shear6<S> type; };
 	};
 
 
+	template<typename T> const unsigned int imath_traits<Imath::Vec2<T> >::_dimensions;
+	template<typename T> const unsigned int imath_traits<Imath::Vec3<T> >::_dimensions;
+	template<typename T> const unsigned int imath_traits<Imath::Vec4<T> >::_dimensions;
 	template<typename T> const unsigned int imath_traits<Imath::Matrix33<T> >::_rows;
 	template<typename T> const unsigned int imath_traits<Imath::Matrix33<T> >::_columns;
 	template<typename T> const unsigned int imath_traits<Imath::Matrix44<T> >::_rows;
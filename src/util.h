@@ -33,6 +33,7 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <sstream>
 #include <boost/python.hpp>
+#include <boost/python/object/find_instance.hpp>
 #include <boost/utility/enable_if.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/for_each.hpp>
@@ -68,6 +69,206 @@ namespace pimath {
 	}
 
 
+	// Constructs a T held by value in the instance's own storage, as bp::init<> does. Use
+	// this for custom __init__ functions rather than bp::make_constructor, which allocates
+	// the T separately on the heap (and so bypasses the instance pool).
+	template<typename T>
+	void holdValue(PyObject* self, const T& value)
+	{
+		typedef bp::objects::value_holder<T> 			holder_type;
+		typedef bp::objects::instance<holder_type> 		instance_type;
+
+		void* memory = holder_type::allocate(self, offsetof(instance_type, storage), sizeof(holder_type));
+		try {
+			(new (memory) holder_type(self, value))->install(self);
+		}
+		catch(...) {
+			holder_type::deallocate(self, memory);
+			throw;
+		}
+	}
+
+
+	// The T held by a python object, or NULL if it isn't a bound T (or subclass of one)
+	template<typename T>
+	T* heldValue(PyObject* o) {
+		return static_cast<T*>(bp::objects::find_instance_impl(o, bp::type_id<T>()));
+	}
+
+
+	// Scalar to python object, avoiding the converter registry for the builtin types
+	inline PyObject* toPython(float x) 		{ return PyFloat_FromDouble(x); }
+	inline PyObject* toPython(double x) 	{ return PyFloat_FromDouble(x); }
+#if PY_MAJOR_VERSION >= 3
+	inline PyObject* toPython(int x) 			{ return PyLong_FromLong(x); }
+	inline PyObject* toPython(unsigned char x) 	{ return PyLong_FromLong(x); }
+#else
+	inline PyObject* toPython(int x) 			{ return PyInt_FromLong(x); }
+	inline PyObject* toPython(unsigned char x) 	{ return PyInt_FromLong(x); }
+#endif
+
+	// anything else (eg half, or a bound class) goes through its registered converter
+	template<typename T>
+	PyObject* toPython(const T& x) {
+		return bp::incref(bp::object(x).ptr());
+	}
+
+
+	// Python float or int to a floating point scalar, without the converter registry. Only
+	// exact floats and ints are handled; returns false for anything else, which should then
+	// take the generic boost.python path.
+	template<typename S>
+	bool fromPython(PyObject* o, S& value)
+	{
+		if(PyFloat_CheckExact(o))
+		{
+			value = S(PyFloat_AS_DOUBLE(o));
+			return true;
+		}
+#if PY_MAJOR_VERSION < 3
+		if(PyInt_CheckExact(o))
+		{
+			value = S(PyInt_AS_LONG(o));
+			return true;
+		}
+#endif
+		if(PyLong_CheckExact(o))
+		{
+			double d = PyLong_AsDouble(o);
+			if((d == -1.0) && PyErr_Occurred())
+			{
+				PyErr_Clear();
+				return false;
+			}
+			value = S(d);
+			return true;
+		}
+		return false;
+	}
+
+	// integer scalars accept ints only, as boost.python's int converters do
+	inline bool fromPython(PyObject* o, int& value)
+	{
+#if PY_MAJOR_VERSION < 3
+		if(PyInt_CheckExact(o))
+		{
+			long l = PyInt_AS_LONG(o);
+			value = static_cast<int>(l);
+			return (l == value);
+		}
+#endif
+		if(PyLong_CheckExact(o))
+		{
+			int overflow = 0;
+			long l = PyLong_AsLongAndOverflow(o, &overflow);
+			value = static_cast<int>(l);
+			return !overflow && (l == value);
+		}
+		return false;
+	}
+
+	inline bool fromPython(PyObject* o, unsigned char& value)
+	{
+		int i;
+		if(!fromPython(o, i) || (i < 0) || (i > 255))
+			return false;
+		value = static_cast<unsigned char>(i);
+		return true;
+	}
+
+
+	// Releases the GIL for its lifetime, around work which touches no python objects
+	class ReleaseGIL
+	{
+	public:
+		ReleaseGIL():m_state(PyEval_SaveThread()){}
+		~ReleaseGIL() { PyEval_RestoreThread(m_state); }
+
+	private:
+		PyThreadState* m_state;
+	};
+
+
+	/*
+	 * Guards a bound object whose state GIL-free code changes in place, eg a HashGrid3f
+	 * being rebuilt, so that another python thread using it meanwhile gets a RuntimeError
+	 * rather than racing it. 'busy' is a counter the object holds, initially 0. Readers may
+	 * overlap each other; a Writer excludes everything. Construct the guard with the GIL
+	 * held, before any ReleaseGIL, so that it is also released with the GIL held.
+	 */
+	class BusyGuard
+	{
+	public:
+		enum Access { Read, Write };
+
+		BusyGuard(int& busy, Access access)
+		:	m_busy(busy), m_access(access)
+		{
+			if((m_busy < 0) || ((access == Write) && (m_busy > 0)))
+				PIMATH_THROW(PyExc_RuntimeError, "The object is in use by another thread.");
+			m_busy = (access == Write)? -1 : m_busy + 1;
+		}
+
+		~BusyGuard() {
+			m_busy = (m_access == Write)? 0 : m_busy - 1;
+		}
+
+	private:
+		int& 		m_busy;
+		Access 		m_access;
+	};
+
+
+	// Keywords for the out= variants of binary operations, eg V3f.add(a, b, out=c)
+	inline bp::detail::keywords<3> out_args() {
+		return (bp::arg("a"), bp::arg("b"), bp::arg("out")=bp::object());
+	}
+
+
+	// Returns 'value' as a new python object, or writes it into 'out' and returns that
+	// instead if 'out' is not None. This lets hot loops reuse an existing instance.
+	template<typename T>
+	bp::object assignOut(const T& value, const bp::object& out)
+	{
+		if(out.ptr() == Py_None)
+			return bp::object(value);
+
+		T& dst = bp::extract<T&>(out);
+		dst = value;
+		return out;
+	}
+
+
+	// out= variants of the arithmetic operators
+	template<typename T, typename S>
+	struct OutArgOps
+	{
+		static bp::object add(const T& a, const T& b, const bp::object& out) {
+			return assignOut<T>(a + b, out);
+		}
+
+		static bp::object subtract(const T& a, const T& b, const bp::object& out) {
+			return assignOut<T>(a - b, out);
+		}
+
+		static bp::object multiply(const T& a, const T& b, const bp::object& out) {
+			return assignOut<T>(a * b, out);
+		}
+
+		static bp::object multiplyScalar(const T& a, S b, const bp::object& out) {
+			return assignOut<T>(a * b, out);
+		}
+
+		static bp::object divide(const T& a, const T& b, const bp::object& out) {
+			return assignOut<T>(a / b, out);
+		}
+
+		static bp::object divideScalar(const T& a, S b, const bp::object& out) {
+			return assignOut<T>(a / b, out);
+		}
+	};
+
+
 	template<typename T>
 	std::string iostream__str__(const T& self)
 	{
@@ -2,6 +2,9 @@ import unittest
 
 import pimath
 import math
+import os
+import subprocess
+import sys
 
 def near( arr1, arr2, tolerance ):
     if len(arr1) != len(arr2):
@@ -147,6 +150,697 @@ class TestPimath(unittest.TestCase):
 
         assert vec.normalized().value == (1.0, 0.0, 0.0)
 
+    def testOutArgs(self):
+        a = pimath.V3f( 1, 2, 3 )
+        b = pimath.V3f( 4, 5, 6 )
+        c = pimath.V3f()
+        assert pimath.V3f.add( a, b, out=c ) is c
+        assert c.value == (5.0, 7.0, 9.0)
+        pimath.V3f.multiply( a, 2.0, out=c )
+        assert c.value == (2.0, 4.0, 6.0)
+        assert pimath.V3f.subtract( b, a ).value == (3.0, 3.0, 3.0)
+        pimath.V3f.add( a, a, out=a )
+        assert a.value == (2.0, 4.0, 6.0)
+        pimath.V3f( 3, 0, 0 ).normalized( out=c )
+        assert c.value == (1.0, 0.0, 0.0)
+
+        m = pimath.M44f()
+        m.setToScale( pimath.V3f( 2, 2, 2 ) )
+        out = pimath.M44f( 0 )
+        pimath.M44f.multiply( m, m, out=out )
+        assert out[0, 0] == 4.0
+        m.inverse( out=out )
+        assert out[0, 0] == 0.5
+
+        q = pimath.Quatf()
+        qout = pimath.Quatf( 0, 0, 0, 0 )
+        pimath.Quatf.multiply( q, q, out=qout )
+        assert qout.value == q.value
+
+        col = pimath.C4f()
+        pimath.C4f.add( pimath.C4f( 1, 1, 1, 1 ), pimath.C4f( 1, 0, 0, 0 ), out=col )
+        assert col.value == (2.0, 1.0, 1.0, 1.0)
+
+    def testInstancePool(self):
+        pimath.clearInstancePools()
+        v = pimath.V3f( 1, 2, 3 )
+        for i in range( 100 ):
+            v = v + pimath.V3f( 1, 1, 1 )
+        assert v.value == (101.0, 102.0, 103.0)
+        assert pimath.V3f().value == (0.0, 0.0, 0.0)
+        assert pimath.M44f( ((2,0,0,0),(0,2,0,0),(0,0,2,0),(0,0,0,1)) )[0, 0] == 2.0
+
+        stats = pimath.instancePoolStats()
+        assert stats["V3f"]["hits"] > 0
+        assert stats["V3f"]["hitRate"] > 0.5
+        assert "M44f" in stats and "Quatf" in stats
+
+    def testStats(self):
+        pimath.resetStats()
+        v = pimath.V3f( 1, 0, 0 )
+        v.dot( v )
+        v.dot( v )
+        stats = pimath.stats()
+        if not pimath.statsEnabled():
+            # built without PIMATH_STATS: nothing is wrapped or counted
+            assert stats == {}
+            assert type( pimath.V3f.dot ).__name__ != "StatsFunction"
+            return
+
+        assert stats["V3f.dot"]["calls"] == 2
+        assert stats["V3f.dot"]["time"] >= 0.0
+        pimath.resetStats()
+        assert pimath.stats()["V3f.dot"]["calls"] == 0
+
+        # every bound function is counted, including those of lazily registered groups
+        unwrapped = ( "Boost.Python.function", "pimath.Dispatcher",
+                      "builtins.builtin_function_or_method", "builtins.method_descriptor" )
+        def counted( value ):
+            if isinstance( value, staticmethod ):
+                value = value.__func__
+            if isinstance( value, property ):
+                return all( f is None or counted( f ) for f in ( value.fget, value.fset ) )
+            return "%s.%s" % ( type( value ).__module__, type( value ).__name__ ) not in unwrapped
+
+        classes = []
+        for name in pimath.__all__:
+            value = getattr( pimath, name )
+            if isinstance( value, type ):
+                classes.append( value )
+            elif name not in ( "stats", "resetStats", "statsEnabled" ):
+                assert counted( value ), name
+        for cls in classes:
+            for name, value in vars( cls ).items( ):
+                assert counted( value ), cls.__name__ + "." + name
+
+    def testDispatch(self):
+        # repeated calls go through the dispatch cache
+        for i in range( 3 ):
+            assert pimath.extractScaling( pimath.M44f() ).value == (1.0, 1.0, 1.0)
+            assert pimath.extractScaling( pimath.M33d() ).value == (1.0, 1.0)
+            assert len( pimath.extractSHRT( pimath.M44d() ) ) == 4
+            assert pimath.V3f( pimath.V3d( 1, 2, 3 ) ).value == (1.0, 2.0, 3.0)
+            assert pimath.V3f( 1, 2, 3 ) == pimath.V3i( 1, 2, 3 )
+            assert pimath.V3f( 1, 2, 3 ) != pimath.V3d( 1, 2, 4 )
+            assert not ( pimath.V3f() == 5 )
+
+    def testSequence(self):
+        v = pimath.V3f( 1, 2, 3 )
+        x, y, z = v
+        assert (x, y, z) == (1.0, 2.0, 3.0)
+        assert len( v ) == 3
+        assert tuple( v ) == (1.0, 2.0, 3.0)
+        assert v[2] == 3.0
+        try:
+            v[3]
+            assert False
+        except IndexError:
+            pass
+
+        assert tuple( pimath.C3f( 1, 2, 3 ) ) == (1.0, 2.0, 3.0)
+        assert list( pimath.C4f( 1, 2, 3, 4 ) ) == [1.0, 2.0, 3.0, 4.0]
+        assert len( pimath.Quatf() ) == 4
+
+        m = pimath.M33f()
+        rows = list( m )
+        assert len( rows ) == 3
+        assert rows[1].value == (0.0, 1.0, 0.0)
+        assert m[1, 1] == 1.0
+
+    def testNumberSlots(self):
+        # same results whether or not pimath was built with PIMATH_NUMBER_SLOTS
+        a = pimath.V3f( 1, 2, 3 )
+        b = pimath.V3f( 2, 2, 2 )
+        assert (a + b).value == (3.0, 4.0, 5.0)
+        assert (a - b).value == (-1.0, 0.0, 1.0)
+        assert (a * b).value == (2.0, 4.0, 6.0)
+        assert (a / b).value == (0.5, 1.0, 1.5)
+        assert (a * 2).value == (2.0, 4.0, 6.0)
+        assert (a / 2.0).value == (0.5, 1.0, 1.5)
+        assert (-a).value == (-1.0, -2.0, -3.0)
+        assert (pimath.V3i( 1, 2, 3 ) * 2).value == (2, 4, 6)
+
+        c = a
+        c += b
+        assert c is a
+        assert a.value == (3.0, 4.0, 5.0)
+        a *= 2
+        assert a.value == (6.0, 8.0, 10.0)
+
+        m = pimath.M44f( ((2,0,0,0),(0,2,0,0),(0,0,2,0),(0,0,0,1)) )
+        assert (m * m)[0, 0] == 4.0
+        assert (m / 2.0)[0, 0] == 1.0
+        assert (m + m)[3, 3] == 2.0
+        assert (-m)[0, 0] == -2.0
+
+        q = pimath.Quatf()
+        assert (q * q).r == 1.0
+        assert (q + q).r == 2.0
+        assert (q * 3.0).r == 3.0
+
+    def testFastCall(self):
+        a = pimath.V3f( 3, 0, 4 )
+        b = pimath.V3f( 1, 2, 3 )
+        assert a.dot( b ) == 15.0
+        assert a.length() == 5.0
+        assert abs( a.normalized().length() - 1.0 ) < 1e-6
+        assert pimath.V3f( 1, 0, 0 ).cross( pimath.V3f( 0, 1, 0 ) ).value == (0.0, 0.0, 1.0)
+        assert pimath.V2f( 1, 0 ).cross( pimath.V2f( 0, 1 ) ) == 1.0
+
+        # keyword calls take the generic path
+        c = pimath.V3f()
+        assert a.normalized( out=c ) is c
+
+        m = pimath.M44f()
+        m.translate( pimath.V3f( 1, 2, 3 ) )
+        assert m.multVecMatrix( pimath.V3f( 0, 0, 0 ) ).value == (1.0, 2.0, 3.0)
+        assert m.multDirMatrix( pimath.V3f( 1, 0, 0 ) ).value == (1.0, 0.0, 0.0)
+
+        q = pimath.Quatf()
+        assert q.length() == 1.0
+        assert q.rotateVector( b ).value == b.value
+        assert pimath.slerp( q, q, 0.5 ).r == 1.0
+        assert pimath.slerp( pimath.Quatd(), pimath.Quatd(), 0.5 ).r == 1.0
+
+    def testFamilyConversion(self):
+        # cross-type arguments go through one runtime conversion per class family
+        m = pimath.M44f()
+        m.setToTranslation( pimath.V3d( 1, 2, 3 ) )
+        v = m.multVecMatrix( pimath.V3d( 1, 1, 1 ) )
+        assert type( v ) is pimath.V3d
+        assert v.value == (2.0, 3.0, 4.0)
+        assert type( pimath.V3i( 1, 2, 3 ) * pimath.M44d() ) is pimath.V3i
+        assert pimath.M44d( m ).translation().value == (1.0, 2.0, 3.0)
+
+        assert pimath.V4h( pimath.V3i( 1, 2, 3 ) ).value == (1.0, 2.0, 3.0, 1.0)
+        assert pimath.V2i( 1, 2 ) == pimath.V2h( 1, 2 )
+        assert pimath.V2i( 1, 2 ) != pimath.V2f( 1, 2.5 )
+        assert pimath.Quatf( pimath.Quatd() ) == pimath.Quatd()
+        assert pimath.C3f( pimath.V3d( 0.5, 0.25, 1 ) ).value == (0.5, 0.25, 1.0)
+        assert pimath.C4f( pimath.C4h( 0, 0, 0, 1 ) ).value == (0.0, 0.0, 0.0, 1.0)
+
+    def testLazyImport(self):
+        script = ( "import pimath\n"
+            "print( 'M44f' in pimath.__dict__ )\n" )
+        out = subprocess.check_output( [sys.executable, "-c", script] ).decode().split()
+        if sys.version_info >= (3, 7):
+            # groups are only registered on first access
+            assert out[0] == "False"
+            assert "M44f" in pimath.__all__
+            assert "M44f" in dir( pimath )
+
+        assert pimath.vec.V3f is pimath.V3f
+        assert pimath.matrix.M44f is pimath.M44f
+        assert pimath.color.C4f is pimath.C4f
+        assert pimath.random.Rand32 is pimath.Rand32
+        from pimath.geom import Box3f
+        assert Box3f is pimath.Box3f
+        self.assertRaises( AttributeError, getattr, pimath, "NoSuchName" )
+
+        if sys.version_info >= (3, 7):
+            # probing for an unknown name loads nothing, and once everything is loaded the
+            # names each group claims are exactly those bound
+            script = ( "import pimath\n"
+                "print( hasattr( pimath, 'NoSuchName' ) )\n"
+                "print( 'V3f' in pimath.__dict__ )\n"
+                "for group in ( pimath.vec, pimath.matrix, pimath.color, pimath.geom, pimath.random ):\n"
+                "    hasattr( group, 'load' )\n"
+                "public = set( n for n in pimath.__dict__ if not n.startswith( '_' ) )\n"
+                "print( ','.join( sorted( public.symmetric_difference( pimath.__all__ ) ) ) or 'same' )\n" )
+            out = subprocess.check_output( [sys.executable, "-c", script] ).decode().split()
+            assert out == ["False", "False", "same"]
+
+    def testSimd(self):
+        levels = ( "scalar", "sse2", "avx2", "avx512" )
+        assert pimath.simdLevel() in levels
+
+        m = pimath.M44f( 1, 0.5, 0, 0, 0, 2, 0.25, 0, 0.125, 0, 3, 0.01, 4, 5, 6, 1 )
+        pts = [pimath.V3f( i * 0.37 - 5, i * 1.1, 7 - i * 0.23 ) for i in range( 37 )]
+        a = pimath.V3fArray( pts )
+        assert len( a ) == 37
+        a.transform( m )
+        for i in range( len( pts ) ):
+            assert a[i] == m.multVecMatrix( pts[i] )
+        a.normalize( )
+        assert a[-1] == m.multVecMatrix( pts[-1] ).normalized( )
+        b = a.bounds( )
+        assert b.min.x <= a[3].x <= b.max.x
+        self.assertRaises( IndexError, a.__getitem__, 37 )
+
+        # every level must give the same bits as the scalar code
+        script = ( "import pimath\n"
+            "m = pimath.M44f( 1, 0.5, 0, 0, 0, 2, 0.25, 0, 0.125, 0, 3, 0.01, 4, 5, 6, 1 )\n"
+            "a = pimath.V3fArray( [pimath.V3f( i * 0.37 - 5, i * 1.1, 7 - i * 0.23 ) for i in range( 37 )] )\n"
+            "a.transform( m )\n"
+            "print( [a[i].value for i in range( len( a ) )] )\n"
+            "a.normalize( )\n"
+            "print( [a[i].value for i in range( len( a ) )], a.bounds( ).value )\n"
+            "img = pimath.C4fArray( 5, 7 )\n"
+            "for i in range( len( img ) ): img[i] = pimath.C4f( i * 0.1, -i, i * 1e-6, 7e4 )\n"
+            "h = pimath.C4hArray( img, 0.5 )\n"
+            "f = pimath.C4fArray( h, 3 )\n"
+            "print( [f[i].value for i in range( len( f ) )] )\n" )
+        results = set( )
+        for level in levels:
+            env = dict( os.environ, PIMATH_SIMD=level )
+            results.add( subprocess.check_output( [sys.executable, "-c", script], env=env ) )
+        assert len( results ) == 1
+
+    def testVecArray(self):
+        m = pimath.M44f( )
+        m.setToTranslation( pimath.V3f( 1, 2, 3 ) )
+        m.scale( pimath.V3f( 2, 2, 2 ) )
+        a = pimath.V3fArray( [pimath.V3f( 1, 0, 0 ), pimath.V3f( 0, 1, 0 )] )
+        a.transformDirs( m )
+        assert a[0] == m.multDirMatrix( pimath.V3f( 1, 0, 0 ) )
+        assert a[1] == pimath.V3f( 0, 2, 0 )
+
+        b = pimath.V3fArray( [pimath.V3f( 3, 0, 0 ), pimath.V3f( 0, 4, 2 )] )
+        c = pimath.V3fArray.lerp( a, b, 0.5 )
+        assert c[0] == pimath.V3f( 2.5, 0, 0 )
+        assert c[1] == pimath.V3f( 0, 3, 1 )
+        self.assertRaises( ValueError, pimath.V3fArray.lerp, a, pimath.V3fArray( 3 ), 0.5 )
+        c = pimath.V3fArray.lerp( a, b, pimath.FloatArray( [0, 0.25] ) )
+        assert c[0] == a[0]
+        assert c[1] == pimath.V3f( 0, 2.5, 0.5 )
+        self.assertRaises( ValueError, pimath.V3fArray.lerp, a, b, pimath.FloatArray( 3 ) )
+
+    def testCApi(self):
+        import ctypes
+        getPointer = ctypes.pythonapi.PyCapsule_GetPointer
+        getPointer.restype = ctypes.c_void_p
+        getPointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+
+        obj, floats = ctypes.py_object, ctypes.POINTER( ctypes.c_float )
+        class Api( ctypes.Structure ):
+            _fields_ = [ ("version", ctypes.c_int),
+                ("check", ctypes.PYFUNCTYPE( ctypes.c_int, obj, ctypes.c_int )),
+                ("data", ctypes.PYFUNCTYPE( ctypes.c_void_p, obj, ctypes.c_int )),
+                ("fromValue", ctypes.PYFUNCTYPE( obj, ctypes.c_int, ctypes.c_void_p )),
+                ("v3fArrayData", ctypes.PYFUNCTYPE( floats, obj, ctypes.POINTER( ctypes.c_size_t ) )),
+                ("transformPoints", ctypes.CFUNCTYPE( None, floats, floats, floats, ctypes.c_size_t )),
+                ("bounds", ctypes.CFUNCTYPE( None, floats, ctypes.c_size_t, floats, floats )),
+                ("normalize", ctypes.CFUNCTYPE( None, floats, ctypes.c_size_t )),
+                ("halfToFloat", ctypes.c_void_p),
+                ("floatToHalf", ctypes.c_void_p),
+                ("simdLevel", ctypes.CFUNCTYPE( ctypes.c_char_p )) ]
+
+        V3f, M44d = 4, 12
+        api = Api.from_address( getPointer( pimath._C_API, b"pimath._C_API" ) )
+        assert api.version >= 1
+
+        v = pimath.V3f( 1, 2, 3 )
+        assert api.check( v, V3f ) == 1
+        assert api.check( pimath.V3d( 1, 2, 3 ), V3f ) == 0
+        p = ctypes.cast( api.data( v, V3f ), floats )
+        assert (p[0], p[1], p[2]) == (1.0, 2.0, 3.0)
+        p[1] = 5
+        assert v.y == 5
+        self.assertRaises( TypeError, api.data, v, M44d )
+
+        m = pimath.M44d( )
+        w = api.fromValue( M44d, api.data( m, M44d ) )
+        assert w == m and w is not m
+
+        a = pimath.V3fArray( [v, v] )
+        n = ctypes.c_size_t( )
+        q = api.v3fArrayData( a, ctypes.byref( n ) )
+        assert n.value == 2 and q[4] == 5
+        api.normalize( q, 2 )
+        assert a[1] == v.normalized( )
+        q = api.v3fArrayData( pimath.V3fArray( ), ctypes.byref( n ) )
+        assert n.value == 0 and not q
+        self.assertRaises( TypeError, api.v3fArrayData, v, ctypes.byref( n ) )
+        assert api.simdLevel( ) == pimath.simdLevel( ).encode( )
+
+    def testBulkRandom(self):
+        assert pimath.threadCount( ) >= 1
+        a = pimath.V3fArray.solidSphereRand( 1000, 7 )
+        b = pimath.V3fArray.solidSphereRand( 1000, 7 )
+        assert len( a ) == 1000
+        assert all( a[i] == b[i] for i in range( len( a ) ) )
+        assert all( a[i].length( ) <= 1.0 for i in range( len( a ) ) )
+
+        # results depend on the seed, but not the number of threads
+        c = pimath.V3fArray.solidSphereRand( 1000, 8 )
+        assert any( a[i] != c[i] for i in range( len( a ) ) )
+        threads = pimath.threadCount( )
+        pimath.setThreadCount( 1 )
+        d = pimath.V3fArray.solidSphereRand( 1000, 7 )
+        pimath.setThreadCount( threads )
+        assert all( a[i] == d[i] for i in range( len( a ) ) )
+
+        # the count holds for kernels started from other python threads too
+        import threading
+        pimath.setThreadCount( 2 )
+        seen = [pimath.threadCount( )]
+        t = threading.Thread( target=lambda: seen.append( pimath.threadCount( ) ) )
+        t.start( )
+        t.join( )
+        pimath.setThreadCount( threads )
+        assert seen[0] in ( 1, 2 ) and seen[1] == seen[0]
+
+        h = pimath.V3fArray.hollowSphereRand( 100, 1 )
+        assert all( abs( h[i].length( ) - 1 ) < 1e-5 for i in range( len( h ) ) )
+        assert len( pimath.V3fArray.gaussSphereRand( 10, 1 ) ) == 10
+
+    def testKdTree(self):
+        pts = pimath.V3fArray.solidSphereRand( 500, 3 )
+        tree = pimath.KdTree3f( pts, 4 )
+        assert len( tree ) == 500
+
+        def brute( q ):
+            return sorted( ( (pts[i] - q).length( ), i ) for i in range( len( pts ) ) )
+
+        q = pimath.V3f( 0.1, -0.2, 0.3 )
+        order = brute( q )
+        index, dist = tree.nearest( q )
+        assert index == order[0][1] and abs( dist - order[0][0] ) < 1e-5
+        assert [ i for i, d in tree.knn( q, 5 ) ] == [ i for d, i in order[:5] ]
+        assert sorted( tree.radius( q, 0.3 ) ) == sorted( i for d, i in order if d <= 0.3 )
+
+        queries = pimath.V3fArray( [q, pimath.V3f( 1, 1, 1 )] )
+        indices, dists = pimath.IntArray( 2 ), pimath.FloatArray( 2 )
+        tree.nearest( queries, indices, dists )
+        assert indices[0] == index and indices[1] == brute( queries[1] )[0][1]
+        indices, dists = pimath.IntArray( 6 ), pimath.FloatArray( 6 )
+        tree.knn( queries, 3, indices, dists )
+        assert [ indices[i] for i in range( 3 ) ] == [ i for d, i in order[:3] ]
+        self.assertRaises( ValueError, tree.nearest, queries, pimath.IntArray( 1 ), dists )
+
+        # picking: the ray passes exactly through point 17
+        ray = pimath.Line3f( pts[17] - pimath.V3f( 0, 0, 5 ), pts[17] )
+        assert tree.nearestToRay( ray )[0] == 17
+        assert pimath.KdTree3f( pimath.V3fArray( 0 ) ).nearest( q ) is None
+
+    def testHashGrid(self):
+        pts = pimath.V3fArray.solidSphereRand( 500, 5 )
+        grid = pimath.HashGrid3f( pimath.Box3f( pimath.V3f( -1 ), pimath.V3f( 1 ) ), pimath.V3i( 8 ), pts )
+        assert len( grid ) == 500
+        assert grid.cellSize( ) == pimath.V3f( 0.25 )
+        assert grid.cellOf( pimath.V3f( -1, 0, 0.9 ) ) == pimath.V3i( 0, 4, 7 )
+
+        q = pimath.V3f( 0.1, 0.2, -0.3 )
+        near = [ i for i in range( len( pts ) ) if (pts[i] - q).length( ) <= 0.4 ]
+        assert sorted( grid.radius( q, 0.4 ) ) == near
+        c = grid.cellOf( pts[3] )
+        assert 3 in list( grid.cell( c ) )
+
+        first, second = grid.pairs( 0.1 )
+        found = sorted( zip( first, second ) )
+        assert found == [ (i, j) for i in range( len( pts ) ) for j in range( i + 1, len( pts ) )
+            if (pts[i] - pts[j]).length( ) <= 0.1 ]
+
+        # points outside the bounds are still found
+        grid.build( pimath.V3fArray( [pimath.V3f( 5, 5, 5 ), pimath.V3f( 5.1, 5, 5 )] ) )
+        assert sorted( grid.radius( pimath.V3f( 5, 5, 5 ), 0.2 ) ) == [0, 1]
+
+    def testPointOctree(self):
+        import tempfile
+        fd, path = tempfile.mkstemp( suffix=".oct" )
+        os.close( fd )
+        try:
+            pts = pimath.V3dArray.solidSphereRand( 20000, 11 )
+            w = pimath.PointOctreeWriter( path, pimath.Box3d( pimath.V3d( -1 ), pimath.V3d( 1 ) ), 8, 6 )
+            w.add( pts )
+            w.add( pimath.V3dArray( [pimath.V3d( 5, 0, 0 )] ) )
+            w.close( )
+            assert w.pointCount( ) == 20000 and w.outsideCount( ) == 1
+
+            tree = pimath.PointOctree( path )
+            assert tree.pointCount( ) == 20000 and len( tree ) > 1
+            assert sum( tree.nodePointCount( i ) for i in range( len( tree ) ) ) == 20000
+            for c in tree.nodeChildren( 0 ):
+                assert tree.nodeParent( c ) == 0 and tree.nodeDepth( c ) == 1
+            loaded = [ tree.load( i ) for i in range( len( tree ) ) ]
+            assert sum( len( a ) for a in loaded ) == 20000
+            box = tree.nodeBox( 3 )
+            assert all( box.intersects( loaded[3][j] ) for j in range( len( loaded[3] ) ) )
+            self.assertRaises( IndexError, tree.load, len( tree ) )
+
+            # a camera at (0, 0, 10) looking down -z
+            frustum = pimath.Frustumd( 1, 100, -0.2, 0.2, 0.2, -0.2 )
+            view = pimath.M44d( )
+            view.setToTranslation( pimath.V3d( 0, 0, -10 ) )
+            coarse = tree.select( frustum, view, 1, 1 << 40 )
+            assert list( coarse ) == [0]
+            fine = tree.select( frustum, view, 1e-6, 1 << 40 )
+            assert len( fine ) == len( tree ) and fine[0] == 0
+            budget = tree.select( frustum, view, 1e-6, 5000 )
+            assert sum( tree.nodePointCount( i ) for i in budget ) <= 5000
+            away = pimath.M44d( )
+            away.setToTranslation( pimath.V3d( 50, 0, -10 ) )
+            assert len( tree.select( frustum, away, 1e-6, 1 << 40 ) ) == 0
+
+            # a small memory budget writes the points out in more, smaller chunks
+            w = pimath.PointOctreeWriter( path, pimath.Box3d( pimath.V3d( -1 ), pimath.V3d( 1 ) ), 8, 6, 1000 )
+            w.add( pts )
+            w.close( )
+            tree = pimath.PointOctree( path )
+            assert tree.pointCount( ) == 20000
+            assert sum( len( tree.load( i ) ) for i in range( len( tree ) ) ) == 20000
+        finally:
+            os.remove( path )
+
+    def testWeld(self):
+        V = pimath.V3f
+        pts = pimath.V3fArray( [V( 0, 0, 0 ), V( 1, 0, 0 ), V( 0, 0, 1e-6 ), V( 1, 1e-6, 0 ), V( 0, 1, 0 ), V( 0, 0, 0 )] )
+        remap, unique, normals, uvs = pts.weld( 1e-5 )
+        assert list( remap ) == [0, 1, 0, 1, 2, 0]
+        assert len( unique ) == 3 and unique[1] == V( 1, 0, 0 )
+        assert normals is None and uvs is None
+        assert len( pts.weld( 1e-7 )[1] ) == 5
+
+        # split where the attributes differ, eg a hard edge or a uv seam
+        n = pimath.V3fArray( [V( 0, 0, 1 )] * 5 + [V( 0, 1, 0 )] )
+        uv = pimath.V2fArray( [pimath.V2f( 0, 0 )] * 6 )
+        remap, unique, normals, uvs = pts.weld( 1e-5, n, 1e-3, uv, 1e-3 )
+        assert list( remap ) == [0, 1, 0, 1, 2, 3]
+        assert normals[3] == V( 0, 1, 0 ) and len( uvs ) == 4
+        self.assertRaises( ValueError, pts.weld, 1e-5, pimath.V3fArray( 2 ) )
+
+    def testMeshNormals(self):
+        V = pimath.V3f
+        # a unit square in z=0, and a triangle folded up along its right edge
+        pts = pimath.V3fArray( [V( 0, 0, 0 ), V( 1, 0, 0 ), V( 1, 1, 0 ), V( 0, 1, 0 ), V( 1, 0.5, 1 )] )
+        tris = pimath.IntArray( [0, 1, 2, 0, 2, 3, 1, 4, 2] )
+        faces = pts.faceNormals( tris )
+        assert len( faces ) == 3
+        assert faces[0] == V( 0, 0, 1 ) and faces[1] == V( 0, 0, 1 )
+        assert near( faces[2].value, (-1.0, 0.0, 0.0), 1e-6 )
+
+        area = pts.vertexNormals( tris )
+        angle = pts.vertexNormals( tris, pimath.NormalWeighting.AngleWeighted )
+        assert area[0] == V( 0, 0, 1 ) and area[3] == V( 0, 0, 1 )
+        assert near( area[4].value, (-1.0, 0.0, 0.0), 1e-6 )
+        for n in ( area, angle ):
+            assert all( abs( n[i].length( ) - 1 ) < 1e-6 for i in range( len( n ) ) )
+        # vertex 1's faces have equal areas, but its corner is wider in the flat one
+        assert near( area[1].value, (-math.sqrt( 0.5 ), 0.0, math.sqrt( 0.5 )), 1e-6 )
+        assert angle[1].z > area[1].z
+
+        self.assertRaises( ValueError, pts.faceNormals, pimath.IntArray( [0, 1] ) )
+        self.assertRaises( IndexError, pts.vertexNormals, pimath.IntArray( [0, 1, 5] ) )
+
+    def testPca(self):
+        s, v = pimath.jacobiEigenSolve( pimath.M33d( 2, 1, 0, 1, 2, 0, 0, 0, 5 ) )
+        assert near( s.value, (5.0, 3.0, 1.0), 1e-9 )
+        col = [ row[1] for row in v.value ]
+        assert near( [ abs( c ) for c in col ], (math.sqrt( 0.5 ), math.sqrt( 0.5 ), 0.0), 1e-9 )
+
+        # a grid of points in a box, rotated 30 degrees about z and moved
+        c, sn = math.cos( math.pi / 6 ), math.sin( math.pi / 6 )
+        grid = [ (x * 0.5, y * 0.25, z * 0.125) for x in range( -6, 7 ) for y in range( -4, 5 )
+            for z in range( -2, 3 ) ]
+        pts = pimath.V3fArray( [ pimath.V3f( c*x - sn*y + 10, sn*x + c*y + 20, z + 30 )
+            for x, y, z in grid ] )
+        assert near( pts.mean( ).value, (10.0, 20.0, 30.0), 1e-5 )
+        cov = pts.covariance( ).value
+        assert all( abs( cov[i][j] - cov[j][i] ) < 1e-9 for i in range( 3 ) for j in range( 3 ) )
+
+        frame, half = pts.fitObb( )
+        assert near( half.value, (3.0, 1.0, 0.25), 1e-4 )
+        rows = frame.value
+        assert abs( abs( rows[0][0] * c + rows[0][1] * sn ) - 1 ) < 1e-5
+        assert near( rows[3], (10.0, 20.0, 30.0, 1.0), 1e-4 )
+        assert pimath.V3fArray( 0 ).fitObb( )[1] == pimath.V3f( 0 )
+
+    def testBoundingSpheres(self):
+        V = pimath.V3f
+        pts = pimath.V3fArray( [V( -1, 0, 0 ), V( 1, 0, 0 ), V( 0, 0.5, 0 ), V( 0, 0, 0.2 )] )
+        s = pimath.Sphere3f.fromPoints( pts )
+        assert near( s.center.value, (0.0, 0.0, 0.0), 1e-6 ) and abs( s.radius - 1 ) < 1e-5
+
+        cloud = pimath.V3fArray.solidSphereRand( 2000, 9 )
+        exact = pimath.Sphere3f.fromPoints( cloud )
+        ritter = pimath.Sphere3f.fromPoints( cloud, pimath.SphereFit.RitterFit )
+        assert exact.radius <= 1.0001 and exact.radius <= ritter.radius * 1.00001
+        for sphere in ( exact, ritter ):
+            assert all( (cloud[i] - sphere.center).length( ) <= sphere.radius for i in range( len( cloud ) ) )
+
+        spheres = pimath.Sphere3f.fromPointSegments( cloud, pimath.IntArray( [0, 1000, 1000, 2000] ) )
+        assert len( spheres ) == 3 and spheres[1].radius == 0
+        part = pimath.Sphere3f.fromPoints( pimath.V3fArray( [cloud[i] for i in range( 1000 )] ) )
+        assert spheres[0].center == part.center and spheres[0].radius == part.radius
+        self.assertRaises( ValueError, pimath.Sphere3f.fromPointSegments, cloud, pimath.IntArray( [0, 5000] ) )
+        assert type( pimath.Sphere3d.fromPoints( pimath.V3dArray( [pimath.V3d( 1 )] ) ) ) is pimath.Sphere3d
+
+    def testRaySpheres(self):
+        V = pimath.V3f
+        n = 37
+        origins = pimath.V3fArray.solidSphereRand( n, 3 )
+        dirs = pimath.V3fArray.hollowSphereRand( n, 4 )
+        for i in range( n ):
+            origins[i] = origins[i] * 3
+        sphere = pimath.Sphere3f( V( 0.5, 0, 0 ), 1 )
+
+        hit, t, points = sphere.intersectRays( origins, dirs )
+        assert len( hit ) == n and len( t ) == n and len( points ) == n
+        for i in range( n ):
+            ray = pimath.Line3f( ( origins[i].value, dirs[i].value ) )
+            expected = sphere.intersectT( ray )
+            if expected is None:
+                assert hit[i] == 0 and t[i] == 0
+            else:
+                assert hit[i] == 1 and t[i] == expected and points[i] == ray( expected )
+
+        centers = pimath.V3fArray( [V( 0, 0, 5 ), V( 0, 0, 2 ), V( 3, 0, 2 ), V( 0, 0, -4 )] )
+        radii = pimath.FloatArray( [1, 0.5, 1, 1] )
+        ray = pimath.Line3f( V( 0, 0, 0 ), V( 0, 0, 1 ) )
+        hit, t, points = pimath.Sphere3f.intersectSpheres( centers, radii, ray )
+        assert list( hit[i] for i in range( 4 ) ) == [1, 1, 0, 0]
+        assert t[0] == 4 and t[1] == 1.5 and points[1] == V( 0, 0, 1.5 )
+        index, tNear, point = pimath.Sphere3f.pickSpheres( centers, radii, ray )
+        assert index == 1 and tNear == 1.5 and point == V( 0, 0, 1.5 )
+        assert pimath.Sphere3f.pickSpheres( centers, radii, pimath.Line3f( V( 9, 9, 9 ), V( 9, 9, 10 ) ) ) is None
+
+        pairs = pimath.Sphere3f.intersectPairs( centers, radii,
+            pimath.V3fArray( [V( 0 )] * 4 ), pimath.V3fArray( [V( 0, 0, 1 )] * 4 ) )
+        assert list( pairs[0][i] for i in range( 4 ) ) == [1, 1, 0, 0] and pairs[1][0] == 4
+
+        self.assertRaises( ValueError, sphere.intersectRays, origins, pimath.V3fArray( 2 ) )
+        self.assertRaises( ValueError, pimath.Sphere3f.intersectSpheres, centers, pimath.FloatArray( 2 ), ray )
+        hit, t, points = pimath.Sphere3d( pimath.V3d( 0 ), 1 ).intersectRays(
+            pimath.V3dArray( [pimath.V3d( 0, 0, -3 )] ), pimath.V3dArray( [pimath.V3d( 0, 0, 1 )] ) )
+        assert hit[0] == 1 and t[0] == 2
+
+    def testPlaneArrays(self):
+        V = pimath.V3f
+        plane = pimath.Plane3f( V( 0, 0, 1 ), 1 )
+        points = pimath.V3fArray( [V( 0, 0, 0 ), V( 0, 0, 3 ), V( 2, 0, 1 ), V( 0, 0, 1.05 )] )
+        d = plane.distances( points )
+        assert [d[i] for i in range( 4 )] == [plane.distanceTo( points[i] ) for i in range( 4 )]
+
+        Front, Back, Straddle = pimath.PlaneSide.PlaneFront, pimath.PlaneSide.PlaneBack, pimath.PlaneSide.PlaneStraddle
+        sides = plane.classifyPoints( points )
+        assert [sides[i] for i in range( 4 )] == [Back, Front, Straddle, Front]
+        sides = plane.classifyPoints( points, 0.1 )
+        assert sides[3] == Straddle
+
+        mins = pimath.V3fArray( [V( 0, 0, -1 ), V( 0, 0, 1.5 ), V( 0, 0, 0 ), V( 1 )] )
+        maxs = pimath.V3fArray( [V( 1, 1, 0.5 ), V( 1, 1, 2 ), V( 1, 1, 1 ), V( 0 )] )
+        sides = plane.classifyBoxes( mins, maxs )
+        assert [sides[i] for i in range( 4 )] == [Back, Front, Straddle, Back]
+
+        centers = pimath.V3fArray( [V( 0, 0, 0 ), V( 0, 0, 2 ), V( 0, 0, 3 )] )
+        sides = plane.classifySpheres( centers, pimath.FloatArray( [0.5, 1, 2] ) )
+        assert [sides[i] for i in range( 3 )] == [Back, Straddle, Straddle]
+
+        origins = pimath.V3fArray( [V( 0, 0, 0 ), V( 0, 0, 0 ), V( 3, 0, 4 )] )
+        dirs = pimath.V3fArray( [V( 0, 0, 1 ), V( 1, 0, 0 ), V( 0, 0, 1 )] )
+        hit, t, hitPoints = plane.intersectLines( origins, dirs )
+        assert [hit[i] for i in range( 3 )] == [1, 0, 1]
+        assert t[0] == 1 and t[2] == -3 and hitPoints[2] == V( 3, 0, 1 )
+
+        self.assertRaises( ValueError, plane.classifyBoxes, mins, pimath.V3fArray( 1 ) )
+        self.assertRaises( ValueError, plane.classifySpheres, centers, pimath.FloatArray( 1 ) )
+        dd = pimath.Plane3d( pimath.V3d( 1, 0, 0 ), 2 ).distances( pimath.V3dArray( [pimath.V3d( 5, 0, 0 )] ) )
+        assert type( dd ) is pimath.DoubleArray and dd[0] == 3
+
+    def testClipTriangles(self):
+        V = pimath.V3f
+        soup = pimath.V3fArray( [V( 0, 0, 0 ), V( 1, 0, 0 ), V( 1, 1, 0 ),
+                                 V( 0, 0, 0 ), V( 1, 1, 0 ), V( 0, 1, 0 ),
+                                 V( 5, 5, 5 ), V( 6, 5, 5 ), V( 5, 6, 5 )] )
+
+        def area( points ):
+            return sum( ((points[i+1] - points[i]) % (points[i+2] - points[i])).length( ) / 2
+                        for i in range( 0, len( points ), 3 ) )
+
+        points, sources, weights = soup.clipTriangles( pimath.Box3f( V( -1 ), V( 0.5, 2, 2 ) ) )
+        assert len( points ) == len( weights ) == len( sources ) * 3
+        assert abs( area( points ) - 0.5 ) < 1e-6
+        assert all( points[i].x <= 0.5 for i in range( len( points ) ) )
+        for i in range( len( points ) ):
+            s = sources[i // 3] * 3
+            w = weights[i]
+            expected = soup[s] * w.x + soup[s+1] * w.y + soup[s+2] * w.z
+            assert near( points[i].value, expected.value, 1e-6 )
+
+        points, sources, weights = soup.clipTriangles( [pimath.Plane3f( V( 0, -1, 0 ), -4 )] )
+        assert len( sources ) == 1 and sources[0] == 2 and points[0] == soup[6] and weights[1] == V( 0, 1, 0 )
+        assert len( soup.clipTriangles( pimath.Box3f( ) )[0] ) == 0
+        assert len( soup.clipTriangles( [] )[1] ) == 3
+
+        frustum = pimath.Frustumf( 1, 10, -1, 1, 1, -1 )
+        assert len( soup.clipTriangles( frustum.planes( ) )[0] ) == 0
+        big = pimath.V3fArray( [V( -4, -4, -1.5 ), V( 4, -4, -1.5 ), V( 0, 4, -1.5 )] )
+        points = big.clipTriangles( frustum.planes( ) )[0]
+        assert len( points ) > 3 and all( abs( points[i].x ) <= 1.5001 and abs( points[i].y ) <= 1.5001
+                                         for i in range( len( points ) ) )
+        self.assertRaises( ValueError, pimath.V3fArray( 2 ).clipTriangles, pimath.Box3f( ) )
+
+        # vertices lying on a box face are kept once, without zero-area slivers
+        unit = pimath.Box3f( V( -1 ), V( 1 ) )
+        onFace = pimath.V3fArray( [V( 1, 0, 0 ), V( 0, 0.5, 0 ), V( 2, 1, 0 ),
+                                   V( 1, 0, 0 ), V( 2, 0, 0 ), V( 2, 0.5, 0 ),
+                                   V( 1, 0, 0 ), V( 1, 0.5, 0 ), V( 2, 0.5, 0 )] )
+        points, sources, weights = onFace.clipTriangles( unit )
+        assert len( sources ) == 1 and sources[0] == 0
+        assert points[0] == V( 1, 0, 0 ) and points[1] == V( 0, 0.5, 0 ) and points[2] == V( 1, 0.75, 0 )
+        assert abs( area( points ) - 0.375 ) < 1e-6
+
+        # nearly coincident planes, whose rounding can add more than one vertex per plane
+        planes = [pimath.Plane3f( V( 1, 1e-7 * (i % 5 - 2), 1e-7 * (i % 3 - 1) ).normalized( ), 0.25 )
+                  for i in range( 32 )]
+        fan = pimath.V3fArray( [V( ( i % 7 ) * 0.1 - 0.3, ( i % 11 ) * 0.2 - 1, ( i % 13 ) * 0.15 - 1 )
+                                for i in range( 300 )] )
+        points, sources, weights = fan.clipTriangles( planes )
+        assert len( points ) == len( weights ) == len( sources ) * 3
+        assert all( points[i].x <= 0.2501 for i in range( len( points ) ) )
+
+    def testComponents(self):
+        v = pimath.V4f( 1, 2, 3, 4 )
+        assert (v.x, v.y, v.z, v.w) == (1.0, 2.0, 3.0, 4.0)
+        v.x = 5
+        v.w = 0.5
+        assert v.value == (5.0, 2.0, 3.0, 0.5)
+
+        h = pimath.V3h( 1, 2, 3 )
+        h.z = 0.25
+        assert h.z == 0.25
+
+        i = pimath.V2i( 1, 2 )
+        i.y = 7
+        assert i.y == 7
+
+        c = pimath.C4c( 0, 0, 0, 0 )
+        c.r = 255
+        assert c.r == 255
+        c4 = pimath.C4f( 0, 0, 0, 0 )
+        c4.a = 1.0
+        assert c4.value == (0.0, 0.0, 0.0, 1.0)
+
+        q = pimath.Quatf()
+        q.r = 2.0
+        assert q.r == 2.0
+
+        try:
+            v.x = "a"
+            assert False
+        except TypeError:
+            pass
+
     def testQuat(self):
         self.runQuatTest( pimath.Quatd, pimath.V3d )
         self.runQuatTest( pimath.Quatf, pimath.V3f )
@@ -284,6 +978,57 @@ class TestPimath(unittest.TestCase):
         assert pimath.hsv2rgb( hsv ) == color
         assert pimath.rgb2packed( cls( maxV,maxV,maxV,maxV ) ) == 256*256*256*256-1
 
+    def testColorArray(self):
+        self.runColorArrayTest( pimath.C4fArray, pimath.C4f, 1 )
+        self.runColorArrayTest( pimath.C4hArray, pimath.C4h, 1 )
+        self.runColorArrayTest( pimath.C4cArray, pimath.C4c, 255 )
+
+    def runColorArrayTest(self, cls, color, maxV):
+        for layout in ( pimath.ArrayLayout.InterleavedLayout, pimath.ArrayLayout.PlanarLayout ):
+            img = cls( 4, 3, layout )
+            assert len( img ) == 12
+            assert img.width == 4 and img.height == 3
+            assert img[5] == color( 0, 0, 0, 0 )
+
+            img[1, 2] = color( maxV, maxV, 0, maxV )
+            img[3] = color( maxV, 0, maxV, 0 )
+            assert img[9] == color( maxV, maxV, 0, maxV )
+
+            img.layout = pimath.ArrayLayout.PlanarLayout
+            assert img[9] == color( maxV, maxV, 0, maxV )
+            img.layout = pimath.ArrayLayout.InterleavedLayout
+            assert img[9] == color( maxV, maxV, 0, maxV )
+
+            img.premultiply()
+            assert img[3] == color( 0, 0, 0, 0 )
+            assert img[9] == color( maxV, maxV, 0, maxV )
+
+            img.swizzle( "bgra" )
+            assert img[9] == color( 0, maxV, maxV, maxV )
+
+            bg = cls( 4, 3, layout )
+            bg[0] = color( maxV, maxV, maxV, maxV )
+            comp = img.over( bg )
+            assert comp[0] == color( maxV, maxV, maxV, maxV )
+            assert comp[9] == color( 0, maxV, maxV, maxV )
+
+            img.scaleOffset( pimath.C4f( 0, 0, 0, 0 ), pimath.C4f( 0, 0, 0, maxV ) )
+            assert img[0] == color( 0, 0, 0, maxV )
+
+        img = pimath.C4cArray( 5, 5 )
+        img[0] = pimath.C4c( 255, 0, 51, 255 )
+        imgf = pimath.C4fArray( img, 1.0/255 )
+        assert near( imgf[0].value, ( 1, 0, 0.2, 1 ), 0.001 )
+        assert pimath.C4cArray( imgf, 255 )[0] == img[0]
+        assert pimath.C4cArray( pimath.C4hArray( imgf ), 255 )[0] == img[0]
+
+        # halves round up alike in the vectorised body (pixel 0) and the scalar tail (pixel 24)
+        halves = pimath.C4fArray( 5, 5 )
+        halves[0] = pimath.C4f( 0.5, 1.5, 2.5, 3.5 )
+        halves[24] = pimath.C4f( 0.5, 1.5, 2.5, 3.5 )
+        rounded = pimath.C4cArray( halves, 1 )
+        assert rounded[0] == rounded[24] == pimath.C4c( 1, 2, 3, 4 )
+
     def testFrame(self):
         self.runFrameTest( pimath.V3f, pimath.M44f )
         self.runFrameTest( pimath.V3d, pimath.M44d )
@@ -451,12 +1196,37 @@ class TestPimath(unittest.TestCase):
         self.testMatrix33( )
         self.testVector3( )
         self.testQuat( )
+        self.testOutArgs( )
+        self.testInstancePool( )
+        self.testStats( )
+        self.testDispatch( )
+        self.testSequence( )
+        self.testNumberSlots( )
+        self.testFastCall( )
+        self.testComponents( )
+        self.testFamilyConversion( )
+        self.testLazyImport( )
+        self.testSimd( )
+        self.testVecArray( )
+        self.testCApi( )
+        self.testBulkRandom( )
+        self.testKdTree( )
+        self.testHashGrid( )
+        self.testPointOctree( )
+        self.testWeld( )
+        self.testMeshNormals( )
+        self.testPca( )
+        self.testBoundingSpheres( )
+        self.testRaySpheres( )
+        self.testPlaneArrays( )
+        self.testClipTriangles( )
         self.testPrecision( )
         self.testEuler( )
         self.testBox2( )
         self.testBox3( )
         self.testBoxAlgo( )
         self.testColor( )
+        self.testColorArray( )
         self.testFrustum( )
         self.testInterval( )
         self.testLine( )